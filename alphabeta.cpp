@@ -0,0 +1,210 @@
+#include "alphabeta.h"
+#include <algorithm>
+
+// Action started by a macro move, or ACTION_IDLE for walking
+static uint8_t moveAction(int move) {
+    return move >= MOVE_ATTACK ? static_cast<uint8_t>(ACTION_ATTACK + (move - MOVE_ATTACK)) : static_cast<uint8_t>(ACTION_IDLE);
+}
+
+static bool parrying(uint8_t action) {
+    return action == ACTION_PARRY_LOW || action == ACTION_PARRY_HIGH || action == ACTION_PARRY_MID;
+}
+
+static bool striking(uint8_t action) {
+    return action == ACTION_ATTACK || action == ACTION_STRIKE_LOWHIGH || action == ACTION_STRIKE_HIGHLOW;
+}
+
+void orderMoves(const MatchState& state, int side, int order[MOVE_COUNT]) {
+    const FencerState& self = state.fencers[side];
+    const FencerState& opponent = state.fencers[1 - side];
+    SimRect target = fencerHurtbox(state, 1 - side);
+    SimRect blade = fencerHitbox(state, 1 - side);
+    bool threatened = striking(opponent.action) && simIntersects(blade, fencerHurtbox(state, side));
+
+    int score[MOVE_COUNT];
+    for (int move = 0; move < MOVE_COUNT; ++move) {
+        uint8_t action = moveAction(move);
+        int inputTicks = commandTicks(action, side);
+        if (parrying(action)) {
+            SimRect box = parryBoxAt(action, self.x, SIM_GROUND_Y, side, state.weapon);
+            score[move] = simIntersects(box, blade) ? 300 - inputTicks : 0;
+        } else if (striking(action)) {
+            // Either strike frame counts: the second one is what lands after walking in
+            bool reaches = simIntersects(hitboxAt(action, 0, self.x, SIM_GROUND_Y, side), target) ||
+                           simIntersects(hitboxAt(action, SIM_STRIKE_FRAME_TICKS, self.x, SIM_GROUND_Y, side), target);
+            score[move] = reaches ? 200 - inputTicks : 0;
+        } else if (move == MOVE_RETREAT) {
+            score[move] = threatened ? 100 : 1;
+        } else if (move == MOVE_ADVANCE) {
+            score[move] = 2;
+        } else {
+            score[move] = 3;
+        }
+    }
+
+    for (int move = 0; move < MOVE_COUNT; ++move) order[move] = move;
+    std::stable_sort(order, order + MOVE_COUNT, [&](int a, int b) { return score[a] > score[b]; });
+}
+
+AlphaBetaBot::AlphaBetaBot(int player, const AlphaBetaConfig& config) : config(config), player(player) {
+    this->config.maxDepth = std::clamp(this->config.maxDepth, 1, ALPHABETA_MAX_DEPTH);
+    if (this->config.stepTicks < 1) this->config.stepTicks = 1;
+    reset();
+}
+
+void AlphaBetaBot::reset() {
+    committedMove = MOVE_HOLD;
+    moveTick = config.stepTicks; // Decide on the next update
+}
+
+// Plays one decision step; returns true with the result (the bot's point of view) on a touch
+bool AlphaBetaBot::playStep(MatchState& state, int ownMove, int opponentMove, int& result) const {
+    int player1Move = player == 0 ? ownMove : opponentMove;
+    int player2Move = player == 0 ? opponentMove : ownMove;
+    for (int tick = 0; tick < config.stepTicks; ++tick) {
+        uint8_t events = stepMatch(state, moveInput(player1Move, 0, tick), moveInput(player2Move, 1, tick));
+        if (events & (EVENT_TOUCH_P1 | EVENT_TOUCH_P2)) {
+            bool player1Scored = (events & EVENT_TOUCH_P1) != 0;
+            result = player1Scored == (player == 0) ? 1 : -1;
+            return true;
+        }
+    }
+    return false;
+}
+
+// No touch within the horizon: frame advantage (how much sooner the bot can act again), then a
+// little pressure for closing the distance so a drawn search does not turn into standing still
+int AlphaBetaBot::evaluate(const MatchState& state) const {
+    int busy[2];
+    for (int p = 0; p < 2; ++p) {
+        const FencerState& fencer = state.fencers[p];
+        busy[p] = fencer.action == ACTION_IDLE ? 0 : SIM_ACTION_TICKS - fencer.actionTicks;
+    }
+    return 4 * (busy[1 - player] - busy[player]) - fencerDistance(state) / 32;
+}
+
+// Forced touches from the tablebase, scored like a touch that many steps further down the line.
+// The table is probed with the real state, so the search still sees the held keys and input
+// history that the table's canonical states leave out.
+bool AlphaBetaBot::tablebaseValue(const MatchState& state, int depth, int& value) {
+    TablebaseEntry entry;
+    if (!tablebase || tablebase->header->stepTicks != config.stepTicks || !tablebase->probe(state, player, entry) ||
+        entry.result == TB_DRAW) {
+        return false;
+    }
+    tablebaseHits++;
+    value = (entry.result == TB_WIN ? 1 : -1) * (ALPHABETA_WIN + depth - entry.plies);
+    return true;
+}
+
+int AlphaBetaBot::maxNode(const MatchState& state, int depth, int alpha, int beta) {
+    if (depth == 0) return evaluate(state);
+
+    int order[MOVE_COUNT];
+    orderMoves(state, player, order);
+    int best = -ALPHABETA_WIN * 2;
+    for (int move : order) {
+        int value = minNode(state, move, depth, alpha, beta);
+        if (aborted) return 0;
+        best = std::max(best, value);
+        alpha = std::max(alpha, value);
+        if (alpha >= beta) break;
+    }
+    return best;
+}
+
+// Worst reply to the bot's move; the killer from a sibling is tried right after the ordered favourite
+int AlphaBetaBot::minNode(const MatchState& state, int move, int depth, int alpha, int beta) {
+    // The clock is read every few hundred nodes: a node is well under a microsecond
+    if ((++nodes & 255) == 0 && (std::chrono::steady_clock::now() >= deadline || (cancel && cancel->load(std::memory_order_relaxed)))) {
+        aborted = true;
+        return 0;
+    }
+
+    int order[MOVE_COUNT];
+    orderMoves(state, 1 - player, order);
+    int* killer = std::find(order, order + MOVE_COUNT, killers[depth]);
+    if (killer != order + MOVE_COUNT && killer > order + 1) std::rotate(order + 1, killer, killer + 1);
+
+    int worst = ALPHABETA_WIN * 2;
+    for (int reply : order) {
+        MatchState child = state;
+        int result;
+        int value;
+        if (playStep(child, move, reply, result)) {
+            value = result * (ALPHABETA_WIN + depth);
+        } else if (!tablebaseValue(child, depth, value)) {
+            value = maxNode(child, depth - 1, alpha, beta);
+        }
+        if (aborted) return 0;
+        worst = std::min(worst, value);
+        beta = std::min(beta, value);
+        if (alpha >= beta) {
+            killers[depth] = reply;
+            break;
+        }
+    }
+    return worst;
+}
+
+// Iterative deepening until the deadline. Each finished iteration puts its best move first for the
+// next one, so an unfinished iteration that already searched it can still improve the choice.
+int AlphaBetaBot::decide(const MatchState& state, int& depthReached) {
+    deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(config.budgetMicros);
+    aborted = false;
+    std::fill(killers, killers + ALPHABETA_MAX_DEPTH + 1, MOVE_HOLD);
+
+    int order[MOVE_COUNT];
+    orderMoves(state, player, order);
+    int bestMove = order[0];
+    depthReached = 0;
+
+    for (int depth = 1; depth <= config.maxDepth && !aborted; ++depth) {
+        int alpha = -ALPHABETA_WIN * 2;
+        int iterationMove = order[0];
+        for (int i = 0; i < MOVE_COUNT; ++i) {
+            int value = minNode(state, order[i], depth, alpha, ALPHABETA_WIN * 2);
+            if (aborted) break;
+            if (value > alpha) {
+                alpha = value;
+                iterationMove = order[i];
+            }
+        }
+
+        if (!aborted) {
+            depthReached = depth;
+        } else if (iterationMove == order[0]) {
+            break; // Nothing searched beat the previous best
+        }
+        bestMove = iterationMove;
+        int* best = std::find(order, order + MOVE_COUNT, bestMove);
+        std::rotate(order, best, best + 1);
+        if (alpha >= ALPHABETA_WIN) break; // Forced touch found; deeper searches cannot do better
+    }
+    return bestMove;
+}
+
+int AlphaBetaBot::choose(const MatchState& state) {
+    int move = book && book->header->stepTicks == config.stepTicks ? book->lookup(state, player) : -1;
+    if (move >= 0) {
+        bookHits++;
+    } else {
+        int depth;
+        move = decide(state, depth);
+        depthSum += depth;
+    }
+    return move;
+}
+
+InputWord AlphaBetaBot::play(int move) {
+    if (decisionDue()) {
+        committedMove = move;
+        moveTick = 0;
+        decisions++;
+    }
+    return moveInput(committedMove, player, moveTick++);
+}
+
+InputWord AlphaBetaBot::update(const MatchState& state) {
+    return play(decisionDue() ? choose(state) : committedMove);
+}
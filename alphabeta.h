@@ -0,0 +1,64 @@
+// CPU opponent: iterative-deepening minimax with alpha-beta pruning over the macro moves. Cheaper and
+// more predictable than the MCTS bot: the bot commits to a move, the opponent answers it in the worst
+// way for the bot (as in the solver), and nodes are plain MatchState copies.
+#ifndef ALPHABETA_H
+#define ALPHABETA_H
+
+#include "simulation.h"
+#include "book.h"
+#include "tablebase.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#define ALPHABETA_MAX_DEPTH 16
+#define ALPHABETA_WIN 1000 // Touch values; the remaining depth is added so sooner touches count more
+
+struct AlphaBetaConfig {
+    int budgetMicros = 4000;  // Search time per decision; the deepest finished iteration is played
+    int stepTicks = 10;       // Ticks each macro move is held for, as in the solver
+    int maxDepth = ALPHABETA_MAX_DEPTH; // Decision steps, at most ALPHABETA_MAX_DEPTH
+};
+
+struct AlphaBetaBot {
+    AlphaBetaConfig config;
+    int player;               // 0 or 1
+    const OpeningBook* book = nullptr; // Answers on-book states without searching; searched with the same stepTicks
+    const Tablebase* tablebase = nullptr; // Exact values for close-range leaves of the search
+    const std::atomic<bool>* cancel = nullptr; // Polled with the deadline; a set flag ends the search early
+
+    int committedMove = MOVE_HOLD;
+    int moveTick = 0;         // Ticks of committedMove already played
+    uint64_t nodes = 0;       // Over the whole bout, for the statistics
+    uint64_t decisions = 0;
+    uint64_t depthSum = 0;    // Deepest finished iteration, summed over searched decisions
+    uint64_t bookHits = 0;    // Decisions answered by the book
+    uint64_t tablebaseHits = 0; // Search nodes scored by the tablebase
+
+    AlphaBetaBot(int player, const AlphaBetaConfig& config);
+
+    InputWord update(const MatchState& state); // Call once per tick: searches when a move is due, then returns this tick's keys
+    void reset();                              // Forget the current move, e.g. for a new bout
+    bool decisionDue() const { return moveTick >= config.stepTicks; }
+    int remainingTicks() const { return std::max(config.stepTicks - moveTick, 0); } // Updates before the next decision
+    int choose(const MatchState& state);       // Book answer or search, counted in the statistics
+    InputWord play(int move);                  // Commits to move when a decision is due; this tick's keys
+    int decide(const MatchState& state, int& depthReached);
+
+    // Search state, only valid during decide()
+    std::chrono::steady_clock::time_point deadline;
+    bool aborted = false;
+    int killers[ALPHABETA_MAX_DEPTH + 1]; // Last reply that cut off at each depth
+
+    int maxNode(const MatchState& state, int depth, int alpha, int beta);
+    int minNode(const MatchState& state, int move, int depth, int alpha, int beta);
+    bool playStep(MatchState& state, int ownMove, int opponentMove, int& result) const;
+    bool tablebaseValue(const MatchState& state, int depth, int& value);
+    int evaluate(const MatchState& state) const;
+};
+
+// Orders the macro moves of `side` by their timings against the opponent's current action: parries
+// that meet the incoming blade, then strikes that reach the hurtbox (fastest input first), then walking
+void orderMoves(const MatchState& state, int side, int order[MOVE_COUNT]);
+
+#endif // ALPHABETA_H
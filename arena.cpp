@@ -0,0 +1,509 @@
+#include "mcts.h"
+#include "alphabeta.h"
+#include "speculate.h"
+#include "sandbox.h"
+#include "botplugin.h"
+#include "policy.h"
+#include "behaviortree.h"
+#include "botscript.h"
+#include "lab.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Input source for one side of an arena bout; reset is called before every bout
+struct ArenaPlayer {
+    std::function<InputWord(const MatchState&)> input;
+    std::function<void()> reset;
+};
+
+// Random macro moves held for stepTicks each
+static ArenaPlayer randomPlayer(int player, int stepTicks, SimRandom& rng) {
+    auto move = std::make_shared<int>(MOVE_HOLD);
+    auto tick = std::make_shared<int>(0);
+    return {[=, &rng](const MatchState&) {
+                if (*tick % stepTicks == 0) *move = rng.below(MOVE_COUNT);
+                return moveInput(*move, player, (*tick)++ % stepTicks);
+            },
+            [=]() { *tick = 0; }};
+}
+
+// Plays the bouts and prints the score; player 2 is the bot being measured
+static void playArena(ArenaPlayer players[2], int bouts, int maxTicks, const std::vector<int>& weapons) {
+    int wins[3] = {0, 0, 0};
+    int touches[2] = {0, 0};
+
+    for (int bout = 0; bout < bouts; ++bout) {
+        MatchState state;
+        initMatch(state, static_cast<uint8_t>(weapons[bout % weapons.size()]));
+        players[0].reset();
+        players[1].reset();
+
+        for (int t = 0; t < maxTicks && !state.over; ++t) {
+            InputWord player1Input = players[0].input(state);
+            InputWord player2Input = players[1].input(state);
+            uint8_t events = stepMatch(state, player1Input, player2Input);
+            if (events & EVENT_TOUCH_P1) touches[0]++;
+            if (events & EVENT_TOUCH_P2) touches[1]++;
+        }
+        wins[matchWinner(state)]++;
+        std::cout << "  bout " << bout + 1 << ": " << WEAPON_NAMES[state.weapon] << ", points "
+                  << static_cast<int>(state.points[0]) << "-" << static_cast<int>(state.points[1]) << " after " << state.tick
+                  << " ticks" << std::endl;
+    }
+
+    std::cout << "Player 2 won " << wins[2] << ", player 1 won " << wins[1] << ", draws " << wins[0] << " (touches "
+              << touches[1] << " to " << touches[0] << ")" << std::endl;
+}
+
+// Headless bouts between two budgets, to see how strength scales with compute
+int runMcts(int argc, char* argv[]) {
+    // --level picks the game's difficulty settings; --budget-us/--bot-threads override them
+    MctsConfig config = mctsLevel(intOption(argc, argv, "--level", 2));
+    config.budgetMicros = intOption(argc, argv, "--budget-us", config.budgetMicros);
+    config.threads = intOption(argc, argv, "--bot-threads", config.threads);
+    config.horizon = intOption(argc, argv, "--horizon", config.horizon);
+    int opponentMicros = intOption(argc, argv, "--opponent-us", 0);
+    int bouts = intOption(argc, argv, "--bouts", 4);
+    int maxTicks = intOption(argc, argv, "--max-ticks", SIM_PERIOD_TICKS / 3);
+    std::vector<int> weapons = weaponOption(argc, argv);
+
+    if (weapons.empty()) return 1;
+    if (config.budgetMicros < 0 || opponentMicros < 0 || config.horizon < 1) {
+        std::cerr << "mcts: budgets must not be negative and --horizon must be at least 1" << std::endl;
+        return 1;
+    }
+
+    MctsConfig opponentConfig = config;
+    opponentConfig.budgetMicros = opponentMicros;
+    std::cout << "Player 2: MCTS " << config.budgetMicros << " us/frame on " << config.threads << " threads; player 1: "
+              << (opponentMicros > 0 ? "MCTS " + std::to_string(opponentMicros) + " us/frame" : std::string("random moves"))
+              << std::endl;
+
+    MctsBot bot(1, config);
+    MctsBot opponent(0, opponentConfig);
+    SimRandom rng(1);
+    ArenaPlayer players[2] = {
+        opponentMicros > 0 ? ArenaPlayer{[&](const MatchState& state) { return opponent.update(state); }, [&]() { opponent.reset(); }}
+                           : randomPlayer(0, config.stepTicks, rng),
+        {[&](const MatchState& state) { return bot.update(state); }, [&]() { bot.reset(); }}};
+    playArena(players, bouts, maxTicks, weapons);
+
+    std::cout << "Player 2 search: " << (bot.frames ? bot.iterations / bot.frames : 0) << " iterations per frame, worst overrun "
+              << bot.maxOverrunMicros << " us past the budget" << std::endl;
+    return 0;
+}
+
+// Headless bouts of the alpha-beta bot against random moves or the MCTS bot
+int runAlphaBeta(int argc, char* argv[]) {
+    AlphaBetaConfig config;
+    config.budgetMicros = intOption(argc, argv, "--budget-us", config.budgetMicros);
+    config.maxDepth = intOption(argc, argv, "--max-depth", config.maxDepth);
+    int mctsMicros = intOption(argc, argv, "--mcts-us", 0);
+    int frameMicros = intOption(argc, argv, "--frame-us", 0); // Speculate in the rest of frames this long, as the game does
+    std::string bookPath = stringOption(argc, argv, "--book", "");
+    std::string tablebasePath = stringOption(argc, argv, "--tablebase", "");
+    int bouts = intOption(argc, argv, "--bouts", 4);
+    int maxTicks = intOption(argc, argv, "--max-ticks", SIM_PERIOD_TICKS / 3);
+    std::vector<int> weapons = weaponOption(argc, argv);
+
+    if (weapons.empty()) return 1;
+    if (config.budgetMicros < 0 || mctsMicros < 0 || frameMicros < 0 || config.maxDepth < 1) {
+        std::cerr << "alphabeta: budgets must not be negative and --max-depth must be at least 1" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Player 2: alpha-beta " << config.budgetMicros << " us/decision; player 1: "
+              << (mctsMicros > 0 ? "MCTS " + std::to_string(mctsMicros) + " us/frame" : std::string("random moves"))
+              << (frameMicros > 0 ? ", speculating in " + std::to_string(frameMicros) + " us frames" : std::string()) << std::endl;
+
+    SpeculativeBot speculative(1, config);
+    AlphaBetaBot& bot = speculative.bot;
+    OpeningBook book;
+    if (!bookPath.empty()) {
+        if (!book.open(bookPath)) {
+            std::cerr << "alphabeta: " << bookPath << ": " << book.error << std::endl;
+            return 1;
+        }
+        bot.book = &book;
+    }
+    Tablebase tablebase;
+    if (!tablebasePath.empty()) {
+        if (!tablebase.open(tablebasePath)) {
+            std::cerr << "alphabeta: " << tablebasePath << ": " << tablebase.error << std::endl;
+            return 1;
+        }
+        bot.tablebase = &tablebase;
+    }
+    speculative.attach(bot.book, bot.tablebase);
+    MctsConfig mctsConfig;
+    mctsConfig.budgetMicros = mctsMicros;
+    mctsConfig.threads = 1;
+    MctsBot opponent(0, mctsConfig);
+    SimRandom rng(1);
+    int64_t decisionMicros = 0;
+    int64_t maxDecisionMicros = 0;
+    ArenaPlayer players[2] = {
+        mctsMicros > 0 ? ArenaPlayer{[&](const MatchState& state) { return opponent.update(state); }, [&]() { opponent.reset(); }}
+                       : randomPlayer(0, config.stepTicks, rng),
+        {[&](const MatchState& state) {
+             // Time spent on the main thread per decision, the frame's cost of the bot's reaction
+             if (frameMicros > 0) {
+                 auto frameStart = std::chrono::steady_clock::now();
+                 speculative.speculate(state);
+                 std::this_thread::sleep_until(frameStart + std::chrono::microseconds(frameMicros));
+             }
+             bool deciding = bot.decisionDue();
+             auto start = std::chrono::steady_clock::now();
+             InputWord input = frameMicros > 0 ? speculative.update(state) : bot.update(state);
+             if (deciding) {
+                 int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+                 decisionMicros += micros;
+                 maxDecisionMicros = std::max(maxDecisionMicros, micros);
+             }
+             return input;
+         },
+         [&]() { speculative.reset(); }}};
+    playArena(players, bouts, maxTicks, weapons);
+
+    std::cout << "Player 2 reaction: " << (bot.decisions ? decisionMicros / static_cast<int64_t>(bot.decisions) : 0)
+              << " us per decision on the playing thread, worst " << maxDecisionMicros << " us" << std::endl;
+    uint64_t answered = 0;
+    if (frameMicros > 0) {
+        const AlphaBetaBot& searcher = speculative.searcher;
+        uint64_t workerSearched = speculative.searches - searcher.bookHits;
+        std::cout << "Player 2 speculation: " << speculative.hits << " hits, " << speculative.waits << " finished after waiting, "
+                  << speculative.misses << " misses; " << speculative.searches << " states searched ahead, "
+                  << speculative.cancelled << " of them cancelled, average depth "
+                  << (workerSearched ? static_cast<double>(searcher.depthSum) / workerSearched : 0.0) << std::endl;
+        answered = speculative.hits + speculative.waits;
+    }
+
+    uint64_t searched = bot.decisions - bot.bookHits - answered;
+    std::cout << "Player 2 search: " << bot.decisions << " decisions, " << bot.bookHits << " from the book, "
+              << bot.tablebaseHits << " tablebase hits; "
+              << (searched ? bot.nodes / searched : 0) << " nodes and average depth "
+              << (searched ? static_cast<double>(bot.depthSum) / searched : 0.0) << " per search" << std::endl;
+    return 0;
+}
+
+int runPolicy(int argc, char* argv[]) {
+    std::string weightsPath = stringOption(argc, argv, "--weights", "policy.bin");
+    std::string initPath = stringOption(argc, argv, "--init", "");
+    std::vector<int> hidden = intListOption(argc, argv, "--hidden", {64, 64});
+    int seed = intOption(argc, argv, "--seed", 1);
+    int batch = intOption(argc, argv, "--batch", 256);
+    int bouts = intOption(argc, argv, "--bouts", 4);
+    int maxTicks = intOption(argc, argv, "--max-ticks", SIM_PERIOD_TICKS / 3);
+    std::vector<int> weapons = weaponOption(argc, argv);
+
+    if (weapons.empty()) return 1;
+    if (batch < 1) {
+        std::cerr << "policy: --batch must be at least 1" << std::endl;
+        return 1;
+    }
+
+    PolicyNetwork network;
+    if (!initPath.empty()) {
+        SimRandom rng(static_cast<uint64_t>(seed));
+        network.randomise(hidden, rng);
+        if (!network.save(initPath)) {
+            std::cerr << "policy: cannot write " << initPath << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote random weights to " << initPath << std::endl;
+    } else {
+        std::string error;
+        if (!network.load(weightsPath, error)) {
+            std::cerr << "policy: " << weightsPath << ": " << error << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Layers:";
+    for (const PolicyLayer& layer : network.layers) std::cout << " " << layer.inputs << "x" << layer.outputs;
+    std::cout << "; dot products: " << policySimdName() << std::endl;
+
+    // Observations from a random bout, so the benchmark sees realistic activations
+    std::vector<uint8_t> observations(static_cast<size_t>(batch) * POLICY_INPUTS);
+    MatchState state;
+    initMatch(state, static_cast<uint8_t>(weapons[0]));
+    SimRandom rng(static_cast<uint64_t>(seed));
+    for (int b = 0; b < batch; ++b) {
+        for (int t = 0; t < 7 && !state.over; ++t) {
+            stepMatch(state, static_cast<InputWord>(rng.below(32)), static_cast<InputWord>(rng.below(32)));
+        }
+        if (state.over) initMatch(state, static_cast<uint8_t>(weapons[0]));
+        observe(state, b % 2, observations.data() + static_cast<size_t>(b) * POLICY_INPUTS);
+    }
+
+    std::vector<int> moves(batch);
+    const int repeats = 2000;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) network.evaluate(observations.data() + (r % batch) * POLICY_INPUTS, 1, moves.data());
+    double single = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeats;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats / 100 + 1; ++r) network.evaluate(observations.data(), batch, moves.data());
+    double batched = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() /
+                     ((repeats / 100 + 1) * static_cast<double>(batch));
+    std::cout << "Latency: " << single << " us single, " << batched << " us per observation in batches of " << batch << std::endl;
+
+    PolicyBot bot(network, 1);
+    SimRandom opponentRng(static_cast<uint64_t>(seed) + 1);
+    ArenaPlayer players[2] = {randomPlayer(0, bot.stepTicks, opponentRng),
+                              {[&](const MatchState& state) { return bot.update(state); }, [&]() { bot.reset(); }}};
+    std::cout << "Player 2: policy; player 1: random moves" << std::endl;
+    playArena(players, bouts, maxTicks, weapons);
+    return 0;
+}
+
+// A behavior-tree bot against random moves, then a drill of many bots stepped side by side to
+// measure the per-tick cost and how much of the tree the cache skips
+int runTree(int argc, char* argv[]) {
+    std::string treePath = stringOption(argc, argv, "--tree", "bots/riposte.bt");
+    int bouts = intOption(argc, argv, "--bouts", 4);
+    int maxTicks = intOption(argc, argv, "--max-ticks", SIM_PERIOD_TICKS / 3);
+    int drillBots = intOption(argc, argv, "--drill-bots", 64);
+    int drillTicks = intOption(argc, argv, "--drill-ticks", SIM_PERIOD_TICKS);
+    std::vector<int> weapons = weaponOption(argc, argv);
+
+    if (weapons.empty()) return 1;
+    BehaviorTree tree;
+    std::string error;
+    if (!tree.load(treePath, error)) {
+        std::cerr << "tree: " << treePath << ": " << error << std::endl;
+        return 1;
+    }
+
+    std::cout << "Player 2: " << treePath << " (" << tree.nodes.size() << " nodes); player 1: random moves" << std::endl;
+    BtBot bot(tree, 1);
+    SimRandom rng(1);
+    ArenaPlayer players[2] = {randomPlayer(0, 10, rng),
+                              {[&](const MatchState& state) { return bot.update(state); }, [&]() { bot.reset(); }}};
+    playArena(players, bouts, maxTicks, weapons);
+    std::cout << "Player 2 evaluated " << bot.evaluations << " of " << bot.visits << " nodes reached" << std::endl;
+
+    if (drillBots < 1) return 0;
+    std::vector<MatchState> states(drillBots);
+    std::vector<BtBot> bots;
+    bots.reserve(drillBots);
+    for (int i = 0; i < drillBots; ++i) {
+        initMatch(states[i], static_cast<uint8_t>(weapons[i % weapons.size()]));
+        bots.emplace_back(tree, 1);
+    }
+    std::vector<InputWord> inputs(drillBots);
+    std::chrono::duration<double, std::micro> botTime(0);
+    for (int t = 0; t < drillTicks; ++t) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < drillBots; ++i) inputs[i] = bots[i].update(states[i]);
+        botTime += std::chrono::steady_clock::now() - start;
+        for (int i = 0; i < drillBots; ++i) {
+            if (t % 10 == 0) rng.next();
+            stepMatch(states[i], moveInput(static_cast<int>(rng.state % MOVE_COUNT), 0, t % 10), inputs[i]);
+            if (states[i].over) {
+                initMatch(states[i], states[i].weapon);
+                bots[i].reset();
+            }
+        }
+    }
+    uint64_t visits = 0;
+    uint64_t evaluations = 0;
+    for (const BtBot& drillBot : bots) {
+        visits += drillBot.visits;
+        evaluations += drillBot.evaluations;
+    }
+    std::cout << "Drill: " << drillBots << " bots x " << drillTicks << " ticks, " << botTime.count() / drillTicks
+              << " us of bot updates per tick; evaluated " << evaluations << " of " << visits << " nodes reached" << std::endl;
+    return 0;
+}
+
+// A script bot against random moves, then a drill of many copies to time the VM inside a frame
+int runScript(int argc, char* argv[]) {
+    std::string scriptPath = stringOption(argc, argv, "--script", "bots/counter.bot");
+    int bouts = intOption(argc, argv, "--bouts", 4);
+    int maxTicks = intOption(argc, argv, "--max-ticks", SIM_PERIOD_TICKS / 3);
+    int drillBots = intOption(argc, argv, "--drill-bots", 64);
+    int drillTicks = intOption(argc, argv, "--drill-ticks", SIM_PERIOD_TICKS);
+    int budget = intOption(argc, argv, "--budget", SCRIPT_TICK_BUDGET);
+    std::vector<int> weapons = weaponOption(argc, argv);
+
+    if (weapons.empty()) return 1;
+    ScriptProgram program;
+    std::string error;
+    if (!program.load(scriptPath, 1, error)) {
+        std::cerr << "script: " << scriptPath << ": " << error << std::endl;
+        return 1;
+    }
+    if (flagOption(argc, argv, "--dump")) std::cout << program.disassemble();
+
+    std::cout << "Player 2: " << scriptPath << " (" << program.code.size() << " instructions, " << program.variables.size()
+              << " variables); player 1: random moves" << std::endl;
+    ScriptBot bot(program, 1);
+    bot.budget = budget;
+    SimRandom rng(1);
+    ArenaPlayer players[2] = {randomPlayer(0, 10, rng),
+                              {[&](const MatchState& state) { return bot.update(state); }, [&]() { bot.reset(); }}};
+    playArena(players, bouts, maxTicks, weapons);
+    std::cout << "Player 2 ran " << bot.instructions << " instructions, " << bot.overruns << " ticks cut off by the budget" << std::endl;
+
+    if (drillBots < 1) return 0;
+    std::vector<MatchState> states(drillBots);
+    std::vector<ScriptBot> bots;
+    bots.reserve(drillBots);
+    for (int i = 0; i < drillBots; ++i) {
+        initMatch(states[i], static_cast<uint8_t>(weapons[i % weapons.size()]));
+        bots.emplace_back(program, 1);
+        bots.back().budget = budget;
+    }
+    std::vector<InputWord> inputs(drillBots);
+    std::chrono::duration<double, std::micro> botTime(0);
+    std::chrono::duration<double, std::micro> worstTick(0);
+    for (int t = 0; t < drillTicks; ++t) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < drillBots; ++i) inputs[i] = bots[i].update(states[i]);
+        std::chrono::duration<double, std::micro> tickTime = std::chrono::steady_clock::now() - start;
+        botTime += tickTime;
+        worstTick = std::max(worstTick, tickTime);
+        for (int i = 0; i < drillBots; ++i) {
+            if (t % 10 == 0) rng.next();
+            stepMatch(states[i], moveInput(static_cast<int>(rng.state % MOVE_COUNT), 0, t % 10), inputs[i]);
+            if (states[i].over) {
+                initMatch(states[i], states[i].weapon);
+                bots[i].reset();
+            }
+        }
+    }
+    uint64_t instructions = 0;
+    uint64_t overruns = 0;
+    for (const ScriptBot& drillBot : bots) {
+        instructions += drillBot.instructions;
+        overruns += drillBot.overruns;
+    }
+    std::cout << "Drill: " << drillBots << " bots x " << drillTicks << " ticks, " << botTime.count() / drillTicks
+              << " us of script per tick (worst " << worstTick.count() << " us), "
+              << static_cast<double>(instructions) / (static_cast<double>(drillBots) * drillTicks) << " instructions per bot-tick, "
+              << overruns << " overruns" << std::endl;
+    return 0;
+}
+
+// A script or tree bot in a child process against random moves: round-trip times, watchdog misses,
+// and whether its inputs match the same bot run in-process. --kill-at and --stop-at are fault drills.
+int runSandbox(int argc, char* argv[]) {
+    std::string botPath = stringOption(argc, argv, "--bot", "bots/counter.bot");
+    int bouts = intOption(argc, argv, "--bouts", 4);
+    int maxTicks = intOption(argc, argv, "--max-ticks", SIM_PERIOD_TICKS / 3);
+    int deadlineMicros = intOption(argc, argv, "--deadline-us", SANDBOX_DEADLINE_MICROS);
+    int frameMicros = intOption(argc, argv, "--frame-us", 0); // Pace the ticks like the game; 0 runs flat out
+    int killAt = intOption(argc, argv, "--kill-at", -1);      // Tick of the first bout to kill the child on
+    int stopAt = intOption(argc, argv, "--stop-at", -1);      // ... to stop it on, for 30 ticks
+    std::vector<int> weapons = weaponOption(argc, argv);
+
+    if (weapons.empty()) return 1;
+    if (deadlineMicros < 0 || frameMicros < 0) {
+        std::cerr << "sandbox: --deadline-us and --frame-us must not be negative" << std::endl;
+        return 1;
+    }
+    HostedBot reference(1);
+    std::string error;
+    if (!reference.load(botPath, 1, error)) {
+        std::cerr << "sandbox: " << botPath << ": " << error << std::endl;
+        return 1;
+    }
+    BotSandbox sandbox;
+    sandbox.deadlineMicros = deadlineMicros;
+    if (!sandbox.start(botPath, 1)) {
+        std::cerr << "sandbox: " << botPath << ": " << sandbox.error << std::endl;
+        return 1;
+    }
+
+    std::cout << "Player 2: " << botPath << " in a child process, " << deadlineMicros << " us deadline; player 1: random moves"
+              << std::endl;
+    SimRandom rng(1);
+    std::vector<int64_t> roundTrips;
+    uint64_t differing = 0;
+    int bout = -1;
+    ArenaPlayer players[2] = {randomPlayer(0, 10, rng),
+                              {[&](const MatchState& state) {
+                                   if (frameMicros > 0) std::this_thread::sleep_for(std::chrono::microseconds(frameMicros));
+                                   if (bout == 0 && static_cast<int>(state.tick) == killAt) sandbox.killChild();
+                                   if (bout == 0 && static_cast<int>(state.tick) == stopAt) sandbox.pauseChild(true);
+                                   if (bout == 0 && stopAt >= 0 && static_cast<int>(state.tick) == stopAt + 30) sandbox.pauseChild(false);
+                                   uint64_t misses = sandbox.misses;
+                                   InputWord input = sandbox.update(state);
+                                   InputWord expected = reference.update(state);
+                                   if (sandbox.misses == misses) {
+                                       roundTrips.push_back(sandbox.lastRoundTripNanos);
+                                       if (input != expected) differing++;
+                                   }
+                                   return input;
+                               },
+                               [&]() {
+                                   sandbox.reset();
+                                   reference.reset();
+                                   bout++;
+                               }}};
+    playArena(players, bouts, maxTicks, weapons);
+
+    std::sort(roundTrips.begin(), roundTrips.end());
+    double total = 0;
+    for (int64_t nanos : roundTrips) total += nanos;
+    auto percentile = [&](double fraction) {
+        return roundTrips.empty() ? 0.0 : roundTrips[static_cast<size_t>(fraction * (roundTrips.size() - 1))] / 1000.0;
+    };
+    std::cout << "Round trip: average " << (roundTrips.empty() ? 0.0 : total / roundTrips.size() / 1000.0) << " us, median "
+              << percentile(0.5) << " us, 99th percentile " << percentile(0.99) << " us, worst " << percentile(1.0) << " us" << std::endl;
+    std::cout << "Watchdog: " << sandbox.misses << " of " << sandbox.requests << " ticks played neutral, " << sandbox.restarts
+              << " restarts; " << differing << " answered ticks differ from the bot run in-process" << std::endl;
+    return 0;
+}
+
+// A shared-object bot against random moves, timing its decide calls; lists plugins/ without --plugin
+int runPlugin(int argc, char* argv[]) {
+    std::string pluginPath = stringOption(argc, argv, "--plugin", "");
+    int bouts = intOption(argc, argv, "--bouts", 4);
+    int maxTicks = intOption(argc, argv, "--max-ticks", SIM_PERIOD_TICKS / 3);
+    std::vector<int> weapons = weaponOption(argc, argv);
+
+    if (weapons.empty()) return 1;
+    if (pluginPath.empty()) {
+        std::vector<std::string> errors;
+        auto plugins = discoverPlugins(PLUGIN_DIRECTORY, errors);
+        for (const auto& plugin : plugins) std::cout << plugin->name << "\t" << plugin->path << std::endl;
+        for (const std::string& error : errors) std::cerr << "plugin: " << error << std::endl;
+        if (plugins.empty()) std::cerr << "plugin: no plugins in " << PLUGIN_DIRECTORY << "/" << std::endl;
+        return plugins.empty() ? 1 : 0;
+    }
+
+    BotPlugin plugin;
+    if (!plugin.open(pluginPath)) {
+        std::cerr << "plugin: " << pluginPath << ": " << plugin.error << std::endl;
+        return 1;
+    }
+    PluginBot bot;
+    if (!bot.begin(&plugin, 1)) {
+        std::cerr << "plugin: " << pluginPath << " refused to play (built for another ABI than " << std::hex
+                  << FENCING_PLUGIN_ABI << std::dec << "?)" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Player 2: plugin " << plugin.name << "; player 1: random moves" << std::endl;
+    SimRandom rng(1);
+    std::chrono::duration<double, std::micro> decideTime(0);
+    uint64_t decisions = 0;
+    ArenaPlayer players[2] = {randomPlayer(0, 10, rng),
+                              {[&](const MatchState& state) {
+                                   auto start = std::chrono::steady_clock::now();
+                                   InputWord input = bot.update(state);
+                                   decideTime += std::chrono::steady_clock::now() - start;
+                                   decisions++;
+                                   return input;
+                               },
+                               [&]() { bot.begin(&plugin, 1); }}};
+    playArena(players, bouts, maxTicks, weapons);
+    std::cout << "Player 2 decide: " << (decisions ? decideTime.count() / decisions : 0.0) << " us per tick" << std::endl;
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include "balance.h"
+#include "lab.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <string>
+
+#define BALANCE_MAX_PENDING 64 // Decisions waiting for their window to close
+
+void BalanceAccumulator::merge(const BalanceAccumulator& other) {
+    for (size_t i = 0; i < counts.size(); ++i) counts[i] += other.counts[i];
+    for (int weapon = 0; weapon < WEAPON_COUNT; ++weapon) {
+        for (int winner = 0; winner < 3; ++winner) bouts[weapon][winner] += other.bouts[weapon][winner];
+    }
+    ticks += other.ticks;
+}
+
+static int bandOf(int distance) {
+    int band = distance / BALANCE_BAND_WIDTH;
+    if (band < 0) return 0;
+    return band < BALANCE_BANDS ? band : BALANCE_BANDS - 1;
+}
+
+// A sampled bot: a random weight from 0 to 15 for every move in every distance band, so some bots
+// never parry, some only attack from far away, and so on
+struct BalancePolicy {
+    uint8_t cumulative[BALANCE_BANDS][MOVE_COUNT];
+
+    explicit BalancePolicy(SimRandom& rng) {
+        for (int band = 0; band < BALANCE_BANDS; ++band) {
+            uint64_t weights = rng.next();
+            int total = 0;
+            for (int move = 0; move < MOVE_COUNT; ++move) {
+                total += static_cast<int>((weights >> (4 * move)) & 15);
+                cumulative[band][move] = static_cast<uint8_t>(total);
+            }
+            if (total == 0) cumulative[band][MOVE_COUNT - 1] = 1; // All zero: always the last move
+        }
+    }
+
+    int pick(SimRandom& rng, int band) const {
+        int roll = rng.below(cumulative[band][MOVE_COUNT - 1]);
+        int move = 0;
+        while (cumulative[band][move] <= roll) move++;
+        return move;
+    }
+};
+
+// Plays one bout. Both bots pick a move every stepTicks; each decision is credited with the touch if
+// it comes within config.window ticks, or with no touch once the window closes.
+void playBalanceBout(const BalanceConfig& config, uint64_t seed, uint8_t weapon, BalanceAccumulator& accumulator) {
+    SimRandom rng(seed);
+    BalancePolicy policies[2] = {BalancePolicy(rng), BalancePolicy(rng)};
+
+    MatchState state;
+    initMatch(state, weapon);
+    placeFencers(state, rng.below(SIM_MAX_X + 1));
+
+    uint64_t* pending[BALANCE_MAX_PENDING];
+    int pendingTicks[BALANCE_MAX_PENDING];
+    int first = 0, count = 0;
+    int moves[2] = {MOVE_HOLD, MOVE_HOLD};
+    int stepTick = 0;
+
+    for (int t = 0; t < config.maxTicks; ++t) {
+        if (stepTick == 0) {
+            int band = bandOf(fencerDistance(state));
+            moves[0] = policies[0].pick(rng, band);
+            moves[1] = policies[1].pick(rng, band);
+            pending[(first + count) % BALANCE_MAX_PENDING] = accumulator.at(weapon, band, moves[0], moves[1]);
+            pendingTicks[(first + count) % BALANCE_MAX_PENDING] = t;
+            count++;
+        }
+
+        uint8_t events = stepMatch(state, moveInput(moves[0], 0, stepTick), moveInput(moves[1], 1, stepTick));
+        stepTick = (stepTick + 1) % config.stepTicks;
+
+        if (events & (EVENT_TOUCH_P1 | EVENT_TOUCH_P2)) {
+            int outcome = (events & EVENT_TOUCH_P1) ? OUTCOME_TOUCH_P1 : OUTCOME_TOUCH_P2;
+            for (int i = 0; i < count; ++i) pending[(first + i) % BALANCE_MAX_PENDING][outcome]++;
+            accumulator.bouts[weapon][(events & EVENT_TOUCH_P1) ? 1 : 2]++;
+            accumulator.ticks += static_cast<uint64_t>(t + 1);
+            return;
+        }
+        while (count > 0 && pendingTicks[first] + config.window <= t) {
+            pending[first][OUTCOME_NONE]++;
+            first = (first + 1) % BALANCE_MAX_PENDING;
+            count--;
+        }
+    }
+
+    // Decisions still inside their window when the bout runs out of time are left out
+    accumulator.bouts[weapon][0]++;
+    accumulator.ticks += static_cast<uint64_t>(config.maxTicks);
+}
+
+static double rate(const uint64_t* cell, int outcome) {
+    uint64_t samples = cell[OUTCOME_TOUCH_P1] + cell[OUTCOME_TOUCH_P2] + cell[OUTCOME_NONE];
+    return samples ? static_cast<double>(cell[outcome]) / samples : 0.0;
+}
+
+static void printWeapon(BalanceAccumulator& total, int weapon) {
+    uint64_t* bouts = total.bouts[weapon];
+    uint64_t boutCount = bouts[0] + bouts[1] + bouts[2];
+    if (boutCount == 0) return;
+
+    std::cout << "\n" << WEAPON_NAMES[weapon] << ": " << boutCount << " bouts, player 1 scored in " << std::fixed << std::setprecision(1)
+              << 100.0 * bouts[1] / boutCount << "%, player 2 in " << 100.0 * bouts[2] / boutCount << "%, no touch in "
+              << 100.0 * bouts[0] / boutCount << "%" << std::endl;
+
+    // Net touch rate over every band: P(player 1 touches) - P(player 2 touches), in percent
+    std::cout << "Net touch rate for player 1 (rows: player 1 move, columns: player 2 move)" << std::endl;
+    std::cout << std::setw(16) << "";
+    for (int column = 0; column < MOVE_COUNT; ++column) std::cout << std::setw(16) << MOVE_NAMES[column];
+    std::cout << std::endl;
+    for (int row = 0; row < MOVE_COUNT; ++row) {
+        std::cout << std::left << std::setw(16) << MOVE_NAMES[row] << std::right;
+        for (int column = 0; column < MOVE_COUNT; ++column) {
+            uint64_t pooled[OUTCOME_COUNT] = {};
+            for (int band = 0; band < BALANCE_BANDS; ++band) {
+                const uint64_t* cell = total.at(weapon, band, row, column);
+                for (int outcome = 0; outcome < OUTCOME_COUNT; ++outcome) pooled[outcome] += cell[outcome];
+            }
+            std::cout << std::setw(16) << std::showpos
+                      << 100.0 * (rate(pooled, OUTCOME_TOUCH_P1) - rate(pooled, OUTCOME_TOUCH_P2)) << std::noshowpos;
+        }
+        std::cout << std::endl;
+    }
+
+    // Per band, the move with the best net touch rate for each player against every reply
+    std::cout << "Best move per distance band:" << std::endl;
+    for (int band = 0; band < BALANCE_BANDS; ++band) {
+        uint64_t samples = 0;
+        double net[2][MOVE_COUNT] = {};
+        uint64_t moveSamples[2][MOVE_COUNT] = {};
+        for (int row = 0; row < MOVE_COUNT; ++row) {
+            for (int column = 0; column < MOVE_COUNT; ++column) {
+                const uint64_t* cell = total.at(weapon, band, row, column);
+                uint64_t cellSamples = cell[OUTCOME_TOUCH_P1] + cell[OUTCOME_TOUCH_P2] + cell[OUTCOME_NONE];
+                double p1Net = static_cast<double>(cell[OUTCOME_TOUCH_P1]) - static_cast<double>(cell[OUTCOME_TOUCH_P2]);
+                samples += cellSamples;
+                net[0][row] += p1Net;
+                net[1][column] -= p1Net;
+                moveSamples[0][row] += cellSamples;
+                moveSamples[1][column] += cellSamples;
+            }
+        }
+        if (samples == 0) continue;
+
+        std::cout << "  " << std::setw(3) << band * BALANCE_BAND_WIDTH << "-" << std::left << std::setw(4)
+                  << (band + 1) * BALANCE_BAND_WIDTH - 1 << std::right << std::setw(12) << samples << " decisions";
+        for (int side = 0; side < 2; ++side) {
+            int best = 0;
+            double bestRate = -2.0;
+            for (int move = 0; move < MOVE_COUNT; ++move) {
+                if (moveSamples[side][move] == 0) continue;
+                double moveRate = net[side][move] / moveSamples[side][move];
+                if (moveRate > bestRate) {
+                    bestRate = moveRate;
+                    best = move;
+                }
+            }
+            std::cout << "   P" << side + 1 << " " << std::left << std::setw(15) << MOVE_NAMES[best] << std::right
+                      << std::showpos << 100.0 * bestRate << "%" << std::noshowpos;
+        }
+        std::cout << std::endl;
+    }
+    std::cout.unsetf(std::ios::fixed);
+}
+
+int runBalance(int argc, char* argv[]) {
+    BalanceConfig config;
+    config.stepTicks = intOption(argc, argv, "--step-ticks", config.stepTicks);
+    config.window = intOption(argc, argv, "--window", config.window);
+    config.maxTicks = intOption(argc, argv, "--max-ticks", config.maxTicks);
+    uint64_t boutCount = static_cast<uint64_t>(intOption(argc, argv, "--bouts", 1000000));
+    uint64_t seed = static_cast<uint64_t>(intOption(argc, argv, "--seed", 1));
+    std::vector<int> weapons = weaponOption(argc, argv);
+    std::string outPath = stringOption(argc, argv, "--out", "");
+    int threads = threadOption(argc, argv);
+
+    if (weapons.empty()) return 1;
+    if (config.stepTicks < 6 || config.window < 1 || config.window / config.stepTicks >= BALANCE_MAX_PENDING - 1 || config.maxTicks < 1) {
+        std::cerr << "balance: --step-ticks must be at least 6, --window between 1 and "
+                  << (BALANCE_MAX_PENDING - 2) * config.stepTicks << " ticks and --max-ticks positive" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Playing " << boutCount << " bouts on " << threads << " threads, seed " << seed << std::endl;
+
+    // Bout i always gets the same seed and weapon, so results do not depend on the thread count.
+    // Each worker strides over the bouts with its own accumulator: nothing is shared until the merge.
+    auto start = std::chrono::steady_clock::now();
+    std::vector<BalanceAccumulator> results(threads);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            BalanceAccumulator accumulator;
+            for (uint64_t bout = i; bout < boutCount; bout += threads) {
+                uint8_t weapon = static_cast<uint8_t>(weapons[bout % weapons.size()]);
+                playBalanceBout(config, seedFor(seed, bout), weapon, accumulator);
+            }
+            results[i] = std::move(accumulator);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    BalanceAccumulator total;
+    for (const BalanceAccumulator& result : results) total.merge(result);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << boutCount << " bouts, " << total.ticks << " ticks in " << seconds << " s" << std::endl;
+
+    for (int weapon : weapons) printWeapon(total, weapon);
+
+    if (!outPath.empty()) {
+        std::ofstream out(outPath);
+        if (!out) {
+            std::cerr << "balance: cannot write " << outPath << std::endl;
+            return 1;
+        }
+        out << "weapon,distance_min,distance_max,player1_move,player2_move,samples,touch_p1,touch_p2,no_touch\n";
+        for (int weapon : weapons) {
+            for (int band = 0; band < BALANCE_BANDS; ++band) {
+                for (int row = 0; row < MOVE_COUNT; ++row) {
+                    for (int column = 0; column < MOVE_COUNT; ++column) {
+                        const uint64_t* cell = total.at(weapon, band, row, column);
+                        uint64_t samples = cell[OUTCOME_TOUCH_P1] + cell[OUTCOME_TOUCH_P2] + cell[OUTCOME_NONE];
+                        if (samples == 0) continue;
+                        out << WEAPON_NAMES[weapon] << "," << band * BALANCE_BAND_WIDTH << "," << (band + 1) * BALANCE_BAND_WIDTH - 1
+                            << "," << MOVE_NAMES[row] << "," << MOVE_NAMES[column] << "," << samples << ","
+                            << rate(cell, OUTCOME_TOUCH_P1) << "," << rate(cell, OUTCOME_TOUCH_P2) << "," << rate(cell, OUTCOME_NONE) << "\n";
+                    }
+                }
+            }
+        }
+        std::cout << "Wrote " << outPath << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+// Monte Carlo balance sweep ("FencingLab balance"). Plays sampled bot policies against each other over
+// many randomized bouts and records how often each pair of macro moves leads to a touch, per weapon
+// and distance band. A bout here is one exchange: it starts at a random distance and ends on the first
+// touch, like a point in the real game.
+#ifndef BALANCE_H
+#define BALANCE_H
+
+#include "solver.h"
+#include <vector>
+
+#define BALANCE_BAND_WIDTH 50 // Pixels of hurtbox gap per distance band
+#define BALANCE_BANDS (SIM_MAX_X / BALANCE_BAND_WIDTH + 1)
+
+enum BalanceOutcome : uint8_t {
+    OUTCOME_TOUCH_P1, // Player 1 touched within the window
+    OUTCOME_TOUCH_P2, // Player 2 touched within the window
+    OUTCOME_NONE,     // Nobody touched within the window
+    OUTCOME_COUNT
+};
+
+// Counts for one worker, merged once every worker has finished. Plain integers: each worker owns its own.
+struct BalanceAccumulator {
+    std::vector<uint64_t> counts; // [weapon][band][player 1 move][player 2 move][outcome]
+    uint64_t bouts[WEAPON_COUNT][3] = {}; // Per weapon: no touch, player 1 touched, player 2 touched
+    uint64_t ticks = 0;
+
+    BalanceAccumulator() : counts(static_cast<size_t>(WEAPON_COUNT) * BALANCE_BANDS * MOVE_COUNT * MOVE_COUNT * OUTCOME_COUNT, 0) {}
+
+    uint64_t* at(int weapon, int band, int player1Move, int player2Move) {
+        return &counts[(((static_cast<size_t>(weapon) * BALANCE_BANDS + band) * MOVE_COUNT + player1Move) * MOVE_COUNT + player2Move) * OUTCOME_COUNT];
+    }
+    void merge(const BalanceAccumulator& other);
+};
+
+struct BalanceConfig {
+    int stepTicks = 10;                                // Ticks between decisions, as in the solver
+    int window = SIM_ACTION_TICKS;                     // A decision is credited with a touch this many ticks later
+    int maxTicks = 10 * SIM_FPS;                       // Bouts with no touch after this end as draws
+};
+
+void playBalanceBout(const BalanceConfig& config, uint64_t seed, uint8_t weapon, BalanceAccumulator& accumulator);
+
+#endif // BALANCE_H
@@ -0,0 +1,225 @@
+#include "behaviortree.h"
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+const char* const BB_NAMES[BB_COUNT] = {
+    "gap", "own_action", "opp_action", "own_phase", "opp_phase", "threat", "parried", "score", "period"
+};
+
+static const char* const COMPARE_NAMES[] = {"<", "<=", "==", "!=", ">=", ">"};
+
+template <size_t N>
+static int nameIndex(const char* const (&names)[N], const std::string& name) {
+    for (size_t i = 0; i < N; ++i) {
+        if (name == names[i]) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool BehaviorTree::load(const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot read";
+        return false;
+    }
+    return parse(in, error);
+}
+
+bool BehaviorTree::parse(std::istream& in, std::string& error) {
+    std::vector<BtNode> parsed;
+    std::vector<int> lastChild;
+    std::vector<std::pair<size_t, int>> open; // (indent, node) for the chain of possible parents
+    std::string line;
+
+    for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        std::string where = "line " + std::to_string(lineNumber) + ": ";
+        line = line.substr(0, line.find('#'));
+        size_t indent = line.find_first_not_of(' ');
+        if (indent == std::string::npos || line.find_first_not_of(" \r") == std::string::npos) continue;
+        if (line[indent] == '\t') {
+            error = where + "indent with spaces";
+            return false;
+        }
+
+        std::istringstream words(line);
+        std::string word;
+        words >> word;
+        BtNode node;
+        if (word == "selector" || word == "sequence") {
+            node.type = word == "selector" ? BT_SELECTOR : BT_SEQUENCE;
+        } else if (word == "if") {
+            std::string key, compare, value;
+            words >> key >> compare >> value;
+            int keyIndex = nameIndex(BB_NAMES, key);
+            int compareIndex = nameIndex(COMPARE_NAMES, compare);
+            if (keyIndex < 0 || compareIndex < 0 || value.empty()) {
+                error = where + "expected \"if <key> <op> <value>\"";
+                return false;
+            }
+            node.type = BT_CONDITION;
+            node.key = static_cast<uint8_t>(keyIndex);
+            node.compare = static_cast<uint8_t>(compareIndex);
+            node.reads = 1u << keyIndex;
+            int action = actionFromName(value.c_str());
+            char* end;
+            long number = std::strtol(value.c_str(), &end, 10);
+            if (action >= 0) {
+                node.value = action;
+            } else if (*end == '\0') {
+                node.value = static_cast<int>(number);
+            } else {
+                error = where + "\"" + value + "\" is neither a number nor an action";
+                return false;
+            }
+        } else if (word == "do") {
+            words >> word;
+            int move = nameIndex(MOVE_NAMES, word);
+            if (move < 0) {
+                error = where + "unknown move \"" + word + "\"";
+                return false;
+            }
+            node.type = BT_ACTION;
+            node.move = static_cast<uint8_t>(move);
+        } else {
+            error = where + "unknown node \"" + word + "\"";
+            return false;
+        }
+        if (words >> word) {
+            error = where + "unexpected \"" + word + "\"";
+            return false;
+        }
+
+        while (!open.empty() && open.back().first >= indent) open.pop_back();
+        int index = static_cast<int>(parsed.size());
+        if (open.empty()) {
+            if (!parsed.empty()) {
+                error = where + "a tree has one root";
+                return false;
+            }
+        } else {
+            int parent = open.back().second;
+            if (parsed[parent].type != BT_SELECTOR && parsed[parent].type != BT_SEQUENCE) {
+                error = where + "only selector and sequence nodes have children";
+                return false;
+            }
+            if (lastChild[parent] < 0) {
+                parsed[parent].firstChild = index;
+            } else {
+                parsed[lastChild[parent]].nextSibling = index;
+            }
+            lastChild[parent] = index;
+        }
+        parsed.push_back(node);
+        lastChild.push_back(-1);
+        open.emplace_back(indent, index);
+    }
+
+    if (parsed.empty()) {
+        error = "empty tree";
+        return false;
+    }
+    // Children follow their parent, so one backward pass collects each subtree's reads
+    for (int index = static_cast<int>(parsed.size()) - 1; index >= 0; --index) {
+        BtNode& node = parsed[index];
+        if ((node.type == BT_SELECTOR || node.type == BT_SEQUENCE) && node.firstChild < 0) {
+            error = std::string(node.type == BT_SELECTOR ? "selector" : "sequence") + " without children";
+            return false;
+        }
+        for (int child = node.firstChild; child >= 0; child = parsed[child].nextSibling) node.reads |= parsed[child].reads;
+    }
+
+    nodes.swap(parsed);
+    error.clear();
+    return true;
+}
+
+void BtBot::reset() {
+    tick = 1;
+    for (int key = 0; key < BB_COUNT; ++key) {
+        values[key] = 0;
+        changedAt[key] = tick;
+    }
+    for (BtResult& result : cache) result.evaluatedAt = 0;
+    runner.reset();
+}
+
+void BtBot::observe(const MatchState& state) {
+    const FencerState& own = state.fencers[player];
+    const FencerState& opponent = state.fencers[1 - player];
+    bool threat = simIntersects(fencerHitbox(state, 1 - player), fencerHurtbox(state, player));
+    int parried = values[BB_PARRIED];
+    if (fencerParrying(own) && threat) {
+        parried = 1;
+    } else if (own.action != ACTION_IDLE && !fencerParrying(own)) {
+        parried = 0;
+    }
+
+    int observed[BB_COUNT] = {
+        fencerDistance(state), own.action, opponent.action, own.actionTicks / 10, opponent.actionTicks / 10, threat,
+        parried, state.points[player] - state.points[1 - player], state.period};
+    for (int key = 0; key < BB_COUNT; ++key) {
+        if (observed[key] == values[key]) continue;
+        values[key] = observed[key];
+        changedAt[key] = tick;
+    }
+}
+
+const BtResult& BtBot::evaluate(int index) {
+    visits++;
+    const BtNode& node = tree.nodes[index];
+    BtResult& result = cache[index];
+    if (result.evaluatedAt) {
+        bool stale = false;
+        for (int key = 0; key < BB_COUNT && !stale; ++key) {
+            stale = (node.reads & 1u << key) && changedAt[key] > result.evaluatedAt;
+        }
+        if (!stale) return result;
+    }
+
+    evaluations++;
+    switch (node.type) {
+    case BT_SELECTOR:
+        result.success = false;
+        for (int child = node.firstChild; child >= 0 && !result.success; child = tree.nodes[child].nextSibling) {
+            const BtResult& childResult = evaluate(child);
+            result.success = childResult.success;
+            result.move = childResult.move;
+        }
+        break;
+    case BT_SEQUENCE:
+        result.success = true;
+        result.move = MOVE_HOLD;
+        for (int child = node.firstChild; child >= 0 && result.success; child = tree.nodes[child].nextSibling) {
+            const BtResult& childResult = evaluate(child);
+            result.success = childResult.success;
+            if (tree.nodes[child].type != BT_CONDITION) result.move = childResult.move;
+        }
+        break;
+    case BT_CONDITION: {
+        int value = values[node.key];
+        switch (node.compare) {
+        case BT_LESS: result.success = value < node.value; break;
+        case BT_LESS_EQUAL: result.success = value <= node.value; break;
+        case BT_EQUAL: result.success = value == node.value; break;
+        case BT_NOT_EQUAL: result.success = value != node.value; break;
+        case BT_GREATER_EQUAL: result.success = value >= node.value; break;
+        default: result.success = value > node.value; break;
+        }
+        break;
+    }
+    default:
+        result.success = true;
+        result.move = node.move;
+        break;
+    }
+    result.evaluatedAt = tick;
+    return result;
+}
+
+InputWord BtBot::update(const MatchState& state) {
+    tick++;
+    observe(state);
+    const BtResult& root = evaluate(0);
+    return runner.next(root.success ? static_cast<int>(root.move) : static_cast<int>(MOVE_HOLD), state, player);
+}
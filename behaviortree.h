@@ -0,0 +1,96 @@
+// Scripted sparring partners: a behavior tree read from a text file picks a macro move every tick.
+// Nodes are pure functions of a small blackboard derived from the match state, so each node caches
+// its result and is only evaluated again when a blackboard key read somewhere below it has changed.
+//
+// Tree files have one node per line, children indented under their parent, "#" comments:
+//   selector                  first child that succeeds
+//   sequence                  every child must succeed; the last "do" below it is the move
+//   if <key> <op> <value>     op is < <= == != >= >, value an integer or an action name
+//   do <move>                 a MOVE_NAMES entry; always succeeds
+#ifndef BEHAVIORTREE_H
+#define BEHAVIORTREE_H
+
+#include "simulation.h"
+#include <istream>
+#include <string>
+#include <vector>
+
+// Blackboard keys, seen from the bot's side
+enum BlackboardKey : uint8_t {
+    BB_GAP,        // fencerDistance
+    BB_OWN_ACTION, // ActionId
+    BB_OPP_ACTION,
+    BB_OWN_PHASE,  // actionTicks / 10
+    BB_OPP_PHASE,
+    BB_THREAT,     // 1 while the opponent's blade is on the bot's hurtbox
+    BB_PARRIED,    // 1 from a parry meeting the blade until the bot's next attack or strike
+    BB_SCORE,      // Own points minus the opponent's
+    BB_PERIOD,
+    BB_COUNT
+};
+extern const char* const BB_NAMES[BB_COUNT];
+
+enum BtNodeType : uint8_t {
+    BT_SELECTOR,
+    BT_SEQUENCE,
+    BT_CONDITION,
+    BT_ACTION
+};
+
+enum BtCompare : uint8_t {
+    BT_LESS,
+    BT_LESS_EQUAL,
+    BT_EQUAL,
+    BT_NOT_EQUAL,
+    BT_GREATER_EQUAL,
+    BT_GREATER
+};
+
+struct BtNode {
+    uint8_t type = BT_SELECTOR;
+    uint8_t key = BB_GAP;       // Conditions
+    uint8_t compare = BT_EQUAL;
+    int value = 0;
+    uint8_t move = MOVE_HOLD;   // Actions
+    int firstChild = -1;
+    int nextSibling = -1;
+    uint32_t reads = 0;         // Bit per BlackboardKey read by the node or its subtree
+};
+
+struct BehaviorTree {
+    std::vector<BtNode> nodes; // nodes[0] is the root; children always follow their parent
+
+    bool load(const std::string& path, std::string& error);
+    bool parse(std::istream& in, std::string& error);
+};
+
+// Cached result of one node for one bot
+struct BtResult {
+    bool success = false;
+    uint8_t move = MOVE_HOLD;
+    uint32_t evaluatedAt = 0; // Bot tick of the evaluation, 0 for never
+};
+
+// One bot running a shared tree; the per-node cache is the only per-bot storage
+struct BtBot {
+    const BehaviorTree& tree;
+    int player;
+    int values[BB_COUNT] = {};
+    uint32_t changedAt[BB_COUNT] = {};  // Bot tick on which each key last changed
+    uint32_t tick = 0;
+    std::vector<BtResult> cache;
+    MoveRunner runner;
+    uint64_t visits = 0;                // Nodes reached, cached or not
+    uint64_t evaluations = 0;           // Nodes actually evaluated
+
+    BtBot(const BehaviorTree& tree, int player) : tree(tree), player(player), cache(tree.nodes.size()) { reset(); }
+
+    InputWord update(const MatchState& state); // Call once per tick
+    void reset();
+
+private:
+    void observe(const MatchState& state);
+    const BtResult& evaluate(int index);
+};
+
+#endif // BEHAVIORTREE_H
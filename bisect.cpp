@@ -0,0 +1,357 @@
+#include "replay.h"
+#include "simengine.h"
+#include "lab.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+// One of the two runs compared: a build's rules re-simulating a replay's keys, or the snapshots and
+// hashes that the build which played the bout recorded in it
+struct BisectSide {
+    const MappedReplay* replay = nullptr;
+    SimStepFunction step = nullptr;        // nullptr for the recording itself
+    std::vector<MatchState> states;        // At each bisection point, once known
+    std::vector<bool> known;
+
+    // Tick by tick through one keyframe interval
+    std::unique_ptr<ReplayReader> reader;
+    MatchState state;
+};
+
+// The points bisected over: every keyframe both replays have, then the end of the shorter bout
+struct BisectPoints {
+    size_t keyframes = 0;
+    uint32_t endTick = 0;
+    const MappedReplay* replay = nullptr;  // Whose keyframe ticks are used; both agree on them
+
+    uint32_t tick(size_t point) const { return point < keyframes ? replay->keyframes[point].tick : endTick; }
+};
+
+// The side's state at point, simulated from the last point before it whose state is known. Points
+// passed on the way are kept, so a bisection simulates each tick about twice at most.
+static const MatchState& stateAt(BisectSide& side, const BisectPoints& points, size_t point) {
+    if (side.known[point]) return side.states[point];
+    if (!side.step) {
+        side.replay->keyframeState(point, side.states[point]); // Recordings only know their keyframes
+        side.known[point] = true;
+        return side.states[point];
+    }
+    size_t from = std::min(point, points.keyframes - 1);
+    while (!side.known[from]) from--;
+    MatchState recorded;
+    side.replay->keyframeState(from, recorded);
+    ReplayReader reader(*side.replay, side.replay->keyframes[from], recorded);
+    MatchState state = side.states[from];
+    InputWord player1Input, player2Input;
+    for (size_t next = from + 1; next <= point;) {
+        if (reader.tick == points.tick(next)) {
+            side.states[next] = state;
+            side.known[next++] = true;
+            continue;
+        }
+        if (!reader.next(player1Input, player2Input)) break;
+        side.step(&state, player1Input, player2Input);
+    }
+    if (!side.known[point]) { // The stream ended early; open() makes that impossible
+        side.states[point] = state;
+        side.known[point] = true;
+    }
+    return side.states[point];
+}
+
+// Whether both sides hold the same match at point: byte for byte where both have the state, else by
+// hash. A recording has no state at the end, only its final hash, and none at all at the end of a
+// shorter bout.
+static bool agreeAt(BisectSide* sides, const BisectPoints& points, size_t point) {
+    bool full[2];
+    uint64_t hashes[2];
+    for (int i = 0; i < 2; ++i) {
+        full[i] = sides[i].step || point < points.keyframes;
+        if (full[i]) {
+            hashes[i] = hashMatchState(stateAt(sides[i], points, point));
+        } else if (sides[i].replay->header->tickCount == points.endTick) {
+            hashes[i] = sides[i].replay->header->finalHash;
+        } else {
+            return false;
+        }
+    }
+    if (full[0] && full[1]) {
+        return sameMatchState(sides[0].states[point], sides[1].states[point]);
+    }
+    return hashes[0] == hashes[1];
+}
+
+static std::string boxText(const SimRect& box) {
+    if (box.w <= 0 || box.h <= 0) return "none";
+    return std::to_string(box.x) + "," + std::to_string(box.y) + " " + std::to_string(box.w) + "x" + std::to_string(box.h);
+}
+
+// One line per field of the two states that differs, the first side's value first
+static void printStateDiff(std::ostream& out, const MatchState& a, const MatchState& b) {
+    auto field = [&](const std::string& name, const std::string& first, const std::string& second) {
+        if (first != second) out << "  " << name << ": " << first << " -> " << second << "\n";
+    };
+    auto number = [](int value) { return std::to_string(value); };
+    for (int player = 0; player < 2; ++player) {
+        const FencerState& fa = a.fencers[player];
+        const FencerState& fb = b.fencers[player];
+        std::string who = "player " + std::to_string(player + 1) + " ";
+        field(who + "x", number(fa.x), number(fb.x));
+        field(who + "velocityX", number(fa.velocityX), number(fb.velocityX));
+        field(who + "action", fa.action < ACTION_COUNT ? ACTION_NAMES[fa.action] : number(fa.action),
+              fb.action < ACTION_COUNT ? ACTION_NAMES[fb.action] : number(fb.action));
+        field(who + "actionTicks", number(fa.actionTicks), number(fb.actionTicks));
+        field(who + "hurtbox", boxText(fencerHurtbox(a, player)), boxText(fencerHurtbox(b, player)));
+        field(who + "hitbox", boxText(fencerHitbox(a, player)), boxText(fencerHitbox(b, player)));
+        if (fencerParrying(fa) || fencerParrying(fb)) {
+            field(who + "parry box", boxText(fencerParryBox(a, player)), boxText(fencerParryBox(b, player)));
+        }
+        field(who + "held", number(fa.held), number(fb.held));
+        field(who + "leftFrames", number(fa.leftFrames), number(fb.leftFrames));
+        field(who + "rightFrames", number(fa.rightFrames), number(fb.rightFrames));
+        for (int key = 0; key < INPUT_SYMBOLS; ++key) {
+            field(who + "pressAge " + INPUT_NAMES[key], number(fa.pressAge[key]), number(fb.pressAge[key]));
+        }
+    }
+    field("points", number(a.points[0]) + "-" + number(a.points[1]), number(b.points[0]) + "-" + number(b.points[1]));
+    field("period", number(a.period), number(b.period));
+    field("periodTicks", number(a.periodTicks), number(b.periodTicks));
+    field("suddenDeath", number(a.suddenDeath), number(b.suddenDeath));
+    field("over", number(a.over), number(b.over));
+    field("tick", std::to_string(a.tick), std::to_string(b.tick));
+    field("weapon", number(a.weapon), number(b.weapon));
+}
+
+// Finds the first keyframe interval where the sides part, by bisection, then walks it tick by tick.
+// Two simulations are compared every tick, so the tick found is exact; against a recording only its
+// checkpoint hashes and keyframes exist, so it is the checkpoint interval. Assumes a bout that has
+// diverged stays diverged at every later keyframe, which a touch scored differently ensures; a
+// difference that heals before the next keyframe is left to verify, which checks every checkpoint.
+// Returns false with report empty when the sides agree.
+static bool bisectReplay(BisectSide* sides, const std::string names[2], std::ostream& report) {
+    const ReplayHeader& first = *sides[0].replay->header;
+    const ReplayHeader& second = *sides[1].replay->header;
+    if (first.weapon != second.weapon || first.distance != second.distance || first.keyframeTicks != second.keyframeTicks ||
+        first.checkpointTicks != second.checkpointTicks) {
+        report << "not the same bout (weapon, starting gap or intervals differ)";
+        return true;
+    }
+    BisectPoints points;
+    points.keyframes = std::min(sides[0].replay->keyframeCount, sides[1].replay->keyframeCount);
+    points.endTick = std::min(first.tickCount, second.tickCount);
+    points.replay = sides[0].replay;
+    if (points.keyframes == 0) {
+        report << "no keyframes";
+        return true;
+    }
+    for (int i = 0; i < 2; ++i) {
+        sides[i].states.assign(points.keyframes + 1, MatchState());
+        sides[i].known.assign(points.keyframes + 1, false);
+        sides[i].replay->keyframeState(0, sides[i].states[0]); // Both builds start from the recorded tick 0
+        sides[i].known[0] = true;
+    }
+
+    if (agreeAt(sides, points, points.keyframes)) return false;
+    size_t low = 0, high = points.keyframes;
+    if (!agreeAt(sides, points, 0)) {
+        report << names[0] << " and " << names[1] << " start from different states\n";
+        printStateDiff(report, sides[0].states[0], sides[1].states[0]);
+        return true;
+    }
+    while (high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+        if (agreeAt(sides, points, middle)) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    // Both sides from the last point they agree at, comparing wherever both have a state or a hash
+    for (int i = 0; i < 2; ++i) {
+        BisectSide& side = sides[i];
+        MatchState recorded;
+        side.replay->keyframeState(low, recorded);
+        side.reader = std::make_unique<ReplayReader>(*side.replay, side.replay->keyframes[low], recorded);
+        side.state = stateAt(side, points, low);
+    }
+    uint32_t lastAgreed = points.tick(low);
+    int64_t firstDiffered = -1;
+    bool diffed = false;
+    InputWord inputs[2][2];
+    while (sides[0].reader->tick < points.tick(high)) {
+        bool full[2], hashed[2];
+        uint64_t hashes[2];
+        for (int i = 0; i < 2; ++i) {
+            BisectSide& side = sides[i];
+            if (!side.reader->next(inputs[i][0], inputs[i][1])) {
+                report << "stream ended early";
+                return true;
+            }
+            if (side.step) {
+                side.step(&side.state, inputs[i][0], inputs[i][1]);
+            } else if (side.reader->keyframe) {
+                side.state = *side.reader->keyframe;
+            }
+            full[i] = side.step || side.reader->keyframe;
+            hashed[i] = full[i] || side.reader->checked;
+            hashes[i] = side.step || !side.reader->checked ? hashMatchState(side.state) : side.reader->checkpointHash;
+        }
+        uint32_t tick = sides[0].reader->tick;
+        if (inputs[0][0] != inputs[1][0] || inputs[0][1] != inputs[1][1]) {
+            report << "not the same bout: the keys differ at tick " << tick;
+            return true;
+        }
+        bool same;
+        if (full[0] && full[1]) {
+            same = sameMatchState(sides[0].state, sides[1].state);
+        } else if (hashed[0] && hashed[1]) {
+            same = hashes[0] == hashes[1];
+        } else {
+            continue;
+        }
+
+        if (same && firstDiffered < 0) {
+            lastAgreed = tick;
+        } else if (!same && firstDiffered < 0) {
+            firstDiffered = tick;
+        }
+        // Past the first difference, only a point where both states are known for the field diff
+        if (firstDiffered >= 0 && full[0] && full[1]) {
+            diffed = true;
+            break;
+        }
+    }
+    if (firstDiffered < 0) firstDiffered = points.tick(high); // Only the final hashes differ
+
+    report << names[0] << " and " << names[1];
+    if (firstDiffered == lastAgreed + 1) {
+        report << " first differ at tick " << firstDiffered;
+    } else {
+        report << " first differ between ticks " << lastAgreed + 1 << " and " << firstDiffered << " (checkpoint interval)";
+    }
+    report << ", after agreeing at keyframe " << low << " (tick " << points.tick(low) << ")\n";
+    if (diffed) {
+        if (sides[0].reader->tick != static_cast<uint32_t>(firstDiffered)) report << "  at tick " << sides[0].reader->tick << ":\n";
+        printStateDiff(report, sides[0].state, sides[1].state);
+    } else {
+        // A recording keeps no state at its end, only the hash and the outcome
+        report << "  no snapshot to compare at the end:";
+        for (int i = 0; i < 2; ++i) {
+            const ReplayHeader& header = *sides[i].replay->header;
+            bool simulated = sides[i].step != nullptr;
+            uint64_t hash = simulated ? hashMatchState(sides[i].state) : header.finalHash;
+            int points1 = simulated ? sides[i].state.points[0] : header.points[0];
+            int points2 = simulated ? sides[i].state.points[1] : header.points[1];
+            report << (i == 0 ? " " : ", ") << names[i] << " hash " << std::hex << hash << std::dec << " points " << points1 << "-"
+                   << points2 << " at tick " << (simulated ? points.endTick : header.tickCount);
+        }
+        report << "\n";
+    }
+    return true;
+}
+
+// Replays matched to the replay of the same name under directory (or the one file given)
+static std::vector<std::string> pairReplays(const std::vector<std::string>& paths, const std::string& against) {
+    std::vector<std::string> partners(paths.size());
+    std::error_code error;
+    if (!std::filesystem::is_directory(against, error)) {
+        if (paths.size() == 1) partners[0] = against;
+        return partners;
+    }
+    std::map<std::string, std::string> byName;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(against, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == REPLAY_EXTENSION) {
+            byName[entry.path().filename().string()] = entry.path().string();
+        }
+    }
+    for (size_t i = 0; i < paths.size(); ++i) {
+        auto partner = byName.find(std::filesystem::path(paths[i]).filename().string());
+        if (partner != byName.end()) partners[i] = partner->second;
+    }
+    return partners;
+}
+
+// Finds where two builds part on each replay: the recording against this build, another build
+// (--engine) against this one, or two recordings of the same bouts (--against). Runs over whole
+// archives on every core without stopping; the exit code is 2 if any bout differs.
+int runBisect(int argc, char* argv[]) {
+    std::vector<std::string> paths = collectReplays(argc, argv, {"--threads", "--engine", "--against"});
+    int threads = threadOption(argc, argv);
+    std::string enginePath = stringOption(argc, argv, "--engine", "");
+    std::string against = stringOption(argc, argv, "--against", "");
+    if (paths.empty() || (!enginePath.empty() && !against.empty())) {
+        std::cerr << "Usage: FencingLab bisect <replay files or directories> [--engine other.so | --against replays] [--threads n]"
+                  << std::endl;
+        return 1;
+    }
+    SimEngine engine;
+    if (!enginePath.empty() && !engine.open(enginePath)) {
+        std::cerr << "bisect: " << enginePath << ": " << engine.error << std::endl;
+        return 1;
+    }
+    std::vector<std::string> partners;
+    if (!against.empty()) partners = pairReplays(paths, against);
+
+    std::string names[2] = {"recorded", "this build"};
+    if (!enginePath.empty()) names[0] = std::filesystem::path(enginePath).filename().string();
+
+    // Workers take whole files from a shared counter; each writes only its own report slots
+    std::vector<std::string> reports(paths.size());
+    std::vector<char> differs(paths.size(), 0);
+    std::atomic<size_t> nextFile{0};
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() {
+            MappedReplay replays[2];
+            for (size_t index = nextFile++; index < paths.size(); index = nextFile++) {
+                std::ostringstream report;
+                std::string files[2] = {paths[index], partners.empty() ? paths[index] : partners[index]};
+                if (files[1].empty()) {
+                    reports[index] = "no replay of the same name under " + against;
+                    differs[index] = 1;
+                    continue;
+                }
+                bool opened = true;
+                for (int side = 0; side < 2 && opened; ++side) {
+                    opened = replays[side].open(files[side], MAP_ACCESS_RANDOM);
+                    if (!opened) report << "unreadable, " << files[side] << ": " << replays[side].error;
+                }
+                if (opened) {
+                    BisectSide sides[2];
+                    sides[0].replay = &replays[0];
+                    sides[1].replay = &replays[1];
+                    sides[0].step = enginePath.empty() ? nullptr : engine.step;
+                    sides[1].step = against.empty() ? stepThisBuild : nullptr;
+                    std::string sideNames[2] = {names[0], names[1]};
+                    if (!against.empty()) {
+                        sideNames[0] = "this recording";
+                        sideNames[1] = files[1];
+                    }
+                    differs[index] = bisectReplay(sides, sideNames, report);
+                } else {
+                    differs[index] = 1;
+                }
+                replays[0].close();
+                replays[1].close();
+                reports[index] = report.str();
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    size_t differing = 0;
+    for (size_t index = 0; index < paths.size(); ++index) {
+        if (!differs[index]) continue;
+        differing++;
+        std::cout << paths[index] << ": " << reports[index];
+        if (reports[index].empty() || reports[index].back() != '\n') std::cout << "\n";
+    }
+    std::cout << paths.size() << " replays: " << differing << " differ or could not be compared" << std::endl;
+    return differing > 0 ? 2 : 0;
+}
@@ -0,0 +1,115 @@
+#include "book.h"
+#include "tablebase.h" // tablebaseCanonical
+#include <algorithm>
+
+int bookGapBucket(int gap) {
+    int start = SIM_START_X2 - SIM_START_X1;
+    int offset = gap - start;
+    // Round to the nearest bucket, symmetrically for negative offsets
+    int steps = offset >= 0 ? (offset + BOOK_GAP_STEP / 2) / BOOK_GAP_STEP : -((-offset + BOOK_GAP_STEP / 2) / BOOK_GAP_STEP);
+    return start / BOOK_GAP_STEP + steps;
+}
+
+int bookGap(int bucket) {
+    int start = SIM_START_X2 - SIM_START_X1;
+    return start - (start / BOOK_GAP_STEP - bucket) * BOOK_GAP_STEP;
+}
+
+size_t bookEntryCount() {
+    return static_cast<size_t>(2) * WEAPON_COUNT * BOOK_GAP_BUCKETS * ACTION_COUNT * ACTION_COUNT * BOOK_TIMER_BUCKETS;
+}
+
+size_t bookIndex(int side, int weapon, int gapBucket, int ownAction, int opponentAction, int timer) {
+    size_t index = static_cast<size_t>(side);
+    index = index * WEAPON_COUNT + weapon;
+    index = index * BOOK_GAP_BUCKETS + gapBucket;
+    index = index * ACTION_COUNT + ownAction;
+    index = index * ACTION_COUNT + opponentAction;
+    return index * BOOK_TIMER_BUCKETS + timer;
+}
+
+// The timer is the ticks into the opponent's action, or into the bot's own when the opponent is idle
+bool bookIndexFor(const MatchState& state, int side, size_t& index) {
+    const FencerState& own = state.fencers[side];
+    const FencerState& opponent = state.fencers[1 - side];
+    int gapBucket = bookGapBucket(state.fencers[1].x - state.fencers[0].x);
+    if (gapBucket < 0 || gapBucket >= BOOK_GAP_BUCKETS) return false;
+
+    const FencerState& timed = opponent.action != ACTION_IDLE ? opponent : own;
+    int timer = timed.action == ACTION_IDLE ? 0 : 1 + std::min(timed.actionTicks / BOOK_TIMER_STEP, BOOK_TIMER_BUCKETS - 2);
+    index = bookIndex(side, state.weapon, gapBucket, own.action, opponent.action, timer);
+    return true;
+}
+
+bool bookCanonical(const MatchState& state, int side) {
+    if (!tablebaseCanonical(state)) return false;
+    const FencerState& own = state.fencers[side];
+    const FencerState& opponent = state.fencers[1 - side];
+    // Only one phase is in the key: the opponent's when both are busy, so the bot's own must be 0
+    return own.action == ACTION_IDLE || opponent.action == ACTION_IDLE || own.actionTicks == 0;
+}
+
+bool bookState(size_t index, MatchState& state, int& side) {
+    int timer = static_cast<int>(index % BOOK_TIMER_BUCKETS);
+    index /= BOOK_TIMER_BUCKETS;
+    int opponentAction = static_cast<int>(index % ACTION_COUNT);
+    index /= ACTION_COUNT;
+    int ownAction = static_cast<int>(index % ACTION_COUNT);
+    index /= ACTION_COUNT;
+    int gapBucket = static_cast<int>(index % BOOK_GAP_BUCKETS);
+    index /= BOOK_GAP_BUCKETS;
+    int weapon = static_cast<int>(index % WEAPON_COUNT);
+    side = static_cast<int>(index / WEAPON_COUNT);
+
+    // Timer bucket 0 is exactly the states where nobody is busy
+    bool busy = ownAction != ACTION_IDLE || opponentAction != ACTION_IDLE;
+    int gap = bookGap(gapBucket);
+    if (busy != (timer > 0) || gap < 0 || gap > SIM_MAX_X) return false;
+
+    initMatch(state, static_cast<uint8_t>(weapon));
+    placeFencers(state, gap);
+    int ticks = (timer - 1) * BOOK_TIMER_STEP;
+    FencerState& own = state.fencers[side];
+    FencerState& opponent = state.fencers[1 - side];
+    own.action = static_cast<uint8_t>(ownAction);
+    opponent.action = static_cast<uint8_t>(opponentAction);
+    if (opponentAction != ACTION_IDLE) {
+        opponent.actionTicks = static_cast<uint8_t>(ticks);
+    } else if (ownAction != ACTION_IDLE) {
+        own.actionTicks = static_cast<uint8_t>(ticks);
+    }
+    return true;
+}
+
+bool OpeningBook::open(const std::string& path) {
+    close();
+    if (!file.open(path, sizeof(BookHeader), MAP_ACCESS_RANDOM)) {
+        error = file.error;
+        return false;
+    }
+
+    header = static_cast<const BookHeader*>(file.data);
+    if (header->magic != BOOK_MAGIC || header->version != BOOK_VERSION || header->entryCount != bookEntryCount() ||
+        file.size != sizeof(BookHeader) + header->entryCount) {
+        error = "not a version " + std::to_string(BOOK_VERSION) + " book for this build";
+        header = nullptr;
+        file.close();
+        return false;
+    }
+    moves = static_cast<const uint8_t*>(file.data) + sizeof(BookHeader);
+    error.clear();
+    return true;
+}
+
+void OpeningBook::close() {
+    file.close();
+    header = nullptr;
+    moves = nullptr;
+}
+
+int OpeningBook::lookup(const MatchState& state, int side) const {
+    size_t index;
+    if (!moves || !bookCanonical(state, side) || !bookIndexFor(state, side, index)) return -1;
+    uint8_t move = moves[index];
+    return move < MOVE_COUNT ? move : -1;
+}
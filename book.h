@@ -0,0 +1,54 @@
+// Opening/response book: the alpha-beta bot's best move for quantized (weapon, gap, own action,
+// opponent action, timer) states, searched offline by "FencingLab book" and memory-mapped by the
+// game, so a position on the book costs one table read instead of a search.
+#ifndef BOOK_H
+#define BOOK_H
+
+#include "simulation.h"
+#include "mappedfile.h"
+#include <string>
+
+#define BOOK_MAGIC 0x4b4f4246u // "FBOK"
+#define BOOK_VERSION 1
+#define BOOK_OFF 0xFF          // Entry value for a state the book has no answer for
+#define BOOK_GAP_STEP 8        // Pixels between gap buckets; the start gap falls exactly on one
+#define BOOK_GAP_BUCKETS (SIM_MAX_X / BOOK_GAP_STEP + 2)
+#define BOOK_TIMER_STEP 6      // Ticks between timer buckets
+#define BOOK_TIMER_BUCKETS (SIM_ACTION_TICKS / BOOK_TIMER_STEP + 1) // Bucket 0 is "nobody busy"
+
+// File layout: BookHeader, then one uint8_t move per entry, indexed by bookIndex
+struct BookHeader {
+    uint32_t magic = BOOK_MAGIC;
+    uint16_t version = BOOK_VERSION;
+    uint8_t stepTicks = 10;        // AlphaBetaConfig::stepTicks the moves were searched with
+    uint8_t depth = 0;             // Search depth, for the record
+    uint32_t entryCount = 0;
+    uint32_t reserved = 0;
+};
+static_assert(sizeof(BookHeader) == 16, "BookHeader is written as is");
+
+// Gap between the fencers' x positions, on the bucket grid
+int bookGapBucket(int gap);
+int bookGap(int bucket);
+size_t bookEntryCount();
+size_t bookIndex(int side, int weapon, int gapBucket, int ownAction, int opponentAction, int timer);
+// Index for a live state, or false if it lies outside the grid
+bool bookIndexFor(const MatchState& state, int side, size_t& index);
+// Whether state is one the book was searched from (bookState's): no keys held, no walk momentum, an
+// empty input history, and only the phase the key holds. Others are off-book, whatever their index.
+bool bookCanonical(const MatchState& state, int side);
+// The state a book entry stands for; false for combinations that cannot occur
+bool bookState(size_t index, MatchState& state, int& side);
+
+struct OpeningBook {
+    const BookHeader* header = nullptr;
+    const uint8_t* moves = nullptr;
+    std::string error;
+    MappedFile file;
+
+    bool open(const std::string& path);
+    void close();
+    int lookup(const MatchState& state, int side) const; // Macro move, or -1 when off-book or not canonical
+};
+
+#endif // BOOK_H
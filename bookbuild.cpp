@@ -0,0 +1,74 @@
+#include "book.h"
+#include "alphabeta.h"
+#include "lab.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <vector>
+
+// Searches every book entry to a fixed depth and writes the book
+int runBook(int argc, char* argv[]) {
+    AlphaBetaConfig config;
+    config.budgetMicros = INT_MAX; // Offline: always finish the fixed depth
+    config.maxDepth = intOption(argc, argv, "--depth", 4);
+    config.stepTicks = intOption(argc, argv, "--step-ticks", config.stepTicks);
+    std::string outPath = stringOption(argc, argv, "--out", "book.bin");
+    int threads = threadOption(argc, argv);
+
+    if (config.maxDepth < 1 || config.maxDepth > ALPHABETA_MAX_DEPTH || config.stepTicks < 1 || config.stepTicks > 255) {
+        std::cerr << "book: --depth must be 1-" << ALPHABETA_MAX_DEPTH << " and --step-ticks 1-255" << std::endl;
+        return 1;
+    }
+
+    BookHeader header;
+    header.stepTicks = static_cast<uint8_t>(config.stepTicks);
+    header.depth = static_cast<uint8_t>(config.maxDepth);
+    header.entryCount = static_cast<uint32_t>(bookEntryCount());
+    std::vector<uint8_t> moves(header.entryCount, BOOK_OFF);
+    std::cout << "Searching " << header.entryCount << " book entries, depth " << config.maxDepth << " x "
+              << config.stepTicks << " ticks, " << threads << " threads" << std::endl;
+
+    // Entries are handed out in chunks: neighbours differ only in the timer and cost about the same
+    auto start = std::chrono::steady_clock::now();
+    const size_t chunk = BOOK_TIMER_BUCKETS * ACTION_COUNT;
+    std::atomic<size_t> nextChunk{0};
+    std::vector<uint64_t> workerNodes(threads, 0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            AlphaBetaBot bots[2] = {AlphaBetaBot(0, config), AlphaBetaBot(1, config)};
+            for (size_t first = nextChunk++ * chunk; first < moves.size(); first = nextChunk++ * chunk) {
+                for (size_t index = first; index < std::min(first + chunk, moves.size()); ++index) {
+                    MatchState state;
+                    int side;
+                    if (!bookState(index, state, side)) continue;
+                    int depth;
+                    moves[index] = static_cast<uint8_t>(bots[side].decide(state, depth));
+                }
+            }
+            workerNodes[i] = bots[0].nodes + bots[1].nodes;
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t nodes = 0;
+    for (uint64_t count : workerNodes) nodes += count;
+    size_t onBook = 0;
+    for (uint8_t move : moves) onBook += move != BOOK_OFF;
+
+    std::ofstream out(outPath, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(moves.data()), static_cast<std::streamsize>(moves.size()));
+    if (!out) {
+        std::cerr << "book: cannot write " << outPath << std::endl;
+        return 1;
+    }
+
+    std::cout << onBook << " entries on the book, " << nodes << " nodes in " << seconds << " s; wrote " << outPath << " ("
+              << sizeof(header) + moves.size() << " bytes)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,7 @@
+// FencingBotHost: the process a sandboxed bot runs in (see sandbox.h). The game starts it; it is not
+// meant to be run by hand.
+#include "sandbox.h"
+
+int main(int argc, char* argv[]) {
+    return runBotHost(argc, argv);
+}
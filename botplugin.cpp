@@ -0,0 +1,100 @@
+#include "botplugin.h"
+#include <algorithm>
+#include <filesystem>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#ifdef _WIN32
+#define PLUGIN_EXTENSION ".dll"
+#elif defined(__APPLE__)
+#define PLUGIN_EXTENSION ".dylib"
+#else
+#define PLUGIN_EXTENSION ".so"
+#endif
+
+bool BotPlugin::open(const std::string& path) {
+    close();
+    this->path = path;
+    name = std::filesystem::path(path).stem().string();
+
+#ifdef _WIN32
+    HMODULE module = LoadLibraryA(path.c_str());
+    if (!module) {
+        error = "cannot load";
+        return false;
+    }
+    handle = module;
+    init = reinterpret_cast<PluginInitFunction>(GetProcAddress(module, "fencing_bot_init"));
+    decide = reinterpret_cast<PluginDecideFunction>(GetProcAddress(module, "fencing_bot_decide"));
+    shutdown = reinterpret_cast<PluginShutdownFunction>(GetProcAddress(module, "fencing_bot_shutdown"));
+#else
+    // RTLD_LOCAL keeps a plugin's own copy of the simulation from interposing on the game's
+    handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        const char* reason = dlerror();
+        error = reason ? reason : "cannot load";
+        return false;
+    }
+    init = reinterpret_cast<PluginInitFunction>(dlsym(handle, "fencing_bot_init"));
+    decide = reinterpret_cast<PluginDecideFunction>(dlsym(handle, "fencing_bot_decide"));
+    shutdown = reinterpret_cast<PluginShutdownFunction>(dlsym(handle, "fencing_bot_shutdown"));
+#endif
+
+    if (!init || !decide || !shutdown) {
+        error = "missing fencing_bot_init, fencing_bot_decide or fencing_bot_shutdown";
+        close();
+        return false;
+    }
+    error.clear();
+    return true;
+}
+
+void BotPlugin::close() {
+    if (handle) {
+#ifdef _WIN32
+        FreeLibrary(static_cast<HMODULE>(handle));
+#else
+        dlclose(handle);
+#endif
+        handle = nullptr;
+    }
+    init = nullptr;
+    decide = nullptr;
+    shutdown = nullptr;
+}
+
+bool PluginBot::begin(BotPlugin* plugin, int player) {
+    end();
+    this->plugin = plugin;
+    this->player = player;
+    context = plugin->init(FENCING_PLUGIN_ABI, player);
+    return context != nullptr;
+}
+
+void PluginBot::end() {
+    if (context) plugin->shutdown(context);
+    context = nullptr;
+}
+
+std::vector<std::unique_ptr<BotPlugin>> discoverPlugins(const std::string& directory, std::vector<std::string>& errors) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == PLUGIN_EXTENSION) paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<std::unique_ptr<BotPlugin>> plugins;
+    for (const std::string& path : paths) {
+        auto plugin = std::make_unique<BotPlugin>();
+        if (plugin->open(path)) {
+            plugins.push_back(std::move(plugin));
+        } else {
+            errors.push_back(path + ": " + plugin->error);
+        }
+    }
+    return plugins;
+}
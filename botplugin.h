@@ -0,0 +1,78 @@
+// Bot plugins: trusted in-house bots built as shared objects, found in plugins/ at startup and
+// loaded with dlopen (LoadLibrary on Windows). A plugin exports three C functions:
+//   void* fencing_bot_init(uint32_t abi, int player)       the bot's context, or null to refuse
+//   void fencing_bot_decide(void* bot, const MatchState* state, InputWord* input)   once per tick
+//   void fencing_bot_shutdown(void* bot)
+// decide reads the game's own MatchState in place and writes its keys straight back, so nothing is
+// copied or serialised per tick. That ties a plugin to this build's simulation.h: init is passed
+// FENCING_PLUGIN_ABI and should refuse any other value. Plugins run in the game's process; untrusted
+// bots belong in the sandbox (sandbox.h).
+#ifndef BOTPLUGIN_H
+#define BOTPLUGIN_H
+
+#include "simulation.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Bumped with any change to MatchState or the entry points; the size catches most forgotten bumps
+#define FENCING_PLUGIN_VERSION 1
+#define FENCING_PLUGIN_ABI ((FENCING_PLUGIN_VERSION << 16) | static_cast<uint32_t>(sizeof(MatchState)))
+#define PLUGIN_DIRECTORY "plugins"
+
+#ifdef _WIN32
+#define FENCING_PLUGIN_EXPORT extern "C" __declspec(dllexport)
+#else
+#define FENCING_PLUGIN_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+typedef void* (*PluginInitFunction)(uint32_t abi, int player);
+typedef void (*PluginDecideFunction)(void* bot, const MatchState* state, InputWord* input);
+typedef void (*PluginShutdownFunction)(void* bot);
+
+// One loaded shared object; each player it plays gets its own context from init
+struct BotPlugin {
+    std::string path;
+    std::string name;        // File name without the extension, for the menu
+    std::string error;
+    PluginInitFunction init = nullptr;
+    PluginDecideFunction decide = nullptr;
+    PluginShutdownFunction shutdown = nullptr;
+
+    BotPlugin() = default;
+    BotPlugin(const BotPlugin&) = delete;
+    BotPlugin& operator=(const BotPlugin&) = delete;
+    ~BotPlugin() { close(); }
+
+    bool open(const std::string& path); // Fails with error set if the file or an entry point is missing
+    void close();
+
+private:
+    void* handle = nullptr;
+};
+
+// A plugin playing one side; begin and end bracket a bout
+struct PluginBot {
+    BotPlugin* plugin = nullptr;
+    int player = 0;
+    void* context = nullptr;
+
+    PluginBot() = default;
+    PluginBot(const PluginBot&) = delete;
+    PluginBot& operator=(const PluginBot&) = delete;
+    ~PluginBot() { end(); }
+
+    bool begin(BotPlugin* plugin, int player); // False if the plugin refused, e.g. built for another ABI
+    void end();
+    bool active() const { return context != nullptr; }
+    InputWord update(const MatchState& state) {
+        InputWord input = 0;
+        plugin->decide(context, &state, &input);
+        return input;
+    }
+};
+
+// Every shared object in directory that opens as a plugin, sorted by name; failures go to errors
+std::vector<std::unique_ptr<BotPlugin>> discoverPlugins(const std::string& directory, std::vector<std::string>& errors);
+
+#endif // BOTPLUGIN_H
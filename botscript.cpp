@@ -0,0 +1,453 @@
+#include "botscript.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+const char* const FIELD_NAMES[FIELD_COUNT] = {
+    "gap", "own_x", "opp_x", "own_action", "opp_action", "own_ticks", "opp_ticks", "own_velocity", "opp_velocity",
+    "threat", "score", "period", "tick", "weapon", "predicted", "confidence"
+};
+
+static const char* const OP_NAMES[OP_COUNT] = {
+    "loadk", "mov", "field", "add", "sub", "mul", "div", "mod", "lt", "le", "eq", "ne", "not", "bool", "neg",
+    "random", "jmp", "jz", "jnz", "move", "press", "halt"
+};
+
+static const char* const KEY_NAMES[] = {"up", "down", "forward", "back", "attack"};
+
+struct ScriptToken {
+    std::string text; // Empty at the end of the input
+    int line;
+    bool number;
+};
+
+// Recursive-descent compiler: statements emit code directly, expressions return the register holding
+// their value. Variables own the low registers; temporaries are stacked above them and released
+// after every statement.
+struct ScriptCompiler {
+    ScriptProgram& program;
+    int player;
+    std::vector<ScriptToken> tokens;
+    size_t position = 0;
+    int nextTemp = 0;
+    std::string error;
+
+    ScriptCompiler(ScriptProgram& program, int player) : program(program), player(player) {}
+
+    const ScriptToken& peek() const { return tokens[position]; }
+    bool accept(const char* text) {
+        if (peek().number || peek().text != text) return false;
+        position++;
+        return true;
+    }
+    bool fail(const std::string& message) {
+        if (error.empty()) error = "line " + std::to_string(peek().line) + ": " + message;
+        return false;
+    }
+    bool expect(const char* text) {
+        return accept(text) || fail("expected \"" + std::string(text) + "\"" + (peek().text.empty() ? "" : " before \"" + peek().text + "\""));
+    }
+
+    bool tokenize(std::istream& in) {
+        std::string line;
+        for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+            line = line.substr(0, line.find('#'));
+            for (size_t i = 0; i < line.size();) {
+                unsigned char c = static_cast<unsigned char>(line[i]);
+                size_t start = i;
+                if (std::isspace(c)) {
+                    i++;
+                    continue;
+                }
+                if (std::isdigit(c)) {
+                    while (i < line.size() && std::isdigit(static_cast<unsigned char>(line[i]))) i++;
+                } else if (std::isalpha(c) || c == '_') {
+                    while (i < line.size() && (std::isalnum(static_cast<unsigned char>(line[i])) || line[i] == '_')) i++;
+                } else if (i + 1 < line.size() && line[i + 1] == '=' && std::string("<>=!").find(line[i]) != std::string::npos) {
+                    i += 2;
+                } else if (std::string("+-*/%<>=(){}").find(line[i]) != std::string::npos) {
+                    i++;
+                } else {
+                    error = "line " + std::to_string(lineNumber) + ": unexpected \"" + std::string(1, line[i]) + "\"";
+                    return false;
+                }
+                std::string text = line.substr(start, i - start);
+                if (std::isdigit(c) && text.size() > 9) {
+                    error = "line " + std::to_string(lineNumber) + ": number out of range";
+                    return false;
+                }
+                tokens.push_back({text, lineNumber, static_cast<bool>(std::isdigit(c))});
+            }
+        }
+        tokens.push_back({"", tokens.empty() ? 1 : tokens.back().line, false});
+        return true;
+    }
+
+    int emit(uint8_t op, int a = 0, int b = 0, int c = 0, int32_t k = 0) {
+        program.code.push_back({op, static_cast<uint8_t>(a), static_cast<uint8_t>(b), static_cast<uint8_t>(c), k});
+        return static_cast<int>(program.code.size()) - 1;
+    }
+    void patch(int instruction) { program.code[instruction].k = static_cast<int32_t>(program.code.size()); }
+
+    int temp() {
+        if (nextTemp >= SCRIPT_REGISTERS) {
+            fail("expression too deep");
+            return 0;
+        }
+        return nextTemp++;
+    }
+
+    int variable(const std::string& name) const {
+        for (size_t i = 0; i < program.variables.size(); ++i) {
+            if (program.variables[i] == name) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    bool isName(const ScriptToken& token) const {
+        return !token.number && !token.text.empty() && (std::isalpha(static_cast<unsigned char>(token.text[0])) || token.text[0] == '_');
+    }
+
+    int primary() {
+        ScriptToken token = peek();
+        if (token.number) {
+            position++;
+            int r = temp();
+            emit(OP_LOADK, r, 0, 0, std::stoi(token.text));
+            return r;
+        }
+        if (accept("(")) {
+            int r = expression();
+            expect(")");
+            return r;
+        }
+        if (!isName(token)) {
+            fail(token.text.empty() ? "unexpected end of script" : "unexpected \"" + token.text + "\"");
+            return 0;
+        }
+        position++;
+        if (token.text == "random") {
+            expect("(");
+            int bound = expression();
+            expect(")");
+            int r = temp();
+            emit(OP_RANDOM, r, bound);
+            return r;
+        }
+        int index = variable(token.text);
+        if (index >= 0) return index;
+        for (int field = 0; field < FIELD_COUNT; ++field) {
+            if (token.text != FIELD_NAMES[field]) continue;
+            int r = temp();
+            emit(OP_FIELD, r, 0, 0, field);
+            return r;
+        }
+        int action = actionFromName(token.text.c_str());
+        if (action >= 0) {
+            int r = temp();
+            emit(OP_LOADK, r, 0, 0, action);
+            return r;
+        }
+        fail("unknown name \"" + token.text + "\"");
+        return 0;
+    }
+
+    int unary() {
+        if (accept("-") || accept("not")) {
+            bool negate = tokens[position - 1].text == "-";
+            int operand = unary();
+            int r = temp();
+            emit(negate ? OP_NEG : OP_NOT, r, operand);
+            return r;
+        }
+        return primary();
+    }
+
+    int binary(int left, uint8_t op, int right, bool swap = false) {
+        int r = temp();
+        emit(op, r, swap ? right : left, swap ? left : right);
+        return r;
+    }
+
+    int product() {
+        int left = unary();
+        for (;;) {
+            uint8_t op = accept("*") ? OP_MUL : accept("/") ? OP_DIV : accept("%") ? OP_MOD : OP_COUNT;
+            if (op == OP_COUNT) return left;
+            left = binary(left, op, unary());
+        }
+    }
+
+    int sum() {
+        int left = product();
+        for (;;) {
+            uint8_t op = accept("+") ? OP_ADD : accept("-") ? OP_SUB : OP_COUNT;
+            if (op == OP_COUNT) return left;
+            left = binary(left, op, product());
+        }
+    }
+
+    // > and >= are < and <= with the operands swapped
+    int comparison() {
+        int left = sum();
+        if (accept("<")) return binary(left, OP_LT, sum());
+        if (accept("<=")) return binary(left, OP_LE, sum());
+        if (accept("==")) return binary(left, OP_EQ, sum());
+        if (accept("!=")) return binary(left, OP_NE, sum());
+        if (accept(">")) return binary(left, OP_LT, sum(), true);
+        if (accept(">=")) return binary(left, OP_LE, sum(), true);
+        return left;
+    }
+
+    // Short-circuit: the right side only runs when the left does not decide the result
+    int logical(bool isOr) {
+        int left = isOr ? logical(false) : comparison();
+        const char* word = isOr ? "or" : "and";
+        if (peek().number || peek().text != word) return left;
+        int r = temp();
+        emit(OP_BOOL, r, left);
+        while (accept(word)) {
+            int skip = emit(isOr ? OP_JNZ : OP_JZ, r);
+            emit(OP_BOOL, r, isOr ? logical(false) : comparison());
+            patch(skip);
+        }
+        return r;
+    }
+
+    int expression() { return logical(true); }
+
+    bool block() {
+        if (!expect("{")) return false;
+        while (!accept("}")) {
+            if (peek().text.empty()) return fail("missing \"}\"");
+            if (!statement()) return false;
+        }
+        return true;
+    }
+
+    bool statement() {
+        nextTemp = static_cast<int>(program.variables.size());
+        if (accept("var")) {
+            ScriptToken name = peek();
+            if (!isName(name)) return fail("expected a variable name");
+            position++;
+            if (variable(name.text) >= 0) return fail("\"" + name.text + "\" is already declared");
+            if (program.variables.size() >= SCRIPT_MAX_VARIABLES) return fail("too many variables");
+            if (!expect("=")) return false;
+            bool negative = accept("-");
+            if (!peek().number) return fail("a variable starts as a number");
+            program.variables.push_back(name.text);
+            program.initial.push_back((negative ? -1 : 1) * std::stoi(peek().text));
+            position++;
+            return true;
+        }
+        if (accept("if")) {
+            int condition = expression();
+            int skip = emit(OP_JZ, condition);
+            if (!block()) return false;
+            if (accept("else")) {
+                int end = emit(OP_JMP);
+                patch(skip);
+                if (accept("if")) {
+                    position--;
+                    if (!statement()) return false;
+                } else if (!block()) {
+                    return false;
+                }
+                patch(end);
+            } else {
+                patch(skip);
+            }
+            return error.empty();
+        }
+        if (accept("while")) {
+            int top = static_cast<int>(program.code.size());
+            int condition = expression();
+            int exit = emit(OP_JZ, condition);
+            if (!block()) return false;
+            emit(OP_JMP, 0, 0, 0, top);
+            patch(exit);
+            return error.empty();
+        }
+        if (accept("move")) {
+            for (int move = 0; move < MOVE_COUNT; ++move) {
+                if (peek().text != MOVE_NAMES[move]) continue;
+                position++;
+                emit(OP_MOVE, 0, 0, 0, move);
+                return true;
+            }
+            return fail("unknown move \"" + peek().text + "\"");
+        }
+        if (accept("press")) {
+            InputWord keys[] = {INPUT_UP, INPUT_DOWN, forwardInput(player), backInput(player), INPUT_ATTACK};
+            for (int key = 0; key < 5; ++key) {
+                if (peek().text != KEY_NAMES[key]) continue;
+                position++;
+                emit(OP_PRESS, 0, 0, 0, keys[key]);
+                return true;
+            }
+            return fail("unknown key \"" + peek().text + "\"");
+        }
+        if (accept("stop")) {
+            emit(OP_HALT);
+            return true;
+        }
+
+        ScriptToken name = peek();
+        int target = isName(name) ? variable(name.text) : -1;
+        if (target < 0) return fail(isName(name) ? "\"" + name.text + "\" is not a declared variable" : "expected a statement");
+        position++;
+        if (!expect("=")) return false;
+        int value = expression();
+        emit(OP_MOV, target, value);
+        return error.empty();
+    }
+};
+
+bool ScriptProgram::load(const std::string& path, int player, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot read";
+        return false;
+    }
+    return compile(in, player, error);
+}
+
+bool ScriptProgram::compile(std::istream& in, int player, std::string& error) {
+    ScriptProgram compiled;
+    ScriptCompiler compiler(compiled, player);
+    bool ok = compiler.tokenize(in);
+    while (ok && !compiler.peek().text.empty()) ok = compiler.statement() && compiler.error.empty();
+    if (!ok) {
+        error = compiler.error;
+        return false;
+    }
+    compiled.code.push_back({OP_HALT, 0, 0, 0, 0});
+
+    *this = std::move(compiled);
+    error.clear();
+    return true;
+}
+
+std::string ScriptProgram::disassemble() const {
+    std::ostringstream out;
+    for (size_t i = 0; i < code.size(); ++i) {
+        const ScriptInstr& instr = code[i];
+        out << i << "\t" << OP_NAMES[instr.op] << "\t" << static_cast<int>(instr.a) << " " << static_cast<int>(instr.b) << " "
+            << static_cast<int>(instr.c) << " " << instr.k;
+        if (instr.op == OP_FIELD) out << "\t; " << FIELD_NAMES[instr.k];
+        if (instr.op == OP_MOVE) out << "\t; " << MOVE_NAMES[instr.k];
+        out << "\n";
+    }
+    return out.str();
+}
+
+void ScriptBot::reset() {
+    std::fill(registers, registers + SCRIPT_REGISTERS, 0);
+    std::copy(program.initial.begin(), program.initial.end(), registers);
+    rng = SimRandom(seedFor(1, static_cast<uint64_t>(player)));
+    runner.reset();
+    wantedMove = MOVE_HOLD;
+}
+
+// VM_CASE labels a handler and VM_NEXT charges one instruction and dispatches the next, through a
+// label table with GCC and Clang and through a switch elsewhere
+#if defined(__GNUC__)
+#define VM_CASE(name) vm_##name:
+#define VM_NEXT()                     \
+    do {                              \
+        if (--budgetLeft < 0) goto overrun; \
+        instr = code + pc++;          \
+        goto* dispatch[instr->op];    \
+    } while (0)
+#else
+#define VM_CASE(name) case name:
+#define VM_NEXT() goto next
+#endif
+
+InputWord ScriptBot::update(const MatchState& state) {
+    const FencerState& own = state.fencers[player];
+    const FencerState& opponent = state.fencers[1 - player];
+    int forward = player == 0 ? 1 : -1;
+    const ScriptInstr* code = program.code.data();
+    const ScriptInstr* instr;
+    int32_t* r = registers;
+    int pc = 0;
+    int budgetLeft = budget;
+    InputWord pressed = 0;
+
+#if defined(__GNUC__)
+    static void* const dispatch[OP_COUNT] = {
+        &&vm_OP_LOADK, &&vm_OP_MOV, &&vm_OP_FIELD, &&vm_OP_ADD, &&vm_OP_SUB, &&vm_OP_MUL, &&vm_OP_DIV, &&vm_OP_MOD,
+        &&vm_OP_LT, &&vm_OP_LE, &&vm_OP_EQ, &&vm_OP_NE, &&vm_OP_NOT, &&vm_OP_BOOL, &&vm_OP_NEG, &&vm_OP_RANDOM,
+        &&vm_OP_JMP, &&vm_OP_JZ, &&vm_OP_JNZ, &&vm_OP_MOVE, &&vm_OP_PRESS, &&vm_OP_HALT};
+    VM_NEXT();
+#else
+next:
+    if (--budgetLeft < 0) goto overrun;
+    instr = code + pc++;
+    switch (instr->op) {
+#endif
+
+    VM_CASE(OP_LOADK) r[instr->a] = instr->k; VM_NEXT();
+    VM_CASE(OP_MOV) r[instr->a] = r[instr->b]; VM_NEXT();
+    VM_CASE(OP_FIELD) {
+        int32_t value = 0;
+        switch (instr->k) {
+        case FIELD_GAP: value = fencerDistance(state); break;
+        case FIELD_OWN_X: value = own.x; break;
+        case FIELD_OPP_X: value = opponent.x; break;
+        case FIELD_OWN_ACTION: value = own.action; break;
+        case FIELD_OPP_ACTION: value = opponent.action; break;
+        case FIELD_OWN_TICKS: value = own.actionTicks; break;
+        case FIELD_OPP_TICKS: value = opponent.actionTicks; break;
+        case FIELD_OWN_VELOCITY: value = own.velocityX * forward; break;
+        case FIELD_OPP_VELOCITY: value = -opponent.velocityX * forward; break;
+        case FIELD_THREAT: value = simIntersects(fencerHitbox(state, 1 - player), fencerHurtbox(state, player)); break;
+        case FIELD_SCORE: value = state.points[player] - state.points[1 - player]; break;
+        case FIELD_PERIOD: value = state.period; break;
+        case FIELD_TICK: value = static_cast<int32_t>(state.tick); break;
+        case FIELD_WEAPON: value = state.weapon; break;
+        default: {
+            float probability = 0;
+            int action = model ? model->likelyAction(probability) : ACTION_IDLE;
+            value = instr->k == FIELD_PREDICTED ? action : static_cast<int32_t>(probability * 100);
+            break;
+        }
+        }
+        r[instr->a] = value;
+        VM_NEXT();
+    }
+    // Wrapping arithmetic, so overflow in a script is not undefined behaviour in the game
+    VM_CASE(OP_ADD) r[instr->a] = static_cast<int32_t>(static_cast<uint32_t>(r[instr->b]) + static_cast<uint32_t>(r[instr->c])); VM_NEXT();
+    VM_CASE(OP_SUB) r[instr->a] = static_cast<int32_t>(static_cast<uint32_t>(r[instr->b]) - static_cast<uint32_t>(r[instr->c])); VM_NEXT();
+    VM_CASE(OP_MUL) r[instr->a] = static_cast<int32_t>(static_cast<uint32_t>(r[instr->b]) * static_cast<uint32_t>(r[instr->c])); VM_NEXT();
+    VM_CASE(OP_DIV) r[instr->a] = r[instr->c] == 0 || (r[instr->c] == -1 && r[instr->b] == INT32_MIN) ? 0 : r[instr->b] / r[instr->c]; VM_NEXT();
+    VM_CASE(OP_MOD) r[instr->a] = r[instr->c] == 0 || r[instr->c] == -1 ? 0 : r[instr->b] % r[instr->c]; VM_NEXT();
+    VM_CASE(OP_LT) r[instr->a] = r[instr->b] < r[instr->c]; VM_NEXT();
+    VM_CASE(OP_LE) r[instr->a] = r[instr->b] <= r[instr->c]; VM_NEXT();
+    VM_CASE(OP_EQ) r[instr->a] = r[instr->b] == r[instr->c]; VM_NEXT();
+    VM_CASE(OP_NE) r[instr->a] = r[instr->b] != r[instr->c]; VM_NEXT();
+    VM_CASE(OP_NOT) r[instr->a] = !r[instr->b]; VM_NEXT();
+    VM_CASE(OP_BOOL) r[instr->a] = r[instr->b] != 0; VM_NEXT();
+    VM_CASE(OP_NEG) r[instr->a] = static_cast<int32_t>(0u - static_cast<uint32_t>(r[instr->b])); VM_NEXT();
+    VM_CASE(OP_RANDOM) r[instr->a] = r[instr->b] > 0 ? rng.below(r[instr->b]) : 0; VM_NEXT();
+    VM_CASE(OP_JMP) pc = instr->k; VM_NEXT();
+    VM_CASE(OP_JZ) if (!r[instr->a]) pc = instr->k; VM_NEXT();
+    VM_CASE(OP_JNZ) if (r[instr->a]) pc = instr->k; VM_NEXT();
+    VM_CASE(OP_MOVE) wantedMove = instr->k; VM_NEXT();
+    VM_CASE(OP_PRESS) pressed |= static_cast<InputWord>(instr->k); VM_NEXT();
+    VM_CASE(OP_HALT) goto done;
+
+#if !defined(__GNUC__)
+    }
+#endif
+
+overrun:
+    overruns++;
+    budgetLeft = 0;
+done:
+    instructions += static_cast<uint64_t>(budget - budgetLeft);
+    return static_cast<InputWord>(runner.next(wantedMove, state, player) | pressed);
+}
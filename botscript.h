@@ -0,0 +1,115 @@
+// User-written bots: a small script language compiled to register bytecode and run by a sandboxed VM
+// once per tick. Scripts see the match only through read-only fields and can only pick a macro move
+// and press keys, and every tick stops after SCRIPT_TICK_BUDGET instructions, so a bad script costs a
+// bounded slice of the frame. Dispatch uses computed gotos where the compiler supports them.
+//
+// Syntax (newlines are not significant, "#" starts a comment):
+//   var streak = 0                 persistent variable, set to the constant on reset
+//   streak = streak + 1            + - * / % < <= == != >= > and or not, parentheses
+//   if gap < 150 and opp_action == attack { move parry_mid } else if gap > 120 { move advance }
+//   while n > 0 { n = n - 1 }
+//   move parry_mid                 macro move from MOVE_NAMES, played as the other bots play it
+//   press attack                   up, down, forward, back or attack, held for this tick
+//   stop                           end the tick
+// Fields: gap, own_x, opp_x, own_action, opp_action, own_ticks, opp_ticks, own_velocity,
+// opp_velocity (positive towards the opponent), threat, score, period, tick, weapon, predicted (the
+// opponent model's most likely next action, idle without a model) and confidence (its percent);
+// action names are constants; random(n) is 0 to n - 1.
+#ifndef BOTSCRIPT_H
+#define BOTSCRIPT_H
+
+#include "simulation.h"
+#include "opponentmodel.h"
+#include <istream>
+#include <string>
+#include <vector>
+
+#define SCRIPT_REGISTERS 256
+#define SCRIPT_MAX_VARIABLES 128    // The rest of the registers hold temporaries
+#define SCRIPT_TICK_BUDGET 2000     // Instructions per tick before the script is cut off
+
+enum ScriptOp : uint8_t {
+    OP_LOADK,   // r[a] = k
+    OP_MOV,     // r[a] = r[b]
+    OP_FIELD,   // r[a] = field k of the match, from the bot's side
+    OP_ADD,     // r[a] = r[b] + r[c], and likewise below
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,     // Division and remainder by zero give zero
+    OP_MOD,
+    OP_LT,
+    OP_LE,
+    OP_EQ,
+    OP_NE,
+    OP_NOT,     // r[a] = !r[b]
+    OP_BOOL,    // r[a] = r[b] != 0
+    OP_NEG,
+    OP_RANDOM,  // r[a] = random below r[b]
+    OP_JMP,     // Jump to instruction k
+    OP_JZ,      // Jump to k if r[a] == 0
+    OP_JNZ,
+    OP_MOVE,    // Macro move k
+    OP_PRESS,   // Hold InputBits k (already turned for the bot's side) this tick
+    OP_HALT,
+    OP_COUNT
+};
+
+enum ScriptField : uint8_t {
+    FIELD_GAP,
+    FIELD_OWN_X,
+    FIELD_OPP_X,
+    FIELD_OWN_ACTION,
+    FIELD_OPP_ACTION,
+    FIELD_OWN_TICKS,
+    FIELD_OPP_TICKS,
+    FIELD_OWN_VELOCITY,
+    FIELD_OPP_VELOCITY,
+    FIELD_THREAT,
+    FIELD_SCORE,
+    FIELD_PERIOD,
+    FIELD_TICK,
+    FIELD_WEAPON,
+    FIELD_PREDICTED,
+    FIELD_CONFIDENCE,
+    FIELD_COUNT
+};
+extern const char* const FIELD_NAMES[FIELD_COUNT];
+
+struct ScriptInstr {
+    uint8_t op;
+    uint8_t a, b, c;
+    int32_t k;
+};
+static_assert(sizeof(ScriptInstr) == 8, "ScriptInstr is packed into eight bytes");
+
+// A compiled script, shared by every bot running it. OP_PRESS operands depend on the side, so a
+// program is compiled for one player.
+struct ScriptProgram {
+    std::vector<ScriptInstr> code;   // Ends with OP_HALT
+    std::vector<int32_t> initial;    // Starting values of the variables, registers 0 up
+    std::vector<std::string> variables;
+
+    bool load(const std::string& path, int player, std::string& error);
+    bool compile(std::istream& in, int player, std::string& error);
+    std::string disassemble() const;
+};
+
+struct ScriptBot {
+    const ScriptProgram& program;
+    int player;
+    int budget = SCRIPT_TICK_BUDGET;
+    const OpponentModel* model = nullptr; // Watching the other player, for predicted/confidence
+    int32_t registers[SCRIPT_REGISTERS] = {};
+    SimRandom rng{1};
+    MoveRunner runner;
+    int wantedMove = MOVE_HOLD;    // Kept between ticks until the script picks another
+    uint64_t instructions = 0;
+    uint64_t overruns = 0;         // Ticks cut off by the budget
+
+    ScriptBot(const ScriptProgram& program, int player) : program(program), player(player) { reset(); }
+
+    InputWord update(const MatchState& state); // Call once per tick
+    void reset();
+};
+
+#endif // BOTSCRIPT_H
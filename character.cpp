@@ -9,6 +9,11 @@
 #include <SDL_ttf.h>
 
 
+// Convert the shared geometry from simulation.cpp to an SDL rectangle
+static SDL_Rect toSDLRect(const SimRect& rect) {
+    return {rect.x, rect.y, rect.w, rect.h};
+}
+
 std::unordered_map<SDL_Keycode, std::string> player1KeyMappings;
 std::unordered_map<SDL_Keycode, std::string> player2KeyMappings;
 /**
@@ -79,62 +84,9 @@ void Character::setAction(const std::string& action) {
             // Activate the parry hitbox
             parryLowHitboxActive = true;
 
-            // Calculate the hitbox position based on the action and player's facing direction
-            int hitboxWidth = 50;  // Width of the parry hitbox
-            int hitboxHeight = 50; // Height of the parry hitbox
-
-            if (action == "parry_low") {
-                // Position for parry_low
-                if (flip) {
-                    parryLowHitbox = {
-                        positionRect.x - hitboxWidth, // Left of the player's texture
-                        positionRect.y + positionRect.h / 2, // Lower bottom-half of the texture
-                        hitboxWidth,
-                        hitboxHeight
-                    };
-                } else {
-                    parryLowHitbox = {
-                        positionRect.x + positionRect.w, // Right of the player's texture
-                        positionRect.y + positionRect.h / 2, // Lower bottom-half of the texture
-                        hitboxWidth,
-                        hitboxHeight
-                    };
-                }
-            } else if (action == "parry_high") {
-                // Position for parry_high (opposite of parry_low)
-                if (flip) {
-                    parryLowHitbox = {
-                        positionRect.x - hitboxWidth, // Left of the player's texture
-                        positionRect.y, // Upper half of the texture
-                        hitboxWidth,
-                        hitboxHeight
-                    };
-                } else {
-                    parryLowHitbox = {
-                        positionRect.x + positionRect.w, // Right of the player's texture
-                        positionRect.y, // Upper half of the texture
-                        hitboxWidth,
-                        hitboxHeight
-                    };
-                }
-            } else if (action == "parry_mid") {
-                // Position for parry_mid (centered vertically)
-                if (flip) {
-                    parryLowHitbox = {            
-                        hurtbox.x - hitboxWidth, // Left of the hurtbox
-                        hurtbox.y + (hurtbox.h - hitboxHeight) / 2, // Center vertically relative to the hurtbox
-                        hitboxWidth,
-                        hitboxHeight
-                    };
-                } else {
-                    parryLowHitbox = {
-                        hurtbox.x + hurtbox.w, // Right of the hurtbox
-                        hurtbox.y + (hurtbox.h - hitboxHeight) / 2, // Center vertically relative to the hurtbox
-                        hitboxWidth,
-                        hitboxHeight
-                    };
-                }
-            }
+            // Place the parry hitbox in front of the player (see parryBoxAt in simulation.cpp)
+            int weapon = weaponFromName(weaponType.c_str());
+            parryLowHitbox = toSDLRect(parryBoxAt(actionFromName(action.c_str()), x, y, flip ? 1 : 0, weapon < 0 ? WEAPON_EPEE : weapon));
 
             if (action == "strike_lowhigh" || action == "strike_highlow") {
                 std::cout << action << " activated!" << std::endl;
@@ -161,23 +113,6 @@ void Character::setAction(const std::string& action) {
     }
 }
 
-void Character::handleInput(const SDL_Event& event, const std::unordered_map<SDL_Keycode, std::string>& keyMappings) {
-    if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
-        auto it = keyMappings.find(event.key.keysym.sym);
-        if (it != keyMappings.end()) {
-            const std::string& action = it->second;
-            if (event.type == SDL_KEYDOWN) {
-                if (action == "left") velocityX = -6; // Move left
-                else if (action == "right") velocityX = 6; // Move right
-                else if (action == "attack") setAction("attack");
-            } else if (event.type == SDL_KEYUP) {
-                if (action == "left" || action == "right") velocityX = 0; // Stop movement
-                else if (action == "attack") setAction("idle");
-            }
-        }
-    }
-}
-
 // void Character::initializePosition(bool isPlayer1, int windowWidth, int windowHeight) {
 //     if (isPlayer1) {
 //         // Player 1 starts on the left side of the screen
@@ -189,25 +124,6 @@ void Character::handleInput(const SDL_Event& event, const std::unordered_map<SDL
 //         y = windowHeight - 300; // Bottom of the screen
 //     }
 // }
-void Character::move(int windowWidth, int windowHeight, float deltaTime) {
-    // Debug: Log velocity and position before updating
-    std::cout << "Before move: x = " << x << ", velocityX = " << velocityX << std::endl;
-
-    // Update position based on velocity
-    x += velocityX * deltaTime;
-
-    // Ensure the character stays within the window bounds
-    if (x < 0) x = 0;
-    if (x + positionRect.w > windowWidth) x = windowWidth - positionRect.w;
-
-    // Update the positionRect to reflect the new position
-    positionRect.x = x;
-    positionRect.y = y; // Y-axis remains constant
-
-    // Debug: Log position after updating
-    std::cout << "After move: x = " << x << std::endl;
-}
-
 void Character::render(INITSDL& sdlContext) {
     // Render the current action's texture
     if (actionTextures.find(currentAction) != actionTextures.end()) {
@@ -243,289 +159,49 @@ void Character::setWeaponType(const std::string& type) {
 }
 
 void Character::initializeHurtbox() {
-    int textureWidth = 300;  // Width of the player's texture
-    int textureHeight = 300; // Height of the player's texture
-
-    if (weaponType == "Epee") {
-        // Default hurtbox dimensions
-        if (!flip) {
-            // Player 1: Place hurtbox to the left of the center
-            hurtbox = {
-                x + (textureWidth / 4) - 75, // Offset to the left of the center
-                y + (textureHeight - 200) / 2, // Center vertically
-                150, // Width of the hurtbox
-                200  // Height of the hurtbox
-            };
-        } else {
-            // Player 2: Place hurtbox to the right of the center
-            hurtbox = {
-                x + (textureWidth * 3 / 4) - 75, // Offset to the right of the center
-                y + (textureHeight - 200) / 2, // Center vertically
-                150, // Width of the hurtbox
-                200  // Height of the hurtbox
-            };
-        }
-    } else if (weaponType == "Sabre") {
-        // Sabre hurtbox: half the height, same width, higher on the Y-axis
-        if (!flip) {
-            // Player 1: Place hurtbox to the left of the center
-            hurtbox = {
-                x + (textureWidth / 4) - 75, // Offset to the left of the center
-                y + (textureHeight - 150) / 2 - 25, // Center vertically and move higher
-                150, // Width of the hurtbox
-                150  // Height of the hurtbox
-            };
-        } else {
-            // Player 2: Place hurtbox to the right of the center
-            hurtbox = {
-                x + (textureWidth * 3 / 4) - 75, // Offset to the right of the center
-                y + (textureHeight - 150) / 2 - 25, // Center vertically and move higher
-                150, // Width of the hurtbox
-                150  // Height of the hurtbox
-            };
-        }
+    // Epee and Sabre hurtboxes are defined in hurtboxAt (simulation.cpp)
+    int weapon = weaponFromName(weaponType.c_str());
+    if (weapon >= 0) {
+        hurtbox = toSDLRect(hurtboxAt(x, y, flip ? 1 : 0, weapon));
     }
 }
 
-void Character::activateHitbox() {
-    if (flip) {
-        hitbox = {x - 50, y + 100, 50, 50}; // Example dimensions for left-facing attack
-    } else {
-        hitbox = {x + 150, y + 100, 50, 50}; // Example dimensions for right-facing attack
-    }
-}
-
-void Character::deactivateHitbox() {
-    hitbox = {0, 0, 0, 0}; // Reset hitbox dimensions
-}
-
-void Character::updateCollisionBoxes() {
-    int textureWidth = 300;  // Width of the player's texture
-    int textureHeight = 300; // Height of the player's texture
-
-    // Update hurtbox position dynamically
-    if (weaponType == "Epee") {
-        if (!flip) {
-            hurtbox = {
-                x + (textureWidth / 4) - 75,
-                y + (textureHeight - 200) / 2,
-                150,
-                200
-            };
-        } else {
-            hurtbox = {
-                x + (textureWidth * 3 / 4) - 75,
-                y + (textureHeight - 200) / 2,
-                150,
-                200
-            };
-        }
-    } else if (weaponType == "Sabre") {
-        if (!flip) {
-            hurtbox = {
-                x + (textureWidth / 4) - 75,
-                y + (textureHeight - 150) / 2 - 25,
-                150,
-                150
-            };
-        } else {
-            hurtbox = {
-                x + (textureWidth * 3 / 4) - 75,
-                y + (textureHeight - 150) / 2 - 25,
-                150,
-                150
-            };
-        }
-    }
-
-    // Debug: Log hurtbox position
-    std::cout << "Hurtbox Position: (" << hurtbox.x << ", " << hurtbox.y << ")" << std::endl;
-
-    // Update hitbox based on the current action
-    if (currentAction == "attack") {
-        activateHitbox(); // Activate and position the hitbox during attack
-    } else {
-        deactivateHitbox(); // Deactivate the hitbox for non-attack actions
-    }
-}
-bool Character::checkCollision(const SDL_Rect& otherBox) const {
-    return SDL_HasIntersection(&hitbox, &otherBox);
-}
-
-void Character::handleCollision(Character& opponent) {
-    // Check if the hitboxes of both players intersect
-    if (SDL_HasIntersection(&hitbox, &opponent.hitbox)) {
-        std::cout << "Hitbox collision detected between players!" << std::endl;
-
-        // Apply knockback to both players
-        if (!flip) { // Player 1 is facing right
-            x -= 6; // Knock Player 1 to the left
-            opponent.x += 6; // Knock Player 2 to the right
-        } else { // Player 1 is facing left
-            x += 6; // Knock Player 1 to the right
-            opponent.x -= 6; // Knock Player 2 to the left
-        }
-
-        // Ensure players stay within screen boundaries
-        if (x < 0) x = 0;
-        if (x + positionRect.w > SCREEN_WIDTH) x = SCREEN_WIDTH - positionRect.w;
-
-        if (opponent.x < 0) opponent.x = 0;
-        if (opponent.x + opponent.positionRect.w > SCREEN_WIDTH) opponent.x = SCREEN_WIDTH - opponent.positionRect.w;
-
-        // Update the positionRect for both players
-        positionRect.x = x;
-        opponent.positionRect.x = opponent.x;
-    }
-}
-
-void Character::updateState(Character& opponent) {
-    Uint32 currentTime = SDL_GetTicks();
-
-    // Handle strike_lowhigh and strike_highlow logic
-    if (currentAction == "strike_lowhigh" || currentAction == "strike_highlow") {
-        // Transition to the next frame after 500ms
-        if (currentTime - frameStartTime > 500 && currentFrameIndex < animationFrames.size() - 1) {
-            currentFrameIndex++;
-            frameStartTime = currentTime; // Reset the frame start time
-        }
-
-        // Update the hitbox based on the current frame
-        if (currentAction == "strike_lowhigh") {
-            if (currentFrameIndex == 0) {
-                // Frame 1: Hitbox occupies the lower half of the texture
-                hitbox = {
-                    positionRect.x,
-                    positionRect.y + positionRect.h / 2,
-                    positionRect.w,
-                    positionRect.h / 2
-                };
-            } else if (currentFrameIndex == 1) {
-                // Frame 2: Hitbox's Y-axis value is the center of the texture
-                hitbox = {
-                    positionRect.x,
-                    positionRect.y + positionRect.h / 2 - hitbox.h / 2,
-                    positionRect.w,
-                    hitbox.h
-                };
-            }
-        } else if (currentAction == "strike_highlow") {
-            if (currentFrameIndex == 0) {
-                // Frame 1: Hitbox is the same as Frame 2 of strike_lowhigh
-                hitbox = {
-                    positionRect.x,
-                    positionRect.y + positionRect.h / 2 - hitbox.h / 2,
-                    positionRect.w,
-                    hitbox.h
-                };
-            } else if (currentFrameIndex == 1) {
-                // Frame 2: Hitbox is the same as Frame 1 of strike_lowhigh
-                hitbox = {
-                    positionRect.x,
-                    positionRect.y + positionRect.h / 2,
-                    positionRect.w,
-                    positionRect.h / 2
-                };
-            }
-        }
-
-        // Reset to idle after the animation ends
-        if (currentTime - actionStartTime > 1000) { // 1 second duration
-            resetToIdle();
-        }
-    }
-
-    // Reset the current action to "idle" after a specific duration for other actions
-    if (currentAction != "idle" && currentTime - actionStartTime > 1000) { // 1000 ms = 1 second
-        resetToIdle();
-        parryLowHitboxActive = false; // Deactivate the hitbox if active
-    }
+// Takes position, action and boxes from the simulation instead of from input and SDL_GetTicks
+void Character::showState(const MatchState& state, int player) {
+    const FencerState& fencer = state.fencers[player];
+    x = fencer.x;
+    y = SIM_GROUND_Y;
+    positionRect.x = x;
+    positionRect.y = y;
+    velocityX = fencer.velocityX;
+    currentAction = ACTION_NAMES[fencer.action];
+    // Strike frames, as in updateState; otherwise the index is the walk cycle's, advanced by playMovementAnimation
+    if (fencer.action == ACTION_STRIKE_LOWHIGH || fencer.action == ACTION_STRIKE_HIGHLOW) {
+        currentFrameIndex = fencer.actionTicks >= SIM_STRIKE_FRAME_TICKS ? 1 : 0;
+    }
+    hurtbox = toSDLRect(fencerHurtbox(state, player));
+    hitbox = toSDLRect(fencerHitbox(state, player));
+    parryLowHitboxActive = fencerParrying(fencer);
+    if (parryLowHitboxActive) parryLowHitbox = toSDLRect(fencerParryBox(state, player));
 }
-void Character::processInputBuffer(InputBuffer& buffer) {
-    // Handle "left" input
-    if (buffer.left) {
-        velocityX = -6; // Move left
-        buffer.leftFrames = 0;
-    } else if (buffer.leftFrames < 2) {
-        buffer.leftFrames++;
-    } else {
-        buffer.left = false; // Reset input after 2 frames
-        if (!buffer.right) velocityX = 0; // Stop horizontal movement if no other input is active
-    }
 
-    // Handle "right" input
-    if (buffer.right) {
-        velocityX = 6; // Move right
-        buffer.rightFrames = 0;
-    } else if (buffer.rightFrames < 2) {
-        buffer.rightFrames++;
+// The walk cycle while a fencer moves, its action's sprite otherwise; forward is towards the opponent
+void Character::renderState(INITSDL& app, const MatchState& state, int player) {
+    const FencerState& fencer = state.fencers[player];
+    showState(state, player);
+    if (fencer.action == ACTION_IDLE && fencer.velocityX != 0) {
+        bool forward = player == 0 ? fencer.velocityX > 0 : fencer.velocityX < 0;
+        playMovementAnimation(app.renderer, !forward);
     } else {
-        buffer.right = false; // Reset input after 2 frames
-        if (!buffer.left) velocityX = 0; // Stop horizontal movement if no other input is active
-    }
-
-    // Handle "up" input
-    if (buffer.up) {
-        // For jumping or other actions if needed
+        render(app);
     }
-
-    // Handle "down" input
-    if (buffer.down) {
-        // For crouching or other actions if needed
-    }
-
-    // Handle "attack" input
-    if (buffer.attack) {
-        setAction("attack");
-        buffer.attackFrames = 0;
-    } else if (buffer.attackFrames < 2) {
-        buffer.attackFrames++;
-    } else {
-        buffer.attack = false; // Reset input after 2 frames
-    }
-
-    // Handle parry input (check combinations)
-    // handleParry(buffer);
-
-    // Debug: Log the updated velocities
-    std::cout << "Updated velocityX: " << velocityX << std::endl;
 }
 
-
-void Character::resetToIdle() {
-    // Ensure the current action has completed before resetting to idle
-    Uint32 currentTime = SDL_GetTicks();
-    if (currentAction != "idle" && currentTime - actionStartTime > 1000) { // 1 second duration
-        setAction("idle");
-    }
+void Character::deactivateHitbox() {
+    hitbox = {0, 0, 0, 0}; // Reset hitbox dimensions
 }
 
 // Use player1Score and player2Score as needed
-void Character::manageGamePeriods(Uint32& periodStartTime, int& currentPeriod, bool& suddenDeath, bool& running) {
-    Uint32 elapsedTime = SDL_GetTicks() - periodStartTime;
-    if (currentPeriod <= 3 && elapsedTime >= 180000) { // 3 minutes per period
-        if (currentPeriod < 3) {
-            currentPeriod++;
-            periodStartTime = SDL_GetTicks(); // Reset timer for the next period
-            std::cout << "Period " << currentPeriod << " started." << std::endl;
-        } else {
-            if (player1Score == player2Score) {
-                suddenDeath = true; // Enter sudden-death mode
-                std::cout << "Sudden death started." << std::endl;
-            } else {
-                running = false; // End the game
-                std::cout << "Game over!" << std::endl;
-            }
-        }
-    }
-
-    // Handle sudden death
-    if (suddenDeath && (player1Score > player2Score || player2Score > player1Score)) {
-        running = false; // End the game when a player scores in sudden death
-        std::cout << "Game over!" << std::endl;
-    }
-}
-
 // Add rendering logic for scores, period, and timer
 void Character::renderGameInfo(SDL_Renderer* renderer, TTF_Font* font, int currentPeriod, Uint32 elapsedTime) {
     SDL_Color scoreColor = {255, 255, 255, 255}; // White color for text
@@ -577,49 +253,6 @@ void Character::renderGameInfo(SDL_Renderer* renderer, TTF_Font* font, int curre
     }
 }
 
-void Character::preventOverlap(Character& opponent) {
-    if (SDL_HasIntersection(&hurtbox, &opponent.hurtbox)) {
-        // If this player is moving right and collides with the opponent
-        if (velocityX > 0 && x + hurtbox.w > opponent.x) {
-            x = opponent.x - hurtbox.w; // Stop this player to the left of the opponent
-        }
-        // If this player is moving left and collides with the opponent
-        else if (velocityX < 0 && x < opponent.x + opponent.hurtbox.w) {
-            x = opponent.x + opponent.hurtbox.w; // Stop this player to the right of the opponent
-        }
-    }
-}
-
-void Character::updatePosition(Character& opponent) {
-
-    // Calculate next position
-    int nextX = x + velocityX;
-
-    // Create a temporary hurtbox for the next position
-    SDL_Rect nextHurtbox = {nextX + 25, y + 50, hurtbox.w, hurtbox.h};
-
-    // Check for collision with the opponent's hurtbox
-    if (SDL_HasIntersection(&nextHurtbox, &opponent.hurtbox)) {
-        // Stop horizontal movement if collision is detected
-        if (velocityX > 0 && nextX + hurtbox.w > opponent.x) {
-            velocityX = 0;
-        } else if (velocityX < 0 && nextX < opponent.x + opponent.hurtbox.w) {
-            velocityX = 0;
-        }
-    }
-
-    // Update position based on velocity
-    x += velocityX;
-
-    // Ensure the player stays within the screen boundaries
-    if (x < 0) x = 0;
-    if (x + 150 > SCREEN_WIDTH) x = SCREEN_WIDTH - 150;
-
-    // Update collision boxes and state
-    updateCollisionBoxes();
-    updateState(opponent); // Pass the opponent to updateState
-}
-
 void Character::loadAnimationFrames(const std::string& animationName, const std::vector<std::string>& framePaths, SDL_Renderer* renderer) {
     for (const auto& path : framePaths) {
         SDL_Texture* texture = IMG_LoadTexture(renderer, path.c_str());
@@ -634,18 +267,21 @@ void Character::loadAnimationFrames(const std::string& animationName, const std:
 }
 
 void Character::playMovementAnimation(SDL_Renderer* renderer, bool reverse) { // more dynamic movement animation
+    if (forwardAnimationFrames.empty()) return; // Frames failed to load
+
+    // currentFrameIndex is shared with the strike animations, so it may be past the last forward frame
+    int frameCount = static_cast<int>(forwardAnimationFrames.size());
+    if (currentFrameIndex < 0 || currentFrameIndex >= frameCount) currentFrameIndex = 0;
+
     if (SDL_GetTicks() - lastFrameTime > frameDelay) {
         if (reverse) {
-            currentFrameIndex = (currentFrameIndex - 1 + forwardAnimationFrames.size()) % forwardAnimationFrames.size();
+            currentFrameIndex = (currentFrameIndex - 1 + frameCount) % frameCount;
         } else {
-            currentFrameIndex = (currentFrameIndex + 1) % forwardAnimationFrames.size();
+            currentFrameIndex = (currentFrameIndex + 1) % frameCount;
         }
         lastFrameTime = SDL_GetTicks();
     }
 
-    // Update the hurtbox dynamically
-    updateCollisionBoxes();
-
     // Render the current animation frame
     positionRect.x = x; // Update positionRect with the current position
     positionRect.y = y;
@@ -680,8 +316,9 @@ void Character::reset() {
     // Reset hurtbox
     initializeHurtbox();
 
-    // Reset action to idle
-    resetToIdle();
+    // Reset action to idle, even if the action has not finished yet (after a touch)
+    setAction("idle");
+    parryLowHitboxActive = false;
 
     // Reset animation frame index
     currentFrameIndex = 0;
@@ -819,96 +456,6 @@ void Character::trackInput(const std::string& input, Uint32 timestamp) {
 //     SDL_RenderCopyEx(renderer, texture, nullptr, &destRect, 0.0, nullptr, sdlFlip);
 // }
 
-std::vector<Command> player1Commands = {
-    {"parry_low", {"up", "left", "attack"}, 1000}, // Up, Back, Attack within 1 second
-    {"parry_high", {"down", "left", "attack"}, 1000}, // Down, Back, Attack within 1 second
-    {"parry_mid", {"left", "attack"}, 1000}, // Back, Attack within 1 second
-    {"strike_lowhigh", {"down", "attack"}, 1000}, // Strike Low-High for Player 1
-    {"strike_highlow", {"up", "attack"}, 1000},   // Strike High-Low for Player 1
-};
-
-std::vector<Command> player2Commands = {
-    {"parry_low", {"up", "right", "attack"}, 1000}, // Up, Forward, Attack within 1 second
-    {"parry_high", {"down", "right", "attack"}, 1000}, // Down, Forward, Attack within 1 second
-    {"parry_mid", {"right", "attack"}, 1000}, // Forward, Attack within 1 second
-    {"strike_lowhigh", {"down", "attack"}, 1000},  // Strike Low-High for Player 2
-    {"strike_highlow", {"up", "attack"}, 1000},    // Strike High-Low for Player 2
-};
-
-bool matchCommand(const InputHistory& history, const Command& command) {
-    std::cout << "Matching command: " << command.name << std::endl;
-    std::cout << "Required inputs: ";
-    for (const auto& input : command.requiredInputs) {
-        std::cout << input << " ";
-    }
-    std::cout << std::endl;
-
-    if (history.inputs.empty()) {
-        std::cout << "Input history is empty." << std::endl;
-        return false;
-    }
-
-    for (const auto& input : command.requiredInputs) {
-        auto it = std::find_if(history.inputs.begin(), history.inputs.end(), [&](const auto& pair) {
-            return pair.first == input;
-        });
-
-        if (it == history.inputs.end()) {
-            std::cout << "Input missing for command: " << command.name << ", required: " << input << std::endl;
-            return false;
-        }
-    }
-
-    auto earliest = std::min_element(history.inputs.begin(), history.inputs.end(), [](const auto& a, const auto& b) {
-        return a.second < b.second;
-    });
-
-    auto latest = std::max_element(history.inputs.begin(), history.inputs.end(), [](const auto& a, const auto& b) {
-        return a.second < b.second;
-    });
-
-    if (latest->second - earliest->second > command.maxTimeGap) {
-        std::cout << "Inputs for command " << command.name << " are too far apart in time." << std::endl;
-        return false;
-    }
-
-    std::cout << "Command matched: " << command.name << std::endl;
-    return true;
-}
-
-void processInput(const SDL_Event& event, InputHistory& history, const std::vector<Command>& commands, Character& character, const std::unordered_map<SDL_Keycode, std::string>& keyMappings) {
-    if (event.type == SDL_KEYDOWN) {
-        auto it = keyMappings.find(event.key.keysym.sym);
-        if (it != keyMappings.end()) {
-            const std::string& input = it->second;
-            history.addInput(input); // Add input to the player's history
-
-            // Check for matching commands
-            bool commandMatched = false;
-            for (const auto& command : commands) {
-                if (matchCommand(history, command)) {
-                    std::cout << "Matched Command: " << command.name << std::endl;
-                    character.setAction(command.name); // Trigger the command action
-                    commandMatched = true;
-                }
-            }
-
-            // Clear history only if a command was matched
-            if (commandMatched) {
-                history.clear();
-            }
-        }
-    }
-}
-
-void debugInputHistory(const InputHistory& history) {
-    std::cout << "Input History: ";
-    for (const auto& [input, timestamp] : history.inputs) {
-        std::cout << input << " ";
-    }
-    std::cout << std::endl;
-}
-
 std::string Character::getCurrentAction() const {
     return currentAction;
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
     #include <functional>
     #include <algorithm>
     #include <SDL_ttf.h>
+    #include "simulation.h" // Action timings and collision boxes shared with the headless tools
 
     struct InputBuffer;
     struct INITSDL;
@@ -57,9 +58,6 @@
         // Member functions
         void loadTexture(const std::string& action, const char* filename);
         void setAction(const std::string& action);
-        void handleInput(const SDL_Event& event, const std::unordered_map<SDL_Keycode, std::string>& keyMappings);
-        void processInputBuffer(InputBuffer& buffer);
-        void move(int windowWidth, int windowHeight, float deltaTime);
         void render(INITSDL& sdlContext);
         void cleanup();
         void reset();
@@ -71,18 +69,12 @@
         void cleanupAnimationFrames();
 
         // Hurtbox and hitbox management
-        void activateHitbox();
         void deactivateHitbox();
-        void updateCollisionBoxes();
-        bool checkCollision(const SDL_Rect& otherBox) const;
-        void handleCollision(Character& opponent);
-        void updateState(Character& opponent);
-        void resetToIdle();
-        void preventOverlap(Character& opponent);
-        void updatePosition(Character& opponent);
         void setWeaponType(const std::string& type);
         void initializeHurtbox();
         void initializePosition(bool isPlayer1, int windowWidth, int windowHeight);
+        void showState(const MatchState& state, int player); // Pose of a headless match, e.g. a replay, for render()
+        void renderState(INITSDL& app, const MatchState& state, int player); // showState, then the walk cycle while moving or render()
 
         // Command inputs handle
         void trackInput(const std::string& input, Uint32 timestamp);
@@ -94,8 +86,7 @@
         void updatePosition(float deltaTime);
         void renderCurrentAction(SDL_Renderer* renderer);
 
-        // Game period and rendering logic
-        void manageGamePeriods(Uint32& periodStartTime, int& currentPeriod, bool& suddenDeath, bool& running);
+        // Rendering logic
         void renderGameInfo(SDL_Renderer* renderer, TTF_Font* font, int currentPeriod, Uint32 elapsedTime);
         void loadActionTexturesForParry(const std::string& action, SDL_Renderer* renderer);
         float dashDistanceRemaining = 0; // Distance remaining for the "Dash Thrust"
@@ -120,42 +111,5 @@
     extern std::unordered_map<SDL_Keycode, std::string> player1KeyMappings;
     extern std::unordered_map<SDL_Keycode, std::string> player2KeyMappings;
 
-    struct Command {
-        std::string name; // Name of the command (e.g., "parry_low")
-        std::vector<std::string> requiredInputs; // Input sequence (e.g., {"down", "attack"})
-        Uint32 maxTimeGap; // Maximum time gap between inputs (in milliseconds)
-    };
-
-    struct InputHistory {
-        std::deque<std::pair<std::string, Uint32>> inputs; // Input and timestamp
-        size_t maxSize = 10; // Limit the size of the history
-        Uint32 maxInputAge = 2000; // Maximum age of inputs in milliseconds
-
-        void addInput(const std::string& input) {
-            Uint32 currentTime = SDL_GetTicks();
-            inputs.push_back({input, currentTime});
-            if (inputs.size() > maxSize) {
-                inputs.pop_front(); // Remove the oldest input if history exceeds maxSize
-            }
-            removeStaleInputs(currentTime); // Remove inputs older than maxInputAge
-        }
-
-        void removeStaleInputs(Uint32 currentTime) {
-            while (!inputs.empty() && currentTime - inputs.front().second > maxInputAge) {
-                inputs.pop_front(); // Remove inputs that are too old
-            }
-        }
-
-        void clear() {
-            inputs.clear();
-        }
-    };
-
-    void processInput(const SDL_Event& event, InputHistory& history, const std::vector<Command>& commands, Character& character, const std::unordered_map<SDL_Keycode, std::string>& keyMappings);
-    bool matchCommand(const InputHistory& history, const Command& command);
-    void debugInputHistory(const InputHistory& history);
-    extern std::vector<Command> player1Commands;
-    extern std::vector<Command> player2Commands;
-
 
     #endif
\ No newline at end of file
@@ -85,25 +85,6 @@ void InputBuffer::clear() {
 // int player1Score = 0;
 // int player2Score = 0;
 
-void processPlayerInput(SDL_Event& event, std::deque<std::string>& inputBuffer, const std::unordered_map<SDL_Keycode, std::string>& keyMappings) {
-    if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
-        bool isKeyDown = (event.type == SDL_KEYDOWN);
-        auto it = keyMappings.find(event.key.keysym.sym);
-        if (it != keyMappings.end()) {
-            const std::string& action = it->second;
-            if (isKeyDown) {
-                inputBuffer.push_back(action); // Add input to the buffer
-                if (inputBuffer.size() > 10) {
-                    inputBuffer.pop_front(); // Limit buffer size to 10
-                }
-                std::cout << "Input added: " << action << std::endl;
-            }
-        }
-    }
-}
-
-
-
 bool InputBuffer::parryUpInput(bool flip) const {
     return flip ? (up && right) : (up && left); // back + up
 }
@@ -116,6 +97,12 @@ bool InputBuffer::parryMidInput(bool flip) const {
     return left && right; // both directions
 }
 
+// Held keys as an InputWord for the headless match (simulation.h)
+InputWord InputBuffer::inputWord() const {
+    return static_cast<InputWord>((up ? INPUT_UP : 0) | (down ? INPUT_DOWN : 0) | (left ? INPUT_LEFT : 0) |
+                                  (right ? INPUT_RIGHT : 0) | (attack ? INPUT_ATTACK : 0));
+}
+
 void renderWinningScreen(SDL_Renderer* renderer, TTF_Font* font, const std::string& winner) {
     SDL_Color textColor = {255, 255, 255, 255}; // White text
     std::string message;
@@ -145,18 +132,12 @@ void renderWinningScreen(SDL_Renderer* renderer, TTF_Font* font, const std::stri
     }
 }
 
-void handleRoundEnd(Character& winner, Character& loser, Character& player1, Character& player2, int& player1Points, int& player2Points, Uint32& periodStartTime) {
-    // Deduct a point from the losing player
-    if (&loser == &player1) {
-        player1Points--; // Deduct a point from Player 1
-    } else if (&loser == &player2) {
-        player2Points--; // Deduct a point from Player 2
-    }
+void handleRoundEnd(const MatchState& match, Character& player1, Character& player2, int& player1Points, int& player2Points) {
+    // The match has already taken the point and put the fencers back on guard (awardTouch)
+    player1Points = match.points[0];
+    player2Points = match.points[1];
 
-    // Reset players to their initial positions
+    // Reset the sprites to their initial positions
     player1.reset();
     player2.reset();
-
-    // Reset the timer for the next round
-    periodStartTime = SDL_GetTicks();
-}
\ No newline at end of file
+}
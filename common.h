@@ -11,14 +11,11 @@
 #include <functional>
 #include <vector>
 #include <deque>
+#include "simulation.h" // SCREEN_WIDTH, SCREEN_HEIGHT and the headless match rules
 // #include "character.h"
 
 struct Character;
 
-// Declare constants
-#define SCREEN_WIDTH 854
-#define SCREEN_HEIGHT 480
-
 // Declare functions
 SDL_Texture* LOADTEXTURE(const char* filename, SDL_Renderer* renderer);
 void ERRORMSG(const char* msg, const char* err);
@@ -109,6 +106,7 @@ struct InputBuffer {
     bool parryUpInput(bool flip) const;
     bool parryDownInput(bool flip) const;
     bool parryMidInput(bool flip) const;
+    InputWord inputWord() const;
 };
 
 // Declare global variables for player scores
@@ -118,7 +116,6 @@ extern int player2Score;
 extern int player1Points; // Declare as extern
 extern int player2Points; // Declare as extern
 
-void processPlayerInput(SDL_Event& event, std::deque<std::string>& inputBuffer, const std::unordered_map<SDL_Keycode, std::string>& keyMappings);
 void renderWinningScreen(SDL_Renderer* renderer, TTF_Font* font, const std::string& winner);
-void handleRoundEnd(Character& winner, Character& loser, Character& player1, Character& player2, int& player1Points, int& player2Points, Uint32& periodStartTime);
+void handleRoundEnd(const MatchState& match, Character& player1, Character& player2, int& player1Points, int& player2Points); // After a touch stepMatch reported
 #endif // COMMON_H
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "compress.h"
+#include <cstring>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Ticks of keys[0..15] whose keys differ from the tick before, one bit each; keys[-1] must exist
+static uint32_t runStarts(const uint16_t* keys) {
+#if defined(__AVX2__) && defined(__BMI2__)
+    __m256i now = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+    __m256i before = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys - 1));
+    uint32_t same = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(now, before)));
+    return _pext_u32(~same, 0x55555555u); // Two mask bits a tick
+#elif defined(__SSE2__)
+    uint32_t starts = 0;
+    for (int half = 0; half < 2; ++half) {
+        __m128i now = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + 8 * half));
+        __m128i before = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + 8 * half - 1));
+        __m128i changed = _mm_packs_epi16(_mm_cmpeq_epi16(now, before), _mm_setzero_si128());
+        starts |= (~static_cast<uint32_t>(_mm_movemask_epi8(changed)) & 0xFF) << (8 * half);
+    }
+    return starts;
+#else
+    uint32_t starts = 0;
+    for (int i = 0; i < 16; ++i) starts |= static_cast<uint32_t>(keys[i] != keys[i - 1]) << i;
+    return starts;
+#endif
+}
+
+// Three bytes are always stored, so the length of the varint is the only thing that varies
+static uint8_t* putRun(uint8_t* out, uint32_t ticks, uint16_t keys) {
+    uint32_t value = (ticks - 1) << 10 | keys;
+    uint32_t bytes = 1 + (value >= 0x80) + (value >= 0x4000);
+    out[0] = static_cast<uint8_t>((value & 0x7F) | (bytes > 1) << 7);
+    out[1] = static_cast<uint8_t>((value >> 7 & 0x7F) | (bytes > 2) << 7);
+    out[2] = static_cast<uint8_t>(value >> 14);
+    return out + bytes;
+}
+
+uint8_t* InputRunEncoder::addAll(const uint16_t* keys, size_t count, uint8_t* out) {
+    size_t i = 0;
+    if (count > 0) out = add(keys[i++], out); // From here keys[i - 1] is the open run's
+    // Sixteen ticks at a time: a branch per run ended rather than per tick
+    for (; i + 16 <= count; i += 16) {
+        uint32_t starts = runStarts(keys + i);
+        uint32_t counted = 0;      // Ticks of the block already in a run
+        while (starts) {
+            uint32_t start = static_cast<uint32_t>(__builtin_ctz(starts));
+            starts &= starts - 1;
+            ticks += start - counted;
+            while (ticks > INPUT_RUN_MAX_TICKS) {
+                out = putRun(out, INPUT_RUN_MAX_TICKS, this->keys);
+                ticks -= INPUT_RUN_MAX_TICKS;
+            }
+            out = putRun(out, ticks, this->keys);
+            this->keys = keys[i + start];
+            ticks = 1;
+            counted = start + 1;
+        }
+        ticks += 16 - counted;
+    }
+    for (; i < count; ++i) out = add(keys[i], out);
+    // The open run stays open, but add() and flush() only code runs up to the limit
+    while (ticks > INPUT_RUN_MAX_TICKS) {
+        out = putRun(out, INPUT_RUN_MAX_TICKS, this->keys);
+        ticks -= INPUT_RUN_MAX_TICKS;
+    }
+    return out;
+}
+
+const uint8_t* getInputRuns(const uint8_t* in, const uint8_t* end, uint16_t* out, size_t count) {
+    uint16_t* last = out + count;
+    while (out < last) {
+        uint16_t keys;
+        uint32_t ticks;
+        in = getInputRun(in, end, keys, ticks);
+        if (!in || ticks > static_cast<size_t>(last - out)) return nullptr;
+        // Eight at once covers most runs; the spare room takes what a short run leaves over
+        uint64_t pattern = keys * 0x0001000100010001ULL;
+        std::memcpy(out, &pattern, sizeof(pattern));
+        std::memcpy(out + 4, &pattern, sizeof(pattern));
+        for (uint32_t t = 8; t < ticks; ++t) out[t] = keys;
+        out += ticks;
+    }
+    return in;
+}
+
+uint8_t* encodeStateDelta(const MatchState& previous, const MatchState& state, uint8_t* out) {
+    uint16_t before[STATE_WORDS];
+    uint16_t after[STATE_WORDS];
+    std::memcpy(before, &previous, sizeof(MatchState));
+    std::memcpy(after, &state, sizeof(MatchState));
+    for (size_t i = 0; i < STATE_WORDS; ++i) {
+        uint16_t delta = before[i] ^ after[i];
+        if (delta < 0x80) {
+            *out++ = static_cast<uint8_t>(delta); // Most words, most ticks: the branch the loop expects
+        } else {
+            out = putVarint(out, delta);
+        }
+    }
+    return out;
+}
+
+const uint8_t* decodeStateDelta(const uint8_t* in, const uint8_t* end, const MatchState& previous, MatchState& state) {
+    uint16_t words[STATE_WORDS];
+    std::memcpy(words, &previous, sizeof(MatchState));
+    for (size_t i = 0; i < STATE_WORDS; ++i) {
+        if (in != end && *in < 0x80) {
+            words[i] ^= *in++;
+            continue;
+        }
+        uint32_t delta;
+        in = getVarint(in, end, delta);
+        if (!in || delta > 0xFFFF) return nullptr;
+        words[i] ^= static_cast<uint16_t>(delta);
+    }
+    std::memcpy(static_cast<void*>(&state), words, sizeof(MatchState));
+    return in;
+}
+
+const MatchState& zeroState() {
+    static const MatchState zero = [] {
+        MatchState state;
+        std::memset(static_cast<void*>(&state), 0, sizeof(state));
+        return state;
+    }();
+    return zero;
+}
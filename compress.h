@@ -0,0 +1,111 @@
+// Stream codecs for replays and state streams: LEB128 varints, run-length coded key pairs and match
+// states XOR-delta coded against the previous one. Every coder keeps only the last value it saw, so
+// a stream of any length encodes and decodes in constant memory.
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include "simulation.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#define VARINT_MAX_BYTES 5                 // A uint32_t, 7 bits a byte
+#define STATE_WORDS (sizeof(MatchState) / sizeof(uint16_t))
+#define STATE_DELTA_MAX_BYTES (STATE_WORDS * 3) // Every 16-bit word changed in its top bits
+#define INPUT_RUN_MAX_BYTES 3              // A run of up to 2048 ticks
+
+static_assert(sizeof(MatchState) % sizeof(uint16_t) == 0, "States are coded in whole words");
+static_assert(std::is_trivially_copyable<MatchState>::value, "States are coded byte for byte");
+
+inline uint8_t* putVarint(uint8_t* out, uint32_t value) {
+    if (value < 0x4000 && value >= 0x80) {
+        out[0] = static_cast<uint8_t>(value | 0x80);
+        out[1] = static_cast<uint8_t>(value >> 7);
+        return out + 2;
+    }
+    while (value >= 0x80) {
+        *out++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+    return out;
+}
+
+// Reads a varint of at most VARINT_MAX_BYTES without running past end; nullptr if it does
+inline const uint8_t* getVarint(const uint8_t* in, const uint8_t* end, uint32_t& value) {
+    // Runs and most state deltas take one or two bytes
+    if (end - in >= 2 && in[1] < 0x80) {
+        if (in[0] < 0x80) {
+            value = in[0];
+            return in + 1;
+        }
+        value = (in[0] & 0x7F) | static_cast<uint32_t>(in[1]) << 7;
+        return in + 2;
+    }
+    value = 0;
+    for (int shift = 0; in != end && shift < 7 * VARINT_MAX_BYTES; shift += 7) {
+        uint8_t byte = *in++;
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (byte < 0x80) return in;
+    }
+    return nullptr;
+}
+
+// Both players' keys in one value: player 1 in bits 0-4, player 2 in bits 5-9
+inline uint16_t packInputs(InputWord player1Input, InputWord player2Input) {
+    return static_cast<uint16_t>((player1Input & 0x1F) | (player2Input & 0x1F) << 5);
+}
+
+// A run is one varint, (ticks - 1) << 10 | keys: two bytes up to 16 ticks, three up to 2048. Callers
+// end runs with flush() where they need a boundary, and must before INPUT_RUN_MAX_TICKS.
+#define INPUT_RUN_MAX_TICKS 2048
+struct InputRunEncoder {
+    uint16_t keys = 0;
+    uint32_t ticks = 0;            // Length of the open run, 0 if none
+
+    // Writes the previous run to out when keys change; returns the end of what was written
+    uint8_t* add(uint16_t keys, uint8_t* out) {
+        if (ticks > 0 && keys == this->keys) {
+            ticks++;
+            return out;
+        }
+        out = flush(out);
+        this->keys = keys;
+        ticks = 1;
+        return out;
+    }
+    // add() for a whole array of key pairs, without a branch per tick: every tick writes the open run
+    // and only a change of keys keeps it. out needs INPUT_RUN_MAX_BYTES to spare past what is coded.
+    uint8_t* addAll(const uint16_t* keys, size_t count, uint8_t* out);
+    uint8_t* flush(uint8_t* out) {
+        if (ticks == 0) return out;
+        out = putVarint(out, (ticks - 1) << 10 | keys);
+        ticks = 0;
+        return out;
+    }
+};
+
+// Reads one run written by InputRunEncoder; nullptr if it runs past end
+inline const uint8_t* getInputRun(const uint8_t* in, const uint8_t* end, uint16_t& keys, uint32_t& ticks) {
+    uint32_t run;
+    in = getVarint(in, end, run);
+    if (!in) return nullptr;
+    keys = static_cast<uint16_t>(run & 0x3FF);
+    ticks = (run >> 10) + 1;
+    return in;
+}
+
+// Decodes runs until count key pairs are out; out needs 8 to spare past count. nullptr if the runs
+// stop short of count or run past end
+const uint8_t* getInputRuns(const uint8_t* in, const uint8_t* end, uint16_t* out, size_t count);
+
+// XOR of each 16-bit word of state with the same word of previous, as varints: an unchanged word
+// takes one byte. Returns the end of what was written, at most STATE_DELTA_MAX_BYTES on.
+uint8_t* encodeStateDelta(const MatchState& previous, const MatchState& state, uint8_t* out);
+// Inverse of encodeStateDelta; nullptr if the delta runs past end
+const uint8_t* decodeStateDelta(const uint8_t* in, const uint8_t* end, const MatchState& previous, MatchState& state);
+
+// All-zero state that the first state of a stream is coded against
+const MatchState& zeroState();
+
+#endif // COMPRESS_H
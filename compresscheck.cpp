@@ -0,0 +1,97 @@
+#include "compress.h"
+#include "fuzz.h"
+#include "lab.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Throughput in GB/s of the uncompressed side, the best of a few passes
+template <typename Pass>
+static double throughput(size_t bytes, int passes, Pass pass) {
+    double best = 0.0;
+    for (int i = 0; i < passes; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        pass();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::max(best, bytes / seconds / 1e9);
+    }
+    return best;
+}
+
+// Codes the key pairs and per-tick match states of random-input bouts with the replay codecs, checks
+// they decode to the same values and reports the ratio and speed of each direction
+int runCompress(int argc, char* argv[]) {
+    int bouts = intOption(argc, argv, "--bouts", 20);
+    int maxTicks = intOption(argc, argv, "--max-ticks", (SIM_PERIODS + 1) * SIM_PERIOD_TICKS);
+    int passes = intOption(argc, argv, "--passes", 5);
+    uint64_t seed = static_cast<uint64_t>(intOption(argc, argv, "--seed", 1));
+
+    std::vector<uint16_t> inputs;
+    std::vector<MatchState> states;
+    for (int bout = 0; bout < bouts; ++bout) {
+        FuzzCase fuzzCase = generateFuzzCase(seedFor(seed, static_cast<uint64_t>(bout)), static_cast<size_t>(maxTicks));
+        MatchState state;
+        initMatch(state, fuzzCase.weapon);
+        placeFencers(state, fuzzCase.distance);
+        for (size_t t = 0; t < fuzzCase.ticks() && !state.over; ++t) {
+            stepMatch(state, fuzzCase.inputs[0][t], fuzzCase.inputs[1][t]);
+            inputs.push_back(packInputs(fuzzCase.inputs[0][t], fuzzCase.inputs[1][t]));
+            states.push_back(state);
+        }
+    }
+    size_t ticks = inputs.size();
+    std::cout << bouts << " bouts, " << ticks << " ticks" << std::endl;
+
+    // Key pairs, as one stream of runs
+    std::vector<uint8_t> packed(ticks * INPUT_RUN_MAX_BYTES + INPUT_RUN_MAX_BYTES);
+    size_t packedBytes = 0;
+    double encodeSpeed = throughput(ticks * sizeof(uint16_t), passes, [&]() {
+        InputRunEncoder encoder;
+        uint8_t* out = encoder.addAll(inputs.data(), ticks, packed.data());
+        out = encoder.flush(out);
+        packedBytes = static_cast<size_t>(out - packed.data());
+    });
+    std::vector<uint16_t> unpacked(ticks + 8);
+    bool inputsMatch = false;
+    double decodeSpeed = throughput(ticks * sizeof(uint16_t), passes, [&]() {
+        const uint8_t* end = packed.data() + packedBytes;
+        inputsMatch = getInputRuns(packed.data(), end, unpacked.data(), ticks) == end;
+    });
+    inputsMatch = inputsMatch && std::equal(inputs.begin(), inputs.end(), unpacked.begin());
+    std::cout << "Key pairs: " << ticks * sizeof(uint16_t) << " -> " << packedBytes << " bytes ("
+              << static_cast<double>(packedBytes) / ticks << " per tick), encode " << encodeSpeed << " GB/s, decode "
+              << decodeSpeed << " GB/s, " << (inputsMatch ? "decoded exactly" : "DECODED WRONG") << std::endl;
+
+    // Match states, each a delta of the tick before
+    std::vector<uint8_t> deltas(ticks * STATE_DELTA_MAX_BYTES);
+    size_t deltaBytes = 0;
+    size_t stateBytes = ticks * sizeof(MatchState);
+    encodeSpeed = throughput(stateBytes, passes, [&]() {
+        uint8_t* out = deltas.data();
+        const MatchState* previous = &zeroState();
+        for (size_t t = 0; t < ticks; ++t) {
+            out = encodeStateDelta(*previous, states[t], out);
+            previous = &states[t];
+        }
+        deltaBytes = static_cast<size_t>(out - deltas.data());
+    });
+    std::vector<MatchState> decoded(ticks);
+    bool statesMatch = false;
+    decodeSpeed = throughput(stateBytes, passes, [&]() {
+        const uint8_t* in = deltas.data();
+        const uint8_t* end = in + deltaBytes;
+        const MatchState* previous = &zeroState();
+        for (size_t t = 0; t < ticks && in; ++t) {
+            in = decodeStateDelta(in, end, *previous, decoded[t]);
+            previous = &decoded[t];
+        }
+        statesMatch = in == end;
+    });
+    statesMatch = statesMatch && std::memcmp(static_cast<const void*>(decoded.data()), static_cast<const void*>(states.data()), stateBytes) == 0;
+    std::cout << "States: " << stateBytes << " -> " << deltaBytes << " bytes (" << static_cast<double>(deltaBytes) / ticks
+              << " per tick), encode " << encodeSpeed << " GB/s, decode " << decodeSpeed << " GB/s, "
+              << (statesMatch ? "decoded exactly" : "DECODED WRONG") << std::endl;
+    return inputsMatch && statesMatch ? 0 : 2;
+}
@@ -0,0 +1,132 @@
+#include "dataset.h"
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+
+bool DatasetWriter::open(const std::string& path) {
+    close();
+    this->path = path;
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    DatasetHeader header;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    queue = std::make_unique<DatasetTick[]>(DATASET_QUEUE_TICKS);
+    chunk = std::make_unique<DatasetChunk>();
+    chunk->rows = 0;
+    head = 0;
+    tail = 0;
+    closing = false;
+    failed = false;
+    dropped = 0;
+    bout = 0;
+    writer = std::thread(&DatasetWriter::writerLoop, this);
+    return true;
+}
+
+void DatasetWriter::beginBout() {
+    bout++;
+}
+
+void DatasetWriter::record(const MatchState& state, InputWord player1Input, InputWord player2Input) {
+    if (!file) return;
+    uint64_t index = head.load(std::memory_order_relaxed);
+    if (index - tail.load(std::memory_order_acquire) >= DATASET_QUEUE_TICKS) {
+        dropped++;
+        return;
+    }
+    DatasetTick& tick = queue[index % DATASET_QUEUE_TICKS];
+    tick.state = state;
+    tick.bout = bout;
+    tick.inputs[0] = player1Input;
+    tick.inputs[1] = player2Input;
+    head.store(index + 1, std::memory_order_release);
+}
+
+bool DatasetWriter::close() {
+    if (!file) return true;
+    closing = true;
+    writer.join();
+    if (chunk->rows > 0) flushChunk();
+    bool ok = !failed && std::fclose(file) == 0;
+    file = nullptr;
+    queue.reset();
+    chunk.reset();
+    return ok;
+}
+
+// Chunks are written whole, padding included, so every chunk has the same size
+void DatasetWriter::flushChunk() {
+    if (std::fwrite(chunk.get(), sizeof(DatasetChunk), 1, file) != 1) failed = true;
+    chunk->rows = 0;
+}
+
+// Polls rather than waits on a signal, so the main loop never makes a system call to wake it; a few
+// milliseconds of latency is nothing against a queue holding minutes of play
+void DatasetWriter::writerLoop() {
+    while (true) {
+        uint64_t index = tail.load(std::memory_order_relaxed);
+        uint64_t end = head.load(std::memory_order_acquire);
+        if (index == end) {
+            if (closing) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+            continue;
+        }
+
+        for (; index != end; ++index) {
+            const DatasetTick& tick = queue[index % DATASET_QUEUE_TICKS];
+            for (int player = 0; player < 2; ++player) {
+                uint32_t row = chunk->rows++;
+                chunk->bout[row] = tick.bout;
+                chunk->tick[row] = tick.state.tick;
+                chunk->player[row] = static_cast<uint8_t>(player);
+                chunk->input[row] = tick.inputs[player];
+                observe(tick.state, player, chunk->observation[row]);
+                if (chunk->rows == DATASET_CHUNK_ROWS) {
+                    tail.store(index, std::memory_order_release); // Free what is done before the disk write
+                    flushChunk();
+                }
+            }
+        }
+        tail.store(end, std::memory_order_release);
+    }
+}
+
+bool MappedDataset::open(const std::string& path) {
+    if (!file.open(path, sizeof(DatasetHeader), MAP_ACCESS_SEQUENTIAL)) {
+        error = file.error;
+        return false;
+    }
+    header = static_cast<const DatasetHeader*>(file.data);
+    if (header->magic != DATASET_MAGIC || header->version != DATASET_VERSION || header->observationSize != POLICY_INPUTS ||
+        header->chunkRows != DATASET_CHUNK_ROWS) {
+        error = "not a version " + std::to_string(DATASET_VERSION) + " dataset for this build";
+        return false;
+    }
+    // A session cut short leaves a partly written chunk at the end; only whole chunks count
+    chunks = reinterpret_cast<const DatasetChunk*>(static_cast<const char*>(file.data) + sizeof(DatasetHeader));
+    chunkCount = (file.size - sizeof(DatasetHeader)) / sizeof(DatasetChunk);
+    error.clear();
+    return true;
+}
+
+uint64_t MappedDataset::rows() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < chunkCount; ++i) total += chunks[i].rows;
+    return total;
+}
+
+std::string datasetPath(const std::string& directory) {
+    char stamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&now));
+    std::string path = directory + "/session_" + stamp + DATASET_EXTENSION;
+    for (int copy = 1; std::filesystem::exists(path); ++copy) {
+        path = directory + "/session_" + stamp + "_" + std::to_string(copy) + DATASET_EXTENSION;
+    }
+    return path;
+}
@@ -0,0 +1,104 @@
+// Imitation-learning datasets: (observation, input) pairs for both fencers on every tick of human
+// bouts, for training bots to play like people. Each row is the match as the game played it, before
+// the tick, with the keys stepMatch was then given. The main loop hands each tick to a wait-free
+// single-producer queue; a background thread turns ticks into rows and writes whole chunks, so a slow
+// disk only fills the queue. A full queue drops the tick instead of stalling the frame.
+#ifndef DATASET_H
+#define DATASET_H
+
+#include "simulation.h"
+#include "policy.h"
+#include "mappedfile.h"
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+#define DATASET_MAGIC 0x54534446u // "FDST"
+#define DATASET_VERSION 1
+#define DATASET_EXTENSION ".fds"
+#define DATASET_CHUNK_ROWS 4096      // Rows per chunk; every column of a chunk is this long
+#define DATASET_QUEUE_TICKS 16384    // Over four minutes of play buffered before ticks are dropped
+
+// File layout: DatasetHeader, then DatasetChunks. Chunks are all the same size whatever their row
+// count, so chunk k starts at a fixed offset and a mapped file is read as an array of them.
+struct DatasetHeader {
+    uint32_t magic = DATASET_MAGIC;
+    uint16_t version = DATASET_VERSION;
+    uint16_t observationSize = POLICY_INPUTS;
+    uint32_t chunkRows = DATASET_CHUNK_ROWS;
+    uint32_t reserved[13] = {};
+};
+static_assert(sizeof(DatasetHeader) == 64, "DatasetHeader is written as is");
+
+// Columnar: each field of the rows stored contiguously, observations as fixed-width POLICY_INPUTS
+// byte vectors from observe(), seen from the row's fencer. Inputs are the keys as held, not turned
+// for the side.
+struct DatasetChunk {
+    uint32_t rows;                   // Filled rows, DATASET_CHUNK_ROWS except in the last chunk
+    uint32_t reserved[15];
+    uint32_t bout[DATASET_CHUNK_ROWS];   // Bout number within the file
+    uint32_t tick[DATASET_CHUNK_ROWS];   // MatchState::tick the fencer saw
+    uint8_t player[DATASET_CHUNK_ROWS];  // 0 or 1
+    InputWord input[DATASET_CHUNK_ROWS]; // Held on that tick
+    uint8_t observation[DATASET_CHUNK_ROWS][POLICY_INPUTS];
+};
+static_assert(sizeof(DatasetChunk) % 64 == 0, "DatasetChunk keeps the columns of every chunk aligned");
+
+// What the main loop hands over per tick: the state before stepMatch and both players' keys
+struct DatasetTick {
+    MatchState state;
+    uint32_t bout;
+    InputWord inputs[2];
+};
+
+struct DatasetWriter {
+    std::string path;
+    uint64_t dropped = 0;            // Ticks lost to a full queue
+
+    DatasetWriter() = default;
+    DatasetWriter(const DatasetWriter&) = delete;
+    DatasetWriter& operator=(const DatasetWriter&) = delete;
+    ~DatasetWriter() { close(); }
+
+    bool open(const std::string& path); // Writes the header and starts the writer thread
+    bool isOpen() const { return file != nullptr; }
+    void beginBout();
+    // Call before stepMatch with the played match and the keys about to step it; wait-free, never
+    // touches the disk
+    void record(const MatchState& state, InputWord player1Input, InputWord player2Input);
+    bool close();                    // Drains the queue and writes the last chunk; false on a write error
+
+private:
+    FILE* file = nullptr;
+    std::thread writer;
+    std::unique_ptr<DatasetTick[]> queue;
+    alignas(64) std::atomic<uint64_t> head{0}; // Next tick to write, advanced by the main loop
+    alignas(64) std::atomic<uint64_t> tail{0}; // Next tick to read, advanced by the writer thread
+    alignas(64) std::atomic<bool> closing{false};
+    std::atomic<bool> failed{false};
+    uint32_t bout = 0;
+    std::unique_ptr<DatasetChunk> chunk;
+
+    void writerLoop();
+    void flushChunk();
+};
+
+// A dataset mapped read-only; chunks point straight into the mapping
+struct MappedDataset {
+    const DatasetHeader* header = nullptr;
+    const DatasetChunk* chunks = nullptr;
+    size_t chunkCount = 0;
+    std::string error;
+
+    bool open(const std::string& path);
+    uint64_t rows() const;
+
+    MappedFile file;
+};
+
+// New file in directory named after the current time, as replayPath names replays
+std::string datasetPath(const std::string& directory);
+
+#endif // DATASET_H
@@ -0,0 +1,134 @@
+#include "dataset.h"
+#include "lab.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <thread>
+
+// Summary of a mapped dataset: rows, bouts and how often each key is held
+static bool summarise(const std::string& path) {
+    MappedDataset dataset;
+    if (!dataset.open(path)) {
+        std::cerr << "dataset: " << path << ": " << dataset.error << std::endl;
+        return false;
+    }
+    std::set<uint32_t> bouts;
+    uint64_t held[2][INPUT_SYMBOLS] = {};
+    uint64_t rows[2] = {0, 0};
+    for (size_t c = 0; c < dataset.chunkCount; ++c) {
+        const DatasetChunk& chunk = dataset.chunks[c];
+        for (uint32_t row = 0; row < chunk.rows; ++row) {
+            int player = chunk.player[row];
+            bouts.insert(chunk.bout[row]);
+            rows[player]++;
+            for (int i = 0; i < INPUT_SYMBOLS; ++i) {
+                if (chunk.input[row] & (1 << i)) held[player][i]++;
+            }
+        }
+    }
+    std::cout << path << ": " << dataset.chunkCount << " chunks, " << dataset.rows() << " rows, " << bouts.size() << " bouts" << std::endl;
+    for (int player = 0; player < 2; ++player) {
+        std::cout << "  player " << player + 1 << " holds";
+        for (int i = 0; i < INPUT_SYMBOLS; ++i) {
+            std::cout << " " << INPUT_NAMES[i] << " " << (rows[player] ? 100.0 * held[player][i] / rows[player] : 0.0) << "%";
+        }
+        std::cout << std::endl;
+    }
+    return true;
+}
+
+// Summarises dataset files, or with --capture records random bouts through the writer, timing the
+// main-loop side, and checks every row of the file against the ticks that were handed over
+int runDataset(int argc, char* argv[]) {
+    std::string capturePath = stringOption(argc, argv, "--capture", "");
+    int bouts = intOption(argc, argv, "--bouts", 4);
+    int maxTicks = intOption(argc, argv, "--max-ticks", SIM_PERIOD_TICKS / 3);
+    int frameMicros = intOption(argc, argv, "--frame-us", 0); // Pace the ticks like the game; 0 runs flat out
+    std::vector<int> weapons = weaponOption(argc, argv);
+
+    if (capturePath.empty()) {
+        std::vector<std::string> paths;
+        for (int i = 0; i < argc; ++i) {
+            if (argv[i][0] == '-') {
+                ++i; // Skip the option's value
+                continue;
+            }
+            paths.push_back(argv[i]);
+        }
+        if (paths.empty()) {
+            std::cerr << "dataset: give dataset files to summarise, or --capture FILE" << std::endl;
+            return 1;
+        }
+        bool ok = true;
+        for (const std::string& path : paths) ok = summarise(path) && ok;
+        return ok ? 0 : 1;
+    }
+
+    if (weapons.empty()) return 1;
+    DatasetWriter writer;
+    if (!writer.open(capturePath)) {
+        std::cerr << "dataset: cannot write " << capturePath << std::endl;
+        return 1;
+    }
+    std::vector<DatasetTick> expected;
+    SimRandom rng(1);
+    std::chrono::duration<double, std::nano> recordTime(0);
+    std::chrono::duration<double, std::nano> worstRecord(0);
+    for (int bout = 0; bout < bouts; ++bout) {
+        MatchState state;
+        initMatch(state, static_cast<uint8_t>(weapons[bout % weapons.size()]));
+        writer.beginBout();
+        int moves[2] = {MOVE_HOLD, MOVE_HOLD};
+        for (int t = 0; t < maxTicks && !state.over; ++t) {
+            if (t % 10 == 0) {
+                moves[0] = rng.below(MOVE_COUNT);
+                moves[1] = rng.below(MOVE_COUNT);
+            }
+            InputWord inputs[2] = {moveInput(moves[0], 0, t % 10), moveInput(moves[1], 1, t % 10)};
+            auto start = std::chrono::steady_clock::now();
+            writer.record(state, inputs[0], inputs[1]);
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            recordTime += elapsed;
+            worstRecord = std::max(worstRecord, elapsed);
+            expected.push_back({state, static_cast<uint32_t>(bout + 1), {inputs[0], inputs[1]}});
+            stepMatch(state, inputs[0], inputs[1]);
+            if (frameMicros > 0) std::this_thread::sleep_for(std::chrono::microseconds(frameMicros));
+        }
+    }
+    uint64_t dropped = writer.dropped;
+    if (!writer.close()) {
+        std::cerr << "dataset: writing " << capturePath << " failed" << std::endl;
+        return 1;
+    }
+    std::cout << "Captured " << expected.size() << " ticks: " << recordTime.count() / std::max<size_t>(expected.size(), 1)
+              << " ns per record on the playing thread, worst " << worstRecord.count() << " ns; " << dropped << " ticks dropped"
+              << std::endl;
+    if (!summarise(capturePath)) return 1;
+
+    // Rows come two per tick in order; with nothing dropped they line up with the ticks handed over
+    MappedDataset dataset;
+    if (dropped > 0 || !dataset.open(capturePath)) return 0;
+    if (dataset.rows() != expected.size() * 2) {
+        std::cout << "Rows differ from the ticks recorded (" << dataset.rows() << " rows for " << expected.size() << " ticks)" << std::endl;
+        return 1;
+    }
+    uint64_t row = 0;
+    uint64_t mismatches = 0;
+    uint8_t observation[POLICY_INPUTS];
+    for (const DatasetTick& tick : expected) {
+        for (int player = 0; player < 2; ++player, ++row) {
+            const DatasetChunk& chunk = dataset.chunks[row / DATASET_CHUNK_ROWS];
+            size_t index = row % DATASET_CHUNK_ROWS;
+            observe(tick.state, player, observation);
+            if (chunk.bout[index] != tick.bout || chunk.tick[index] != tick.state.tick || chunk.player[index] != player ||
+                chunk.input[index] != tick.inputs[player] || std::memcmp(chunk.observation[index], observation, POLICY_INPUTS) != 0) {
+                mismatches++;
+            }
+        }
+    }
+    std::cout << (mismatches == 0 ? "Every row matches its tick" : "Rows differ from the ticks recorded") << " ("
+              << mismatches << " mismatches)" << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
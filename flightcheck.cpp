@@ -0,0 +1,73 @@
+#include "flightrecorder.h"
+#include "fuzz.h"
+#include "lab.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+static FlightRecorder recorder; // Too big for the stack, and the crash handler needs it to outlive main
+
+// Plays a random-input bout through the flight recorder, timing record() on the playing thread, then
+// dumps the last minute and checks the excerpt re-simulates to the same hashes and ends on the state
+// played. With --crash the dump is left to the crash handler instead, by raising SIGSEGV.
+int runFlight(int argc, char* argv[]) {
+    int ticks = intOption(argc, argv, "--ticks", 3 * SIM_PERIOD_TICKS);
+    uint64_t seed = static_cast<uint64_t>(intOption(argc, argv, "--seed", 1));
+    std::string path = stringOption(argc, argv, "--out", std::string(FLIGHT_DIRECTORY) + "/check" + REPLAY_EXTENSION);
+    bool crash = flagOption(argc, argv, "--crash");
+
+    FuzzCase fuzzCase = generateFuzzCase(seed, static_cast<size_t>(ticks));
+    MatchState state;
+    initMatch(state, fuzzCase.weapon);
+    placeFencers(state, fuzzCase.distance);
+    if (crash) installFlightRecorder(recorder, FLIGHT_DIRECTORY);
+    recorder.start(ReplayHeader(), state);
+
+    std::chrono::duration<double, std::nano> recordTime(0);
+    std::chrono::duration<double, std::nano> worstRecord(0);
+    size_t played = 0;
+    for (; played < fuzzCase.ticks() && !state.over; ++played) {
+        stepMatch(state, fuzzCase.inputs[0][played], fuzzCase.inputs[1][played]);
+        auto start = std::chrono::steady_clock::now();
+        recorder.record(fuzzCase.inputs[0][played], fuzzCase.inputs[1][played], state);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        recordTime += elapsed;
+        worstRecord = std::max(worstRecord, elapsed);
+    }
+    std::cout << "Played " << played << " ticks: " << recordTime.count() / std::max<size_t>(played, 1)
+              << " ns per record, worst " << worstRecord.count() << " ns; the recorder holds " << sizeof(FlightRecorder)
+              << " bytes" << std::endl;
+    if (crash) {
+        std::cout << "Raising SIGSEGV; the crash handler writes " << FLIGHT_DIRECTORY << "/crash_<date>_<time>" << REPLAY_EXTENSION
+                  << std::endl;
+        std::raise(SIGSEGV);
+    }
+
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, error);
+    auto start = std::chrono::steady_clock::now();
+    if (!recorder.dump(path.c_str())) {
+        std::cerr << "flight: cannot write " << path << std::endl;
+        return 1;
+    }
+    std::chrono::duration<double, std::micro> dumpTime = std::chrono::steady_clock::now() - start;
+
+    MappedReplay replay;
+    if (!replay.open(path)) {
+        std::cout << path << ": unreadable, " << replay.error << std::endl;
+        return 2;
+    }
+    MatchState first;
+    replay.startState(first);
+    ReplayCheck check = verifyReplay(replay);
+    bool ends = replay.header->finalHash == hashMatchState(state);
+    std::cout << "Dumped ticks " << first.tick << " to " << first.tick + replay.header->tickCount << " to " << path << " ("
+              << replay.file.size << " bytes) in " << dumpTime.count() << " us: "
+              << (check.matches ? "re-simulates to every hash" : "DIFFERS ON RE-SIMULATION") << ", "
+              << (ends ? "ends on the state played" : "ENDS ELSEWHERE") << std::endl;
+    return check.matches && ends ? 0 : 2;
+}
@@ -0,0 +1,168 @@
+#include "flightrecorder.h"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+void FlightRecorder::start(const ReplayHeader& header, const MatchState& state) {
+    started.store(false, std::memory_order_release); // A dump while this runs writes nothing
+    ticks.store(0, std::memory_order_relaxed);
+    this->header = header;
+    this->header.magic = REPLAY_MAGIC;
+    this->header.version = REPLAY_VERSION;
+    this->header.weapon = state.weapon;
+    this->header.seed = 0;
+    this->header.checkpointTicks = REPLAY_CHECKPOINT_TICKS; // The rings are sized for these
+    this->header.keyframeTicks = REPLAY_KEYFRAME_TICKS;
+    snapshots[0] = state;
+    last[0] = state;
+    started.store(true, std::memory_order_release);
+}
+
+void FlightRecorder::record(InputWord player1Input, InputWord player2Input, const MatchState& after) {
+    if (!started.load(std::memory_order_relaxed)) return;
+    uint32_t tick = ticks.load(std::memory_order_relaxed);
+    keys[tick % FLIGHT_KEY_TICKS] = packInputs(player1Input, player2Input);
+    uint32_t count = tick + 1;
+    if (count % REPLAY_CHECKPOINT_TICKS == 0) hashes[count / REPLAY_CHECKPOINT_TICKS % FLIGHT_CHECKPOINTS] = hashMatchState(after);
+    if (count % REPLAY_KEYFRAME_TICKS == 0) snapshots[count / REPLAY_KEYFRAME_TICKS % FLIGHT_SNAPSHOTS] = after;
+    last[count & 1] = after;
+    ticks.store(count, std::memory_order_release);
+}
+
+// write() until everything is out, through short writes and interruptions
+static bool writeAll(int file, const uint8_t* bytes, size_t count) {
+    while (count > 0) {
+#ifdef _WIN32
+        int written = _write(file, bytes, static_cast<unsigned>(count));
+#else
+        ssize_t written = write(file, bytes, count);
+        if (written < 0 && errno == EINTR) continue;
+#endif
+        if (written <= 0) return false;
+        bytes += written;
+        count -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// The same layout ReplayWriter writes, from the first snapshot whose keys are all still in the ring
+bool FlightRecorder::dump(const char* path) {
+    if (!started.load(std::memory_order_acquire)) return false;
+    uint32_t end = ticks.load(std::memory_order_acquire);
+    if (end == 0) return false;
+    uint32_t first = end + 1 > FLIGHT_KEY_TICKS ? end + 1 - FLIGHT_KEY_TICKS : 0; // Not the slot record() may be writing
+    first = (first + REPLAY_KEYFRAME_TICKS - 1) / REPLAY_KEYFRAME_TICKS * REPLAY_KEYFRAME_TICKS;
+
+    MatchState zero; // zeroState() may not be built yet, and building it here is not safe
+    std::memset(static_cast<void*>(&zero), 0, sizeof(zero));
+    const MatchState* previous = &snapshots[first / REPLAY_KEYFRAME_TICKS % FLIGHT_SNAPSHOTS];
+    uint8_t* stream = buffer + sizeof(ReplayHeader);
+    uint8_t* out = encodeStateDelta(zero, *previous, stream);
+    ReplayKeyframe index[FLIGHT_SNAPSHOTS];
+    size_t keyframeCount = 0;
+    index[keyframeCount++] = {0, 0};
+
+    InputRunEncoder runs;
+    for (uint32_t tick = first; tick < end; ++tick) {
+        out = runs.add(keys[tick % FLIGHT_KEY_TICKS], out);
+        uint32_t count = tick + 1;
+        bool checkpoint = count % REPLAY_CHECKPOINT_TICKS == 0;
+        bool keyframe = count % REPLAY_KEYFRAME_TICKS == 0;
+        if (checkpoint || keyframe) out = runs.flush(out);
+        if (checkpoint) {
+            std::memcpy(out, &hashes[count / REPLAY_CHECKPOINT_TICKS % FLIGHT_CHECKPOINTS], sizeof(uint64_t));
+            out += sizeof(uint64_t);
+        }
+        if (keyframe) {
+            index[keyframeCount++] = {count - first, static_cast<uint32_t>(out - stream)};
+            const MatchState& snapshot = snapshots[count / REPLAY_KEYFRAME_TICKS % FLIGHT_SNAPSHOTS];
+            out = encodeStateDelta(*previous, snapshot, out);
+            previous = &snapshot;
+        }
+    }
+    out = runs.flush(out);
+
+    ReplayHeader excerpt = header;
+    const MatchState& after = last[end & 1];
+    const MatchState& start = snapshots[first / REPLAY_KEYFRAME_TICKS % FLIGHT_SNAPSHOTS];
+    excerpt.tickCount = end - first;
+    excerpt.streamBytes = static_cast<uint32_t>(out - stream);
+    excerpt.distance = static_cast<int16_t>(start.fencers[1].x - start.fencers[0].x);
+    excerpt.finalHash = hashMatchState(after);
+    excerpt.points[0] = after.points[0];
+    excerpt.points[1] = after.points[1];
+    excerpt.over = after.over ? 1 : 0;
+    std::memcpy(buffer, &excerpt, sizeof(excerpt));
+    while ((out - buffer) % 4 != 0) *out++ = 0;
+    std::memcpy(out, index, keyframeCount * sizeof(ReplayKeyframe));
+    out += keyframeCount * sizeof(ReplayKeyframe);
+    ReplayIndexFooter footer;
+    footer.keyframeCount = static_cast<uint32_t>(keyframeCount);
+    std::memcpy(out, &footer, sizeof(footer));
+    out += sizeof(footer);
+
+#ifdef _WIN32
+    int file = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    int file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (file < 0) return false;
+    bool ok = writeAll(file, buffer, static_cast<size_t>(out - buffer));
+#ifdef _WIN32
+    ok = _close(file) == 0 && ok;
+#else
+    ok = close(file) == 0 && ok;
+#endif
+    return ok;
+}
+
+static FlightRecorder* crashRecorder = nullptr;
+static char crashPath[1024];
+
+static void onFatalSignal(int signal) {
+    if (crashRecorder) crashRecorder->dump(crashPath);
+    // The handler was reset on entry, so this ends the game the way the signal would have
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+void installFlightRecorder(FlightRecorder& recorder, const std::string& directory) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    char stamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&now));
+    std::string path = directory + "/crash_" + stamp + REPLAY_EXTENSION;
+    std::strncpy(crashPath, path.c_str(), sizeof(crashPath) - 1);
+    crashRecorder = &recorder;
+
+    static const int fatalSignals[] = {
+        SIGSEGV, SIGABRT, SIGFPE, SIGILL,
+#ifdef SIGBUS
+        SIGBUS,
+#endif
+    };
+#ifdef _WIN32
+    for (int signal : fatalSignals) std::signal(signal, onFatalSignal);
+#else
+    // A stack overflow leaves no stack to run the handler on, so it gets its own
+    static uint8_t handlerStack[1 << 16];
+    stack_t stack = {};
+    stack.ss_sp = handlerStack;
+    stack.ss_size = sizeof(handlerStack);
+    sigaltstack(&stack, nullptr);
+    struct sigaction action = {};
+    action.sa_handler = onFatalSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+    for (int signal : fatalSignals) sigaction(signal, &action, nullptr);
+#endif
+}
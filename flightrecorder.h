@@ -0,0 +1,58 @@
+// Flight recorder: the last minute of the match the game plays, kept in memory all the time and
+// written out as a replay excerpt when something goes wrong. That is on a crash (SIGSEGV, SIGABRT,
+// SIGBUS, SIGFPE or SIGILL), when F12 is pressed, or when an invariant check (invariants.h) fails
+// after a tick. The excerpt plays, seeks, verifies and bisects like any replay.
+//
+// record() stores each tick's keys, a state hash every checkpoint and a snapshot every keyframe in
+// fixed rings inside the recorder, so nothing is allocated while playing. dump() codes the excerpt
+// into a buffer that is also part of the recorder and writes it with open and write, so the crash
+// handler can call it: it allocates nothing, takes no lock and touches no stdio.
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include "replay.h"
+#include <atomic>
+#include <string>
+
+#define FLIGHT_DIRECTORY "flight"
+#define FLIGHT_TICKS (60 * SIM_FPS)  // Every dump covers at least this much play, when there was that much
+// Key ring: the window plus one keyframe interval, so a snapshot always starts the window
+#define FLIGHT_KEY_TICKS (FLIGHT_TICKS + REPLAY_KEYFRAME_TICKS)
+#define FLIGHT_SNAPSHOTS (FLIGHT_KEY_TICKS / REPLAY_KEYFRAME_TICKS + 1)
+#define FLIGHT_CHECKPOINTS (FLIGHT_KEY_TICKS / REPLAY_CHECKPOINT_TICKS + 1)
+// Header, a run and a hash a checkpoint at most, every snapshot and the index
+#define FLIGHT_DUMP_BYTES (sizeof(ReplayHeader) + FLIGHT_KEY_TICKS * INPUT_RUN_MAX_BYTES + FLIGHT_CHECKPOINTS * sizeof(uint64_t) + \
+                           FLIGHT_SNAPSHOTS * (STATE_DELTA_MAX_BYTES + sizeof(ReplayKeyframe)) + sizeof(ReplayIndexFooter) + 4)
+
+static_assert(REPLAY_KEYFRAME_TICKS % REPLAY_CHECKPOINT_TICKS == 0, "A dump starts on a checkpoint boundary too");
+
+struct FlightRecorder {
+    // A bout starts: the keys and intervals come from header, state is the match at tick 0
+    void start(const ReplayHeader& header, const MatchState& state);
+    // Call after stepMatch with the keys just played, like ReplayWriter::record
+    void record(InputWord player1Input, InputWord player2Input, const MatchState& after);
+    // Writes the recorded window as a replay; false if nothing was recorded or the write failed.
+    // Safe to call from a signal handler.
+    bool dump(const char* path);
+
+private:
+    ReplayHeader header;
+    uint16_t keys[FLIGHT_KEY_TICKS];            // Tick t at t % FLIGHT_KEY_TICKS
+    MatchState snapshots[FLIGHT_SNAPSHOTS];     // After tick k * REPLAY_KEYFRAME_TICKS, at k % FLIGHT_SNAPSHOTS
+    uint64_t hashes[FLIGHT_CHECKPOINTS];        // After tick k * REPLAY_CHECKPOINT_TICKS, at k % FLIGHT_CHECKPOINTS
+    MatchState last[2];                         // After the last tick, at its parity
+    uint8_t buffer[FLIGHT_DUMP_BYTES];
+    // Ticks whose keys and marks are all stored. A signal can land in the middle of record(): a
+    // tick only counts once this is raised, and the slots it writes are never ones a dump of the
+    // ticks before it reads.
+    std::atomic<uint32_t> ticks{0};
+    std::atomic<bool> started{false};
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "The crash handler reads the tick count");
+
+// Writes recorder's window to a crash file in directory on a fatal signal, then lets the signal kill
+// the game as before. The file name is fixed now, since a handler cannot format one.
+void installFlightRecorder(FlightRecorder& recorder, const std::string& directory);
+
+#endif // FLIGHTRECORDER_H
@@ -0,0 +1,267 @@
+#include "framedata.h"
+#include "lab.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+// Progress of one case: the first parry and when each fencer is back to idle
+struct CaseTrack {
+    int8_t parry = FRAME_WHIFF;
+    int16_t parryTick = 0;
+    int16_t recovered[2] = {-1, -1};
+};
+
+// Plays tick t of a case where the leader starts its input at tick 0 and the follower at tick offset.
+// Returns true once the case is decided (a touch, or both fencers have finished their action).
+static bool stepCase(MatchState& state, CaseTrack& track, FrameCase& result, int t, const int start[2], const int action[2]) {
+    InputWord input[2];
+    for (int p = 0; p < 2; ++p) {
+        input[p] = commandInput(static_cast<uint8_t>(action[p]), p, t - start[p]);
+    }
+
+    uint8_t events = stepMatch(state, input[0], input[1]);
+    if (events & (EVENT_TOUCH_P1 | EVENT_TOUCH_P2)) {
+        result.result = (events & EVENT_TOUCH_P1) ? FRAME_TOUCH_P1 : FRAME_TOUCH_P2;
+        result.tick = static_cast<int16_t>(t);
+        result.advantage = 0;
+        return true;
+    }
+    if (track.parry == FRAME_WHIFF && (events & (EVENT_PARRY_P1 | EVENT_PARRY_P2))) {
+        track.parry = (events & EVENT_PARRY_P1) ? FRAME_PARRY_P1 : FRAME_PARRY_P2;
+        track.parryTick = static_cast<int16_t>(t);
+    }
+
+    // A fencer has recovered once its input is complete and it is idle again
+    for (int p = 0; p < 2; ++p) {
+        bool entered = t >= start[p] + commandTicks(static_cast<uint8_t>(action[p]), p);
+        if (track.recovered[p] < 0 && entered && state.fencers[p].action == ACTION_IDLE) {
+            track.recovered[p] = static_cast<int16_t>(t);
+        }
+    }
+    if (track.recovered[0] < 0 || track.recovered[1] < 0) return false;
+
+    result.result = track.parry;
+    result.tick = track.parryTick;
+    result.advantage = static_cast<int16_t>(track.recovered[1] - track.recovered[0]);
+    return true;
+}
+
+// Fills every case where `leader` enters leaderAction first. The leader's input is simulated once;
+// at each offset the state is forked for every follower action instead of replaying the prefix.
+void fillFrameTable(FrameTable& table, int leader, int leaderAction) {
+    int follower = 1 - leader;
+    int horizon = table.maxOffset + 2 * SIM_ACTION_TICKS + 2 * INPUT_SYMBOLS;
+
+    MatchState prefix;
+    initMatch(prefix, static_cast<uint8_t>(table.weapon));
+    placeFencers(prefix, table.distance);
+    CaseTrack prefixTrack;
+
+    for (int offset = 0; offset <= table.maxOffset; ++offset) {
+        // Player 2 leading at offset 0 is the same case as player 1 leading at offset 0
+        for (int followerAction = 0; followerAction < ACTION_COUNT && (leader == 0 || offset > 0); ++followerAction) {
+            int action[2];
+            int start[2];
+            action[leader] = leaderAction;
+            action[follower] = followerAction;
+            start[leader] = 0;
+            start[follower] = offset;
+
+            MatchState fork = prefix;
+            CaseTrack track = prefixTrack;
+            FrameCase& result = leader == 0 ? table.at(leaderAction, followerAction, offset)
+                                            : table.at(followerAction, leaderAction, -offset);
+            result = FrameCase();
+            for (int t = offset; t < horizon; ++t) {
+                if (stepCase(fork, track, result, t, start, action)) break;
+            }
+        }
+
+        // Extend the shared prefix by one tick with the follower still waiting
+        int action[2];
+        int start[2];
+        action[leader] = leaderAction;
+        action[follower] = ACTION_IDLE;
+        start[leader] = 0;
+        start[follower] = horizon;
+        FrameCase prefixResult;
+        if (stepCase(prefix, prefixTrack, prefixResult, offset, start, action)) {
+            // The leader scored before the follower moved: every later offset ends the same way
+            for (int later = offset + 1; later <= table.maxOffset; ++later) {
+                for (int followerAction = 0; followerAction < ACTION_COUNT; ++followerAction) {
+                    FrameCase& result = leader == 0 ? table.at(leaderAction, followerAction, later)
+                                                    : table.at(followerAction, leaderAction, -later);
+                    result = prefixResult;
+                }
+            }
+            break;
+        }
+    }
+}
+
+static std::string caseText(const FrameCase& frameCase) {
+    std::ostringstream text;
+    switch (frameCase.result) {
+    case FRAME_TOUCH_P1:
+        text << "T@" << frameCase.tick;
+        break;
+    case FRAME_TOUCH_P2:
+        text << "t@" << frameCase.tick;
+        break;
+    case FRAME_PARRY_P1:
+        text << "P" << std::showpos << frameCase.advantage;
+        break;
+    case FRAME_PARRY_P2:
+        text << "p" << std::showpos << frameCase.advantage;
+        break;
+    default:
+        text << std::showpos << frameCase.advantage;
+        break;
+    }
+    return text.str();
+}
+
+static const char* const RESULT_NAMES[] = {"whiff", "touch_p1", "touch_p2", "parry_p1", "parry_p2"};
+
+static void printTimings() {
+    std::cout << "Action duration " << ACTION_DURATION_MS << " ms (" << SIM_ACTION_TICKS << " ticks), strike frame switch "
+              << STRIKE_FRAME_MS << " ms (" << SIM_STRIKE_FRAME_TICKS << " ticks), command window " << COMMAND_WINDOW_MS
+              << " ms" << std::endl;
+    for (int action = ACTION_ATTACK; action < ACTION_COUNT; ++action) {
+        SimRect first = hitboxAt(static_cast<uint8_t>(action), 0, 0, 0, 0);
+        SimRect second = hitboxAt(static_cast<uint8_t>(action), SIM_STRIKE_FRAME_TICKS, 0, 0, 0);
+        SimRect parry = parryBoxAt(static_cast<uint8_t>(action), 0, 0, 0, WEAPON_EPEE);
+        std::cout << "  " << std::left << std::setw(15) << ACTION_NAMES[action] << std::right
+                  << " input " << commandTicks(static_cast<uint8_t>(action), 0) + 1 << " ticks";
+        if (first.w > 0 || second.w > 0) {
+            std::cout << ", hitbox {" << first.x << "," << first.y << "," << first.w << "," << first.h << "} then {"
+                      << second.x << "," << second.y << "," << second.w << "," << second.h << "}";
+        }
+        if (parry.w > 0) {
+            std::cout << ", parry box {" << parry.x << "," << parry.y << "," << parry.w << "," << parry.h << "}";
+        }
+        std::cout << std::endl;
+    }
+}
+
+static void printTable(FrameTable& table) {
+    std::cout << "\n" << WEAPON_NAMES[table.weapon] << ", distance " << table.distance
+              << " (rows: player 1, columns: player 2, both starting their input on the same tick)" << std::endl;
+    std::cout << std::setw(16) << "";
+    for (int column = 0; column < ACTION_COUNT; ++column) std::cout << std::setw(16) << ACTION_NAMES[column];
+    std::cout << std::endl;
+
+    for (int row = 0; row < ACTION_COUNT; ++row) {
+        std::cout << std::left << std::setw(16) << ACTION_NAMES[row] << std::right;
+        for (int column = 0; column < ACTION_COUNT; ++column) {
+            std::cout << std::setw(16) << caseText(table.at(row, column, 0));
+        }
+        std::cout << std::endl;
+    }
+
+    // Punish windows: how late after player 1's input player 2 can still start an action and score
+    std::cout << "Punish windows for player 2:" << std::endl;
+    for (int row = ACTION_ATTACK; row < ACTION_COUNT; ++row) {
+        int bestAction = -1, bestFirst = 0, bestLast = -1;
+        for (int column = 0; column < ACTION_COUNT; ++column) {
+            int first = -1, last = -1;
+            for (int offset = 1; offset <= table.maxOffset; ++offset) {
+                if (table.at(row, column, offset).result != FRAME_TOUCH_P2) continue;
+                if (first < 0) first = offset;
+                last = offset;
+            }
+            if (first >= 0 && last - first > bestLast - bestFirst) {
+                bestAction = column;
+                bestFirst = first;
+                bestLast = last;
+            }
+        }
+        std::cout << "  " << std::left << std::setw(15) << ACTION_NAMES[row] << std::right;
+        if (bestAction < 0) {
+            std::cout << " safe" << std::endl;
+        } else {
+            std::cout << " " << ACTION_NAMES[bestAction] << " from +" << bestFirst << " to +" << bestLast << " ticks" << std::endl;
+        }
+    }
+}
+
+int runFrameData(int argc, char* argv[]) {
+    std::vector<int> distances = intListOption(argc, argv, "--distances", {SIM_START_X2 - SIM_START_X1, 200, 150, 100, 50});
+    std::vector<int> weapons = weaponOption(argc, argv);
+    int maxOffset = intOption(argc, argv, "--max-offset", SIM_ACTION_TICKS);
+    std::string outPath = stringOption(argc, argv, "--out", "");
+    bool quiet = flagOption(argc, argv, "--quiet");
+    int threads = threadOption(argc, argv);
+
+    if (weapons.empty()) return 1;
+    if (maxOffset < 0 || maxOffset > 10 * SIM_ACTION_TICKS) {
+        std::cerr << "framedata: --max-offset must be between 0 and " << 10 * SIM_ACTION_TICKS << std::endl;
+        return 1;
+    }
+
+    std::vector<FrameTable> tables;
+    for (int weapon : weapons) {
+        for (int distance : distances) {
+            FrameTable table;
+            table.weapon = weapon;
+            table.distance = distance;
+            table.maxOffset = maxOffset;
+            table.cases.resize(static_cast<size_t>(ACTION_COUNT) * ACTION_COUNT * table.offsets());
+            tables.push_back(std::move(table));
+        }
+    }
+
+    printTimings();
+
+    // One job per table, leader and leader action; each job writes its own cases
+    size_t jobCount = tables.size() * 2 * ACTION_COUNT;
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> nextJob{0};
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() {
+            for (size_t job = nextJob++; job < jobCount; job = nextJob++) {
+                FrameTable& table = tables[job / (2 * ACTION_COUNT)];
+                int leader = static_cast<int>(job / ACTION_COUNT) % 2;
+                fillFrameTable(table, leader, static_cast<int>(job % ACTION_COUNT));
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t caseCount = 0;
+    for (FrameTable& table : tables) {
+        caseCount += table.cases.size();
+        if (!quiet) printTable(table);
+    }
+    std::cout << "\n" << caseCount << " cases in " << seconds << " s" << std::endl;
+
+    if (!outPath.empty()) {
+        std::ofstream out(outPath);
+        if (!out) {
+            std::cerr << "framedata: cannot write " << outPath << std::endl;
+            return 1;
+        }
+        out << "weapon,distance,player1_action,player2_action,offset,result,tick,advantage\n";
+        for (FrameTable& table : tables) {
+            for (int row = 0; row < ACTION_COUNT; ++row) {
+                for (int column = 0; column < ACTION_COUNT; ++column) {
+                    for (int offset = -table.maxOffset; offset <= table.maxOffset; ++offset) {
+                        const FrameCase& frameCase = table.at(row, column, offset);
+                        out << WEAPON_NAMES[table.weapon] << "," << table.distance << "," << ACTION_NAMES[row] << ","
+                            << ACTION_NAMES[column] << "," << offset << "," << RESULT_NAMES[frameCase.result] << ","
+                            << frameCase.tick << "," << frameCase.advantage << "\n";
+                    }
+                }
+            }
+        }
+        std::cout << "Wrote " << outPath << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,38 @@
+// Frame-advantage and punish-window tables for every pair of actions ("FencingLab framedata").
+#ifndef FRAMEDATA_H
+#define FRAMEDATA_H
+
+#include "simulation.h"
+#include <vector>
+
+enum FrameResult : int8_t {
+    FRAME_WHIFF,    // Nobody was touched
+    FRAME_TOUCH_P1, // Player 1 touched player 2
+    FRAME_TOUCH_P2, // Player 2 touched player 1
+    FRAME_PARRY_P1, // Player 1 parried and nobody was touched
+    FRAME_PARRY_P2  // Player 2 parried and nobody was touched
+};
+
+// Outcome of player 1 entering one action and player 2 another, offset ticks later
+struct FrameCase {
+    int8_t result = FRAME_WHIFF;
+    int16_t tick = 0;      // Tick of the touch (or first parry), counted from the first input of either player
+    int16_t advantage = 0; // Ticks player 1 is back to idle before player 2 (negative: after)
+};
+
+// Every case for one weapon and distance, indexed by [player 1 action][player 2 action][offset]
+struct FrameTable {
+    int weapon = WEAPON_EPEE;
+    int distance = 0;
+    int maxOffset = 0; // Offsets run from -maxOffset (player 2 first) to +maxOffset
+    std::vector<FrameCase> cases;
+
+    int offsets() const { return 2 * maxOffset + 1; }
+    FrameCase& at(int player1Action, int player2Action, int offset) {
+        return cases[(player1Action * ACTION_COUNT + player2Action) * offsets() + offset + maxOffset];
+    }
+};
+
+void fillFrameTable(FrameTable& table, int leader, int leaderAction);
+
+#endif // FRAMEDATA_H
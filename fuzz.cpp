@@ -0,0 +1,408 @@
+#include "fuzz.h"
+#include "lab.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+// Random input streams. Each player gets a style for the whole case, from walking about only (so
+// the clock runs out and the periods are exercised) to mashing every key.
+struct InputGenerator {
+    SimRandom rng;
+    uint8_t weapon;
+    int distance;
+    uint8_t style[2];
+    InputWord held[2] = {0, 0};
+    int holdTicks[2] = {0, 0};
+
+    explicit InputGenerator(uint64_t seed) : rng(seed) {
+        weapon = static_cast<uint8_t>(rng.below(WEAPON_COUNT));
+        distance = rng.below(2) ? SIM_START_X2 - SIM_START_X1 : rng.below(SIM_MAX_X + 1);
+        for (int p = 0; p < 2; ++p) style[p] = static_cast<uint8_t>(rng.below(4));
+    }
+
+    InputWord input(int player) {
+        if (holdTicks[player]-- > 0) return held[player];
+
+        uint64_t bits = rng.next();
+        switch (style[player]) {
+        case 0: // Walk only
+            held[player] = static_cast<InputWord>(bits & (INPUT_LEFT | INPUT_RIGHT));
+            holdTicks[player] = static_cast<int>((bits >> 8) % 120);
+            break;
+        case 1: // Single presses, like commandInput
+            held[player] = (bits & 3) ? 0 : static_cast<InputWord>(1 << ((bits >> 2) % INPUT_SYMBOLS));
+            holdTicks[player] = static_cast<int>((bits >> 8) % 4);
+            break;
+        case 2: // Walking with the odd command
+            held[player] = static_cast<InputWord>(bits & (INPUT_LEFT | INPUT_RIGHT));
+            if ((bits >> 4) % 8 == 0) held[player] |= static_cast<InputWord>(bits >> 16) & (INPUT_UP | INPUT_DOWN | INPUT_ATTACK);
+            holdTicks[player] = static_cast<int>((bits >> 8) % 16);
+            break;
+        default: // Mash every key
+            held[player] = static_cast<InputWord>(bits & ((1 << INPUT_SYMBOLS) - 1));
+            holdTicks[player] = static_cast<int>((bits >> 8) % 3);
+            break;
+        }
+        return held[player];
+    }
+};
+
+FuzzCase generateFuzzCase(uint64_t seed, size_t maxTicks) {
+    InputGenerator generator(seed);
+    FuzzCase fuzzCase;
+    fuzzCase.weapon = generator.weapon;
+    fuzzCase.distance = generator.distance;
+    for (size_t t = 0; t < maxTicks; ++t) {
+        fuzzCase.inputs[0].push_back(generator.input(0));
+        fuzzCase.inputs[1].push_back(generator.input(1));
+    }
+    return fuzzCase;
+}
+
+FuzzResult runFuzzCase(const FuzzCase& fuzzCase) {
+    MatchState state;
+    initMatch(state, fuzzCase.weapon);
+    placeFencers(state, fuzzCase.distance);
+
+    FuzzResult result;
+    for (size_t t = 0; t < fuzzCase.ticks() && !state.over; ++t) {
+        MatchState before = state;
+        uint8_t events = stepMatch(state, fuzzCase.inputs[0][t], fuzzCase.inputs[1][t]);
+        result.invariant = checkInvariants(before, state, events);
+        if (result.invariant != INVARIANT_NONE) {
+            result.tick = t;
+            return result;
+        }
+    }
+    return result;
+}
+
+// Replays a candidate; on the same failure, cuts it after the failing tick and keeps it
+static bool stillFails(FuzzCase& candidate, uint8_t invariant) {
+    FuzzResult result = runFuzzCase(candidate);
+    if (result.invariant != invariant) return false;
+    for (auto& inputs : candidate.inputs) inputs.resize(result.tick + 1);
+    return true;
+}
+
+// Delta debugging: drop ticks, then release keys, halving the chunk size until nothing more goes.
+// Every pass keeps the case failing on the same invariant, so the result is still a reproducer.
+FuzzCase shrinkFuzzCase(const FuzzCase& fuzzCase, uint8_t invariant) {
+    FuzzCase best = fuzzCase;
+    if (!stillFails(best, invariant)) return best;
+
+    // The default start position and weapon are easier to read
+    FuzzCase candidate = best;
+    candidate.distance = SIM_START_X2 - SIM_START_X1;
+    if (stillFails(candidate, invariant)) best = candidate;
+    candidate = best;
+    candidate.weapon = WEAPON_EPEE;
+    if (stillFails(candidate, invariant)) best = candidate;
+
+    bool progress = true;
+    while (progress) {
+        progress = false;
+
+        for (size_t chunk = best.ticks() / 2; chunk > 0; chunk /= 2) {
+            for (size_t start = 0; start < best.ticks();) {
+                candidate = best;
+                for (auto& inputs : candidate.inputs) {
+                    inputs.erase(inputs.begin() + start, inputs.begin() + std::min(start + chunk, inputs.size()));
+                }
+                if (stillFails(candidate, invariant)) {
+                    best = candidate;
+                    progress = true;
+                } else {
+                    start += chunk;
+                }
+            }
+        }
+
+        for (int p = 0; p < 2; ++p) {
+            for (size_t chunk = best.ticks(); chunk > 0; chunk /= 2) {
+                for (size_t start = 0; start < best.ticks(); start += chunk) {
+                    size_t end = std::min(start + chunk, best.ticks());
+                    bool held = false;
+                    for (size_t t = start; t < end; ++t) held |= best.inputs[p][t] != 0;
+                    if (!held) continue;
+
+                    candidate = best;
+                    for (size_t t = start; t < end; ++t) candidate.inputs[p][t] = 0;
+                    if (stillFails(candidate, invariant)) {
+                        best = candidate;
+                        progress = true;
+                    }
+                }
+            }
+        }
+
+        for (size_t t = 0; t < best.ticks(); ++t) {
+            for (int p = 0; p < 2; ++p) {
+                for (int i = 0; i < INPUT_SYMBOLS && t < best.ticks(); ++i) {
+                    if (!(best.inputs[p][t] & (1 << i))) continue;
+                    candidate = best;
+                    candidate.inputs[p][t] &= static_cast<InputWord>(~(1 << i));
+                    if (stillFails(candidate, invariant)) {
+                        best = candidate;
+                        progress = true;
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+static std::string inputText(InputWord input) {
+    if (!input) return "-";
+    std::string text;
+    for (int i = 0; i < INPUT_SYMBOLS; ++i) {
+        if (!(input & (1 << i))) continue;
+        if (!text.empty()) text += "+";
+        text += INPUT_NAMES[i];
+    }
+    return text;
+}
+
+static bool parseInput(const std::string& text, InputWord& input) {
+    input = 0;
+    if (text == "-") return true;
+
+    std::stringstream stream(text);
+    std::string name;
+    while (std::getline(stream, name, '+')) {
+        int bit = -1;
+        for (int i = 0; i < INPUT_SYMBOLS; ++i) {
+            if (name == INPUT_NAMES[i]) bit = i;
+        }
+        if (bit < 0) return false;
+        input |= static_cast<InputWord>(1 << bit);
+    }
+    return true;
+}
+
+// Text format, one line per run of identical ticks: "<ticks> <player 1 keys> <player 2 keys>"
+bool saveFuzzCase(const FuzzCase& fuzzCase, const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    out << "# FencingLab fuzz case, replay with: FencingLab fuzz --replay " << path << "\n";
+    out << "weapon " << WEAPON_NAMES[fuzzCase.weapon] << "\n";
+    out << "distance " << fuzzCase.distance << "\n";
+    out << "# ticks player1 player2\n";
+    for (size_t t = 0; t < fuzzCase.ticks();) {
+        size_t run = 1;
+        while (t + run < fuzzCase.ticks() && fuzzCase.inputs[0][t + run] == fuzzCase.inputs[0][t] &&
+               fuzzCase.inputs[1][t + run] == fuzzCase.inputs[1][t]) {
+            run++;
+        }
+        out << run << " " << inputText(fuzzCase.inputs[0][t]) << " " << inputText(fuzzCase.inputs[1][t]) << "\n";
+        t += run;
+    }
+    return static_cast<bool>(out);
+}
+
+bool loadFuzzCase(FuzzCase& fuzzCase, const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    fuzzCase = FuzzCase();
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream stream(line);
+        std::string first;
+        stream >> first;
+
+        if (first == "weapon") {
+            std::string name;
+            stream >> name;
+            int weapon = weaponFromName(name.c_str());
+            if (weapon < 0) return false;
+            fuzzCase.weapon = static_cast<uint8_t>(weapon);
+        } else if (first == "distance") {
+            stream >> fuzzCase.distance;
+        } else {
+            std::string keys[2];
+            InputWord input[2];
+            stream >> keys[0] >> keys[1];
+            int run = std::atoi(first.c_str());
+            if (run <= 0 || !parseInput(keys[0], input[0]) || !parseInput(keys[1], input[1])) return false;
+            for (int p = 0; p < 2; ++p) fuzzCase.inputs[p].insert(fuzzCase.inputs[p].end(), run, input[p]);
+        }
+    }
+    return true;
+}
+
+// Per-thread totals, on their own cache lines so the workers never share one
+struct alignas(64) FuzzCounters {
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<uint64_t> cases{0};
+    uint64_t touches = 0;
+    uint64_t parries = 0;
+    uint64_t periods = 0;
+    uint64_t suddenDeaths = 0;
+    uint64_t gameOvers = 0;
+    uint64_t actions[ACTION_COUNT] = {};
+};
+
+struct FuzzFailure {
+    uint64_t seed = 0;
+    size_t tick = 0;
+    uint8_t invariant = INVARIANT_NONE;
+};
+
+static int replayFuzzCase(const std::string& path) {
+    FuzzCase fuzzCase;
+    if (!loadFuzzCase(fuzzCase, path)) {
+        std::cerr << "fuzz: cannot read " << path << std::endl;
+        return 1;
+    }
+
+    FuzzResult result = runFuzzCase(fuzzCase);
+    if (result.invariant == INVARIANT_NONE) {
+        std::cout << path << ": " << fuzzCase.ticks() << " ticks, every invariant holds" << std::endl;
+        return 0;
+    }
+    std::cout << path << ": invariant '" << INVARIANT_NAMES[result.invariant] << "' broken on tick " << result.tick << std::endl;
+    return 2;
+}
+
+int runFuzz(int argc, char* argv[]) {
+    std::string replayPath = stringOption(argc, argv, "--replay", "");
+    if (!replayPath.empty()) return replayFuzzCase(replayPath);
+
+    double seconds = intOption(argc, argv, "--seconds", 10);
+    uint64_t caseLimit = static_cast<uint64_t>(intOption(argc, argv, "--cases", 0));
+    int maxTicks = intOption(argc, argv, "--max-ticks", (SIM_PERIODS + 1) * SIM_PERIOD_TICKS);
+    uint64_t baseSeed = static_cast<uint64_t>(intOption(argc, argv, "--seed",
+        static_cast<int>(std::chrono::system_clock::now().time_since_epoch().count() & 0x7fffffff)));
+    std::string outPath = stringOption(argc, argv, "--out", "fuzz_case.txt");
+    int threads = threadOption(argc, argv);
+
+    if (maxTicks < 1 || (seconds <= 0 && caseLimit == 0)) {
+        std::cerr << "fuzz: --max-ticks must be at least 1, and --seconds or --cases positive" << std::endl;
+        return 1;
+    }
+    std::cout << "Fuzzing with seed " << baseSeed << ", " << threads << " threads, up to " << maxTicks << " ticks per case"
+              << std::endl;
+
+    std::vector<FuzzCounters> counters(threads);
+    std::atomic<uint64_t> nextCase{0};
+    std::atomic<bool> stop{false};
+    std::mutex failureMutex;
+    FuzzFailure failure;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            FuzzCounters& own = counters[i];
+            while (!stop.load(std::memory_order_relaxed)) {
+                uint64_t index = nextCase++;
+                if (caseLimit > 0 && index >= caseLimit) break;
+
+                // The hot loop streams inputs straight from the generator; the case is only
+                // materialised again from its seed when it fails
+                uint64_t seed = seedFor(baseSeed, index);
+                InputGenerator generator(seed);
+                MatchState state;
+                initMatch(state, generator.weapon);
+                placeFencers(state, generator.distance);
+
+                int t = 0;
+                for (; t < maxTicks && !state.over; ++t) {
+                    MatchState before = state;
+                    InputWord player1Input = generator.input(0);
+                    InputWord player2Input = generator.input(1);
+                    uint8_t events = stepMatch(state, player1Input, player2Input);
+
+                    uint8_t invariant = checkInvariants(before, state, events);
+                    if (invariant != INVARIANT_NONE) {
+                        std::lock_guard<std::mutex> lock(failureMutex);
+                        if (!stop.exchange(true)) failure = {seed, static_cast<size_t>(t), invariant};
+                        break;
+                    }
+
+                    if (events) {
+                        own.touches += (events & (EVENT_TOUCH_P1 | EVENT_TOUCH_P2)) ? 1 : 0;
+                        own.parries += (events & (EVENT_PARRY_P1 | EVENT_PARRY_P2)) ? 1 : 0;
+                        own.periods += (events & EVENT_PERIOD) ? 1 : 0;
+                        own.gameOvers += (events & EVENT_GAME_OVER) ? 1 : 0;
+                    }
+                    own.suddenDeaths += state.suddenDeath && !before.suddenDeath;
+                    for (int p = 0; p < 2; ++p) {
+                        if (before.fencers[p].action == ACTION_IDLE) own.actions[state.fencers[p].action]++;
+                    }
+                }
+                own.ticks.fetch_add(static_cast<uint64_t>(t), std::memory_order_relaxed);
+                own.cases.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    // Progress once a minute, so overnight runs show they are alive
+    auto lastReport = start;
+    while (!stop.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        auto now = std::chrono::steady_clock::now();
+        uint64_t cases = 0;
+        for (const FuzzCounters& own : counters) cases += own.cases.load(std::memory_order_relaxed);
+        if (caseLimit > 0 ? cases >= caseLimit : std::chrono::duration<double>(now - start).count() >= seconds) break;
+
+        if (now - lastReport >= std::chrono::minutes(1)) {
+            uint64_t ticks = 0;
+            for (const FuzzCounters& own : counters) ticks += own.ticks.load(std::memory_order_relaxed);
+            std::cout << "  " << cases << " cases, " << ticks << " ticks" << std::endl;
+            lastReport = now;
+        }
+    }
+    stop = true;
+    for (auto& worker : workers) worker.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    FuzzCounters total;
+    for (const FuzzCounters& own : counters) {
+        total.ticks += own.ticks.load();
+        total.cases += own.cases.load();
+        total.touches += own.touches;
+        total.parries += own.parries;
+        total.periods += own.periods;
+        total.suddenDeaths += own.suddenDeaths;
+        total.gameOvers += own.gameOvers;
+        for (int a = 0; a < ACTION_COUNT; ++a) total.actions[a] += own.actions[a];
+    }
+
+    std::cout << total.cases.load() << " cases, " << total.ticks.load() << " ticks in " << elapsed << " s ("
+              << static_cast<uint64_t>(total.ticks.load() / elapsed / threads) << " ticks/s per thread)" << std::endl;
+    std::cout << "  touches " << total.touches << ", parries " << total.parries << ", new periods " << total.periods
+              << ", sudden deaths " << total.suddenDeaths << ", bouts finished " << total.gameOvers << std::endl;
+    std::cout << "  actions started:";
+    for (int a = ACTION_ATTACK; a < ACTION_COUNT; ++a) std::cout << " " << ACTION_NAMES[a] << " " << total.actions[a];
+    std::cout << std::endl;
+
+    if (failure.invariant == INVARIANT_NONE) {
+        std::cout << "Every invariant held" << std::endl;
+        return 0;
+    }
+
+    std::cout << "\nInvariant '" << INVARIANT_NAMES[failure.invariant] << "' broken on tick " << failure.tick << " of case seed "
+              << failure.seed << ", shrinking..." << std::endl;
+    FuzzCase minimal = shrinkFuzzCase(generateFuzzCase(failure.seed, failure.tick + 1), failure.invariant);
+    size_t held = 0;
+    for (size_t t = 0; t < minimal.ticks(); ++t) held += (minimal.inputs[0][t] | minimal.inputs[1][t]) != 0;
+    std::cout << "Minimal case: " << minimal.ticks() << " ticks, " << held << " with keys held" << std::endl;
+
+    if (!saveFuzzCase(minimal, outPath)) {
+        std::cerr << "fuzz: cannot write " << outPath << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << outPath << std::endl;
+    return 2;
+}
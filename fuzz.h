@@ -0,0 +1,32 @@
+// Property fuzzer for the match simulation ("FencingLab fuzz"). Plays random input streams for both
+// players, checks the match invariants after every tick and shrinks a failing case to a minimal replay.
+#ifndef FUZZ_H
+#define FUZZ_H
+
+#include "simulation.h"
+#include "invariants.h"
+#include <string>
+#include <vector>
+
+// A fully materialised case: start position and the keys both players hold on every tick
+struct FuzzCase {
+    uint8_t weapon = WEAPON_EPEE;
+    int distance = SIM_START_X2 - SIM_START_X1;
+    std::vector<InputWord> inputs[2];
+
+    size_t ticks() const { return inputs[0].size(); }
+};
+
+// Result of replaying a case: the first broken invariant and the tick it broke on
+struct FuzzResult {
+    uint8_t invariant = INVARIANT_NONE;
+    size_t tick = 0;
+};
+
+FuzzResult runFuzzCase(const FuzzCase& fuzzCase);
+FuzzCase generateFuzzCase(uint64_t seed, size_t maxTicks);
+FuzzCase shrinkFuzzCase(const FuzzCase& fuzzCase, uint8_t invariant);
+bool saveFuzzCase(const FuzzCase& fuzzCase, const std::string& path);
+bool loadFuzzCase(FuzzCase& fuzzCase, const std::string& path);
+
+#endif // FUZZ_H
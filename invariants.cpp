@@ -0,0 +1,53 @@
+#include "invariants.h"
+
+const char* const INVARIANT_NAMES[INVARIANT_COUNT] = {
+    "none", "position", "overlap", "velocity", "action", "touch_reset", "points", "period", "clock", "game_over"
+};
+
+static bool boxActive(const SimRect& rect) {
+    return rect.w > 0 && rect.h > 0;
+}
+
+uint8_t checkInvariants(const MatchState& before, const MatchState& after, uint8_t events) {
+    bool touched = (events & (EVENT_TOUCH_P1 | EVENT_TOUCH_P2)) != 0;
+
+    for (int p = 0; p < 2; ++p) {
+        const FencerState& fencer = after.fencers[p];
+        if (fencer.x < 0 || fencer.x > SIM_MAX_X) return INVARIANT_POSITION;
+        if (fencer.velocityX != 0 && fencer.velocityX != SIM_WALK_SPEED && fencer.velocityX != -SIM_WALK_SPEED) {
+            return INVARIANT_VELOCITY;
+        }
+
+        if (fencer.action >= ACTION_COUNT || fencer.actionTicks >= SIM_ACTION_TICKS) return INVARIANT_ACTION;
+        if (fencer.action == ACTION_IDLE && fencer.actionTicks != 0) return INVARIANT_ACTION;
+        bool striking = fencer.action == ACTION_ATTACK || fencer.action == ACTION_STRIKE_LOWHIGH ||
+                        fencer.action == ACTION_STRIKE_HIGHLOW;
+        if (boxActive(fencerHitbox(after, p)) != striking) return INVARIANT_ACTION;
+        if (boxActive(fencerParryBox(after, p)) != fencerParrying(fencer)) return INVARIANT_ACTION;
+
+        if (touched) {
+            int startX = p == 0 ? SIM_START_X1 : SIM_START_X2;
+            if (fencer.x != startX || fencer.velocityX != 0 || fencer.action != ACTION_IDLE) return INVARIANT_TOUCH_RESET;
+            if (boxActive(fencerHitbox(after, p)) || boxActive(fencerParryBox(after, p))) return INVARIANT_TOUCH_RESET;
+        }
+    }
+    if (fencerDistance(after) < 0 || after.fencers[0].x > after.fencers[1].x) return INVARIANT_OVERLAP;
+
+    // One touch per tick, and only the touched player loses a point
+    if ((events & EVENT_TOUCH_P1) && (events & EVENT_TOUCH_P2)) return INVARIANT_POINTS;
+    for (int p = 0; p < 2; ++p) {
+        int lost = (events & (p == 0 ? EVENT_TOUCH_P2 : EVENT_TOUCH_P1)) ? 1 : 0;
+        if (after.points[p] < 0 || after.points[p] != before.points[p] - lost) return INVARIANT_POINTS;
+    }
+
+    if (after.period < 1 || after.period > SIM_PERIODS) return INVARIANT_PERIOD;
+    if (after.period != before.period + ((events & EVENT_PERIOD) ? 1 : 0)) return INVARIANT_PERIOD;
+    if (before.suddenDeath && !after.suddenDeath) return INVARIANT_PERIOD;
+
+    if (after.tick != before.tick + 1) return INVARIANT_CLOCK;
+    if (!after.suddenDeath && after.periodTicks > SIM_PERIOD_TICKS) return INVARIANT_CLOCK;
+
+    if (((events & EVENT_GAME_OVER) != 0) != (after.over && !before.over)) return INVARIANT_GAME_OVER;
+    if ((after.points[0] <= 0 || after.points[1] <= 0) && !after.over) return INVARIANT_GAME_OVER;
+    return INVARIANT_NONE;
+}
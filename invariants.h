@@ -0,0 +1,28 @@
+// Invariants of the match rules, checked after every tick by the fuzzer and, in live play, on the
+// match the game plays and draws, next to the flight recorder. A fencer stuck in an action
+// (INVARIANT_ACTION) or a point taken from the wrong fencer (INVARIANT_POINTS) is caught as it happens.
+#ifndef INVARIANTS_H
+#define INVARIANTS_H
+
+#include "simulation.h"
+
+// Invariants checked after every tick
+enum FuzzInvariant : uint8_t {
+    INVARIANT_NONE,
+    INVARIANT_POSITION,    // Both fencers on screen
+    INVARIANT_OVERLAP,     // Hurtboxes never overlap and player 1 stays on the left
+    INVARIANT_VELOCITY,    // velocityX is -SIM_WALK_SPEED, 0 or SIM_WALK_SPEED
+    INVARIANT_ACTION,      // One valid action at a time, with only its own hitbox or parry box
+    INVARIANT_TOUCH_RESET, // A touch puts both fencers back on guard with no boxes left active
+    INVARIANT_POINTS,      // Points never negative, and only the touched player loses exactly one
+    INVARIANT_PERIOD,      // Period between 1 and SIM_PERIODS and never going back
+    INVARIANT_CLOCK,       // tick advances by one, periodTicks stays inside a period
+    INVARIANT_GAME_OVER,   // EVENT_GAME_OVER exactly when the bout ends
+    INVARIANT_COUNT
+};
+
+extern const char* const INVARIANT_NAMES[INVARIANT_COUNT];
+
+uint8_t checkInvariants(const MatchState& before, const MatchState& after, uint8_t events);
+
+#endif // INVARIANTS_H
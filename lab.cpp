@@ -0,0 +1,132 @@
+#include "lab.h"
+#include "simulation.h"
+#include "replay.h"
+#include <iostream>
+#include <map>
+#include <functional>
+#include <sstream>
+#include <thread>
+#include <cstdlib>
+#include <filesystem>
+#include <algorithm>
+
+struct LabCommand {
+    std::string description;
+    std::function<int(int, char*[])> run;
+};
+
+static int findOption(int argc, char* argv[], const std::string& name) {
+    for (int i = 0; i < argc; ++i) {
+        if (name == argv[i]) return i;
+    }
+    return -1;
+}
+
+int intOption(int argc, char* argv[], const std::string& name, int defaultValue) {
+    int index = findOption(argc, argv, name);
+    if (index < 0 || index + 1 >= argc) return defaultValue;
+    return std::atoi(argv[index + 1]);
+}
+
+std::string stringOption(int argc, char* argv[], const std::string& name, const std::string& defaultValue) {
+    int index = findOption(argc, argv, name);
+    if (index < 0 || index + 1 >= argc) return defaultValue;
+    return argv[index + 1];
+}
+
+// Comma-separated list, e.g. --distances 454,300,150
+std::vector<int> intListOption(int argc, char* argv[], const std::string& name, const std::vector<int>& defaultValue) {
+    int index = findOption(argc, argv, name);
+    if (index < 0 || index + 1 >= argc) return defaultValue;
+
+    std::vector<int> values;
+    std::stringstream stream(argv[index + 1]);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) values.push_back(std::atoi(item.c_str()));
+    }
+    return values;
+}
+
+bool flagOption(int argc, char* argv[], const std::string& name) {
+    return findOption(argc, argv, name) >= 0;
+}
+
+std::vector<int> weaponOption(int argc, char* argv[]) {
+    std::string name = stringOption(argc, argv, "--weapon", "all");
+    if (name == "all") return {WEAPON_EPEE, WEAPON_SABRE};
+
+    int weapon = weaponFromName(name.c_str());
+    if (weapon < 0) {
+        std::cerr << "Unknown weapon: " << name << " (expected Epee, Sabre or all)" << std::endl;
+        return {};
+    }
+    return {weapon};
+}
+
+int threadOption(int argc, char* argv[]) {
+    int threads = intOption(argc, argv, "--threads", static_cast<int>(std::thread::hardware_concurrency()));
+    return threads > 0 ? threads : 1;
+}
+
+// Replay files named on the command line, directories searched recursively for *.rpl
+std::vector<std::string> collectReplays(int argc, char* argv[], const std::vector<std::string>& valueOptions) {
+    std::vector<std::string> paths;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            if (std::find(valueOptions.begin(), valueOptions.end(), arg) != valueOptions.end()) i++; // Skip the option's value
+            continue;
+        }
+
+        std::error_code error;
+        if (std::filesystem::is_directory(arg, error)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(arg, error)) {
+                if (entry.is_regular_file() && entry.path().extension() == REPLAY_EXTENSION) {
+                    paths.push_back(entry.path().string());
+                }
+            }
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+int main(int argc, char* argv[]) {
+    std::map<std::string, LabCommand> commands = {
+        {"solve", {"Game-tree search for dominant and never-losing lines", runSolver}},
+        {"framedata", {"Frame-advantage matrix and punish windows for every pair of actions", runFrameData}},
+        {"fuzz", {"Random input streams checked against the match invariants every tick", runFuzz}},
+        {"balance", {"Monte Carlo touch rates per move pair, distance band and weapon", runBalance}},
+        {"verify", {"Re-simulate replay files and report bouts whose checkpoint hashes or outcome changed", runVerify}},
+        {"record", {"Write replays of random-input bouts to build a test archive", runRecord}},
+        {"seek", {"Show the match at any tick of a replay through its keyframes and time random seeks", runSeek}},
+        {"bisect", {"Find the first tick and the fields where two builds part on a replay, by bisecting its keyframes", runBisect}},
+        {"flight", {"Play a random bout through the flight recorder, time it and check its dump re-simulates", runFlight}},
+        {"compress", {"Time the replay codecs on the keys and states of random-input bouts and check they round-trip", runCompress}},
+        {"mcts", {"Bouts between the MCTS opponent and random moves or another budget", runMcts}},
+        {"alphabeta", {"Bouts between the alpha-beta opponent and random moves or the MCTS opponent", runAlphaBeta}},
+        {"book", {"Search the alpha-beta opponent's responses offline and write the opening book", runBook}},
+        {"tablebase", {"Solve close-range exchanges by retrograde analysis and write the tablebase", runTablebase}},
+        {"policy", {"Benchmark the int8 policy network and play it against random moves", runPolicy}},
+        {"train", {"Evolution-strategies training of the policy network over simulated bouts", runTrain}},
+        {"tree", {"Play a behavior-tree bot and time a drill of many of them", runTree}},
+        {"script", {"Compile a bot script, play it and time a drill of many script bots", runScript}},
+        {"model", {"Train the n-gram opponent model on replays or a habitual player and score its predictions", runModel}},
+        {"sandbox", {"Run a script or tree bot in a child process and time its shared-memory round trips", runSandbox}},
+        {"plugin", {"List the bot plugins in plugins/, or play one against random moves and time it", runPlugin}},
+        {"dataset", {"Summarise imitation-learning datasets, or capture random bouts and check the file", runDataset}},
+    };
+
+    if (argc < 2 || commands.find(argv[1]) == commands.end()) {
+        std::cerr << "Usage: FencingLab <command> [options]\n\nCommands:\n";
+        for (const auto& [name, command] : commands) {
+            std::cerr << "  " << name << "\t" << command.description << "\n";
+        }
+        return 1;
+    }
+
+    return commands[argv[1]].run(argc - 2, argv + 2);
+}
@@ -0,0 +1,43 @@
+// FencingLab: headless analysis tools built on the simulation in simulation.h.
+// Each tool is a subcommand (FencingLab <command> [--option value ...]).
+#ifndef LAB_H
+#define LAB_H
+
+#include <string>
+#include <vector>
+
+// Declare option helpers shared by the subcommands
+int intOption(int argc, char* argv[], const std::string& name, int defaultValue);
+std::string stringOption(int argc, char* argv[], const std::string& name, const std::string& defaultValue);
+std::vector<int> intListOption(int argc, char* argv[], const std::string& name, const std::vector<int>& defaultValue);
+bool flagOption(int argc, char* argv[], const std::string& name);
+std::vector<int> weaponOption(int argc, char* argv[]); // --weapon Epee|Sabre|all
+int threadOption(int argc, char* argv[]);              // --threads, defaults to every core
+// Non-option arguments as replay files, directories searched recursively; valueOptions take a value
+std::vector<std::string> collectReplays(int argc, char* argv[], const std::vector<std::string>& valueOptions);
+
+// Declare subcommands
+int runSolver(int argc, char* argv[]);
+int runFrameData(int argc, char* argv[]);
+int runFuzz(int argc, char* argv[]);
+int runBalance(int argc, char* argv[]);
+int runVerify(int argc, char* argv[]);
+int runRecord(int argc, char* argv[]);
+int runSeek(int argc, char* argv[]);
+int runCompress(int argc, char* argv[]);
+int runBisect(int argc, char* argv[]);
+int runFlight(int argc, char* argv[]);
+int runMcts(int argc, char* argv[]);
+int runAlphaBeta(int argc, char* argv[]);
+int runBook(int argc, char* argv[]);
+int runTablebase(int argc, char* argv[]);
+int runPolicy(int argc, char* argv[]);
+int runTrain(int argc, char* argv[]);
+int runTree(int argc, char* argv[]);
+int runScript(int argc, char* argv[]);
+int runModel(int argc, char* argv[]);
+int runSandbox(int argc, char* argv[]);
+int runPlugin(int argc, char* argv[]);
+int runDataset(int argc, char* argv[]);
+
+#endif // LAB_H
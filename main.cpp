@@ -1,11 +1,27 @@
 #include "common.h" // Include common.h for global variables
 #include "character.h"
 #include "menu.h"
+#include "replay.h"
+#include "mcts.h"
+#include "alphabeta.h"
+#include "speculate.h"
+#include "sandbox.h"
+#include "botplugin.h"
+#include "dataset.h"
+#include "policy.h"
+#include "behaviortree.h"
+#include "botscript.h"
+#include "opponentmodel.h"
+#include "replayviewer.h"
+#include "review.h"
+#include "flightrecorder.h"
+#include "invariants.h"
 #include <iostream>
 #include <SDL.h>
 #include <SDL_image.h>
 #include <filesystem> // For checking the working directory
 #include <fstream>
+#include <memory>
 std::string weaponType = "Epee"; // Default weapon type
 
 // Winning conditions
@@ -15,6 +31,7 @@ std::string weaponType = "Epee"; // Default weapon type
  int player2Score = 0; // Define the variable
 bool gameOver = false; // Flag to indicate if the game is over
 std::string winner = ""; // Stores the winner ("Player 1", "Player 2", or "Draw")
+static FlightRecorder flight; // The last minute of the bout, written to flight/ on a crash, F12 or a broken invariant
 
 int main(int argc, char* argv[]) {
     // Redirect std::cout to both console and game_log.txt
@@ -29,9 +46,6 @@ int main(int argc, char* argv[]) {
     dualOutput.rdbuf(logBuf);
     std::cout.rdbuf(dualOutput.rdbuf());
 
-    Uint32 lastInputTimePlayer1 = 0; // Timestamp of the last input for Player 1
-    Uint32 lastInputTimePlayer2 = 0; // Timestamp of the last input for Player 2
-    const Uint32 inputCooldown = 50; // Cooldown duration in milliseconds
     bool paused = false; // Track whether the game is paused
     bool pauseMenuNeedsUpdate = true; // Set to true when the pause menu needs to be re-rendered (prevent flickering)
 
@@ -57,6 +71,38 @@ int main(int argc, char* argv[]) {
     // Load key mappings from input.txt
     loadKeyMappings("input.txt");
 
+    // CPU difficulty is its search budget per frame: --cpu-level 1 (easiest) to 4.
+    // --cpu mcts|alphabeta|policy|tree|script|sandbox picks the opponent; policy plays the network in
+    // policy.bin, tree and script the file given by --cpu-script, at every level. sandbox runs that file
+    // (a .bot script or .bt tree) in FencingBotHost, a process of its own built next to the game, so a
+    // broken bot cannot crash or stall the game.
+    int cpuLevel = 2;
+    std::string cpuKind = "mcts";
+    std::string cpuScript;
+    std::string profile = "player1"; // --profile: whose habits the opponent model learns (profiles/<name>.ngram)
+    std::string replayFile; // --replay: plays a recorded bout back instead of opening the menu
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--cpu-level") cpuLevel = std::atoi(argv[i + 1]);
+        if (std::string(argv[i]) == "--cpu") cpuKind = argv[i + 1];
+        if (std::string(argv[i]) == "--cpu-script") cpuScript = argv[i + 1];
+        if (std::string(argv[i]) == "--profile") profile = argv[i + 1];
+        if (std::string(argv[i]) == "--replay") replayFile = argv[i + 1];
+    }
+    // Bouts between two people are captured to datasets/ for imitation learning unless --no-capture is given
+    bool capture = true;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--no-capture") capture = false;
+    }
+    if (cpuScript.empty()) cpuScript = cpuKind == "script" || cpuKind == "sandbox" ? "bots/counter.bot" : "bots/riposte.bt";
+    bool cpuOpponent = false; // Player 2 is played by the CPU
+
+    // Bot plugins from plugins/; the menu assigns each to either player, taking over from the keyboard or CPU
+    std::vector<std::string> pluginErrors;
+    std::vector<std::unique_ptr<BotPlugin>> plugins = discoverPlugins(PLUGIN_DIRECTORY, pluginErrors);
+    for (const std::string& error : pluginErrors) std::cerr << "Ignoring plugin " << error << std::endl;
+    if (plugins.size() > MENU_MAX_PLUGINS) plugins.resize(MENU_MAX_PLUGINS); // Room left on the menu
+    BotPlugin* pluginSlots[2] = {nullptr, nullptr};
+
     INITSDL app("OFFencing", SCREEN_WIDTH, SCREEN_HEIGHT, fontPath);
 
 
@@ -75,20 +121,36 @@ int main(int argc, char* argv[]) {
         { // menuOptions
             {1, "Start with Epee"},
             {2, "Start with Sabre"},
-            {3, "Exit"}
+            {3, "Epee vs CPU"},
+            {4, "Sabre vs CPU"},
+            {5, "Exit"}
         },
         { // menuActions
-            {1, [&inMenu]() { 
+            {1, [&inMenu, &cpuOpponent]() { 
                 std::cout << "Starting the game with Epee...\n"; 
                 weaponType = "Epee"; // Set weapon type
+                cpuOpponent = false;
                 inMenu = false; // Exit menu state and transition to the game
             }},
-            {2, [&inMenu]() { 
+            {2, [&inMenu, &cpuOpponent]() { 
                 std::cout << "Starting the game with Sabre...\n"; 
                 weaponType = "Sabre"; // Set weapon type
+                cpuOpponent = false;
                 inMenu = false; // Exit menu state and transition to the game
             }},
-            {3, []() { 
+            {3, [&inMenu, &cpuOpponent]() {
+                std::cout << "Starting the game with Epee against the CPU...\n";
+                weaponType = "Epee";
+                cpuOpponent = true;
+                inMenu = false;
+            }},
+            {4, [&inMenu, &cpuOpponent]() {
+                std::cout << "Starting the game with Sabre against the CPU...\n";
+                weaponType = "Sabre";
+                cpuOpponent = true;
+                inMenu = false;
+            }},
+            {5, []() { 
                 std::cout << "Exiting the game...\n"; 
                 exit(0); // Exit the game
             }}
@@ -97,6 +159,29 @@ int main(int argc, char* argv[]) {
         app.font,       // Pass the TTF_Font
         SDL_Color{0, 0, 0, 255} // Black text color
     };
+    // One option per plugin before Exit, cycling it through player 1, player 2, both and neither
+    int exitKey = static_cast<int>(menu.menuOptions.size());
+    std::string exitOption = menu.menuOptions[exitKey];
+    std::function<void()> exitAction = menu.menuActions[exitKey];
+    for (const auto& plugin : plugins) {
+        BotPlugin* bot = plugin.get();
+        menu.menuOptions[exitKey] = "Plugin " + bot->name;
+        menu.menuActions[exitKey] = [&pluginSlots, bot]() {
+            int sides = ((pluginSlots[0] == bot ? 1 : 0) | (pluginSlots[1] == bot ? 2 : 0)) + 1;
+            for (int slot = 0; slot < 2; ++slot) {
+                if (sides & (1 << slot)) {
+                    pluginSlots[slot] = bot;
+                } else if (pluginSlots[slot] == bot) {
+                    pluginSlots[slot] = nullptr;
+                }
+            }
+            static const char* const sideNames[4] = {"neither player", "player 1", "player 2", "both players"};
+            std::cout << "Plugin " << bot->name << " plays " << sideNames[sides % 4] << "\n";
+        };
+        exitKey++;
+    }
+    menu.menuOptions[exitKey] = exitOption;
+    menu.menuActions[exitKey] = exitAction;
     PAUSEMENU pause; //create pause menu
 
     // Render the menu once before entering the game loop
@@ -133,8 +218,6 @@ int main(int argc, char* argv[]) {
     player2.loadAnimationFrames("strike_highlow", {"assets/player_strike_lower1.png", "assets/player_strike_lower2.png"}, app.renderer);
     player2.initializeHurtbox();
 
-    std::deque<std::string> player1InputBuffer; // Stores recent inputs for Player 1
-    std::deque<std::string> player2InputBuffer; // Stores recent inputs for Player 2
     // player1.initializeMovelist(); outdated functions
     // player2.initializeMovelist();
 
@@ -151,6 +234,16 @@ int main(int argc, char* argv[]) {
         "assets/player_mov3.png"
     }, app.renderer);
 
+    if (!replayFile.empty()) {
+        int result = runReplayViewer(app, backgroundTexture, player1, player2, replayFile);
+        SDL_DestroyTexture(backgroundTexture);
+        player1.cleanupAnimationFrames();
+        player2.cleanupAnimationFrames();
+        player1.cleanup();
+        player2.cleanup();
+        return result;
+    }
+
     // Input buffers for both players
     InputBuffer player1Buffer;
     InputBuffer player2Buffer;
@@ -170,16 +263,99 @@ int main(int argc, char* argv[]) {
     Uint32 lastTime = SDL_GetTicks();
     int fps = 0;
 
-    // Add timer and period management
-    Uint32 periodStartTime = SDL_GetTicks();
-    int currentPeriod = 1; // Start with the first period
-    bool suddenDeath = false; // Track if the game is in sudden-death mode
-    
     Uint32 frameStart, frameEnd;
-    float deltaTime = 0.0f;
 
-    InputHistory player1InputHistory;
-    InputHistory player2InputHistory;
+    // The bout itself: stepped once a frame with the keys held, drawn from the state it is in and recorded
+    // as a replay. Touches, the period clock and the score are its rules (simulation.cpp) and its ticks.
+    MatchState match;
+    ReplayWriter replay;
+    ReplayHeader replayHeader; // This bout's, for the replay opened again after an annulled touch
+    bool recording = false;
+    static ReviewRing review; // The last ten seconds, for a referee review (F11)
+    bool flightDumped = false; // One invariant dump a bout; the first break is the one worth reading
+    installFlightRecorder(flight, FLIGHT_DIRECTORY);
+
+    // Only the opponent picked with --cpu is built, on the first bout against the CPU: the searchers run
+    // threads of their own and the sandbox a process, none of which a bout between two people needs
+    OpeningBook book;          // Written by "FencingLab book"; without it every decision is searched
+    Tablebase tablebase;       // Written by "FencingLab tablebase"
+    PolicyNetwork network;     // Written by "FencingLab policy --init" or the trainer
+    BehaviorTree sparringTree; // One of the trees in bots/
+    ScriptProgram userProgram; // A club member's bot from bots/, compiled for player 2
+    std::unique_ptr<MctsBot> cpu;            // Searches for a fixed slice of every frame on its own threads
+    std::unique_ptr<SpeculativeBot> minimax; // Searches the likely next decision states in the frame's idle time
+    std::unique_ptr<PolicyBot> learned;
+    std::unique_ptr<BtBot> sparring;
+    std::unique_ptr<ScriptBot> userBot;
+    BotSandbox isolated; // Answers within SANDBOX_DEADLINE_MICROS or plays no keys that tick
+    bool sandboxed = false; // isolated has started
+    OpponentModel habits(0); // Player 1 as the CPU sees them, carried across sessions
+    std::string profilePath = "profiles/" + profile + ".ngram";
+    if (std::filesystem::exists(profilePath)) {
+        std::string error;
+        if (!habits.load(profilePath, error)) std::cerr << "Ignoring " << profilePath << ": " << error << std::endl;
+    }
+    // A bot whose file cannot be used falls back to the search
+    auto startCpu = [&]() {
+        std::string error;
+        if (cpuKind == "policy" && !learned) {
+            if (network.load("policy.bin", error)) {
+                learned = std::make_unique<PolicyBot>(network, 1);
+            } else {
+                std::cerr << "Cannot use policy.bin (" << error << "), the CPU searches instead" << std::endl;
+                cpuKind = "mcts";
+            }
+        }
+        if (cpuKind == "tree" && !sparring) {
+            if (sparringTree.load(cpuScript, error)) {
+                sparring = std::make_unique<BtBot>(sparringTree, 1);
+            } else {
+                std::cerr << "Cannot use " << cpuScript << " (" << error << "), the CPU searches instead" << std::endl;
+                cpuKind = "mcts";
+            }
+        }
+        if (cpuKind == "script" && !userBot) {
+            if (userProgram.load(cpuScript, 1, error)) {
+                userBot = std::make_unique<ScriptBot>(userProgram, 1);
+                userBot->model = &habits;
+            } else {
+                std::cerr << "Cannot use " << cpuScript << " (" << error << "), the CPU searches instead" << std::endl;
+                cpuKind = "mcts";
+            }
+        }
+        if (cpuKind == "sandbox" && !sandboxed) {
+            sandboxed = isolated.start(cpuScript, 1);
+            if (!sandboxed) {
+                std::cerr << "Cannot use " << cpuScript << " (" << isolated.error << "), the CPU searches instead" << std::endl;
+                cpuKind = "mcts";
+            }
+        }
+        if (cpuKind == "alphabeta" && !minimax) {
+            AlphaBetaConfig minimaxConfig;
+            minimaxConfig.budgetMicros = mctsLevel(cpuLevel).budgetMicros; // Only on the frames where it picks a move
+            minimax = std::make_unique<SpeculativeBot>(1, minimaxConfig);
+            if (std::filesystem::exists("book.bin")) {
+                if (book.open("book.bin")) minimax->attach(&book, minimax->bot.tablebase);
+                else std::cerr << "Ignoring book.bin: " << book.error << std::endl;
+            }
+            if (std::filesystem::exists("tablebase.bin")) {
+                if (tablebase.open("tablebase.bin")) minimax->attach(minimax->bot.book, &tablebase);
+                else std::cerr << "Ignoring tablebase.bin: " << tablebase.error << std::endl;
+            }
+            minimax->model = &habits;
+        }
+        if (!learned && !sparring && !userBot && !sandboxed && !minimax && !cpu) {
+            cpu = std::make_unique<MctsBot>(1, mctsLevel(cpuLevel));
+        }
+    };
+    auto saveHabits = [&]() {
+        std::error_code error;
+        std::filesystem::create_directories("profiles", error);
+        if (!habits.save(profilePath)) std::cerr << "Failed to save " << profilePath << std::endl;
+    };
+    PluginBot pluginBots[2]; // Started from pluginSlots for each bout
+    DatasetWriter dataset;   // One file per session, opened by the first bout between two people
+    bool capturing = false;  // This bout is being captured
 
     while (running) {
         frameStart = SDL_GetTicks(); // Start of the frame
@@ -204,6 +380,38 @@ int main(int argc, char* argv[]) {
             if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_p) {
                 paused = !paused; // Toggle the paused state
             }
+
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F12) {
+                // Saves the last minute for a bug report, like a crash would
+                std::string flightPath = replayPath(FLIGHT_DIRECTORY);
+                if (flight.dump(flightPath.c_str())) std::cout << "Saved the last minute of play to " << flightPath << std::endl;
+                else std::cerr << "Nothing to save to " << flightPath << std::endl;
+            }
+
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == REVIEW_KEY && recording && !paused) {
+                // The bout is frozen while the referee looks: no tick is played, so its clock stands still
+                int loser = review.loser;
+                ReviewCall call = runReview(app, backgroundTexture, player1, player2, review, match);
+                if (call == REVIEW_ANNULLED) {
+                    // The bout goes back to the tick before the touch, point and all. That is not a tick of
+                    // the rules, so the replay so far is closed and the rest goes to a new one from here.
+                    match = review.annul();
+                    handleRoundEnd(match, player1, player2, player1Points, player2Points);
+                    if (!replay.close()) std::cerr << "Failed to save the replay " << replay.path << std::endl;
+                    if (!replay.open(replayPath("replays"), replayHeader, match)) {
+                        std::cerr << "Cannot record to " << replay.path << ", the rest of this bout has no replay" << std::endl;
+                    }
+                    flight.start(replayHeader, match);
+                    std::cout << "Referee annulled the touch: P" << loser + 1 << " gets the point back" << std::endl;
+                } else if (call == REVIEW_CONFIRMED) {
+                    std::cout << "Referee confirmed the touch against P" << loser + 1 << std::endl;
+                } else if (call == REVIEW_QUIT) {
+                    running = false;
+                }
+                player1Buffer.clear(); // Key releases went to the review
+                player2Buffer.clear();
+                continue;
+            }
     
             if (paused) {
                 if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT) {
@@ -224,178 +432,155 @@ int main(int argc, char* argv[]) {
                 continue; // Skip the rest of the game loop
             }
 
-            if (!inMenu) {
-                processInput(event, player1InputHistory, player1Commands, player1, player1KeyMappings);
-                processInput(event, player2InputHistory, player2Commands, player2, player2KeyMappings);
+            // The buffers hold the keys that are down; the bout reads them once a frame
+            // Player 1 input
+            if (!pluginBots[0].active() && (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)) {
+                bool isKeyDown = (event.type == SDL_KEYDOWN);
+                auto it = player1KeyMappings.find(event.key.keysym.sym);
+                if (it != player1KeyMappings.end()) {
+                    const std::string& action = it->second;
+
+                    if (action == "up") player1Buffer.up = isKeyDown;
+                    else if (action == "down") player1Buffer.down = isKeyDown;
+                    else if (action == "left") player1Buffer.left = isKeyDown;
+                    else if (action == "right") player1Buffer.right = isKeyDown;
+                    else if (action == "attack") player1Buffer.attack = isKeyDown;
+                }
             }
-    
-            if (!inMenu) {
-                // Set weapon type and initialize hurtboxes for both players
+
+            // Player 2 input
+            if (!cpuOpponent && !pluginBots[1].active() && (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)) {
+                bool isKeyDown = (event.type == SDL_KEYDOWN);
+                auto it2 = player2KeyMappings.find(event.key.keysym.sym);
+                if (it2 != player2KeyMappings.end()) {
+                    const std::string& action = it2->second;
+
+                    if (action == "up") player2Buffer.up = isKeyDown;
+                    else if (action == "down") player2Buffer.down = isKeyDown;
+                    else if (action == "left") player2Buffer.left = isKeyDown;
+                    else if (action == "right") player2Buffer.right = isKeyDown;
+                    else if (action == "attack") player2Buffer.attack = isKeyDown;
+                }
+            }
+        }
+
+        if (!inMenu && !paused) {
+            if (!recording) {
+                int weapon = weaponFromName(weaponType.c_str());
+                initMatch(match, static_cast<uint8_t>(weapon < 0 ? WEAPON_EPEE : weapon));
                 player1.setWeaponType(weaponType);
-                player1.initializeHurtbox();
                 player2.setWeaponType(weaponType);
-                player2.initializeHurtbox();
-
-                // Player 1 input
-                if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
-                    bool isKeyDown = (event.type == SDL_KEYDOWN);
-                    auto it = player1KeyMappings.find(event.key.keysym.sym);
-                    if (it != player1KeyMappings.end()) {
-                        const std::string& action = it->second;
-                        
-                        Uint32 currentTime = SDL_GetTicks();
-                        if (isKeyDown && (currentTime - lastInputTimePlayer1 >= inputCooldown)) {
-                            player1InputBuffer.push_back(action); // Add input to Player 1's buffer
-                            lastInputTimePlayer1 = currentTime; // Update the last input time
-                            std::cout << "Player 1 Action: " << action << std::endl; // Debug: Log action
-                        }
-
-                        if (action == "up") player1Buffer.up = isKeyDown;
-                        else if (action == "down") player1Buffer.down = isKeyDown;
-                        else if (action == "left") player1Buffer.left = isKeyDown;
-                        else if (action == "right") player1Buffer.right = isKeyDown;
-                        else if (action == "attack") player1Buffer.attack = isKeyDown;
-
-                        std::cout << "Player 1 Input: " << action << " = " << isKeyDown << std::endl; // Debug log
-
+                player1.reset();
+                player2.reset();
+                player1Points = match.points[0];
+                player2Points = match.points[1];
+                replayHeader = ReplayHeader();
+                for (int i = 0; i < INPUT_SYMBOLS; ++i) {
+                    for (const auto& mapping : player1KeyMappings) {
+                        if (mapping.second == INPUT_NAMES[i]) replayHeader.keys[0][i] = mapping.first;
+                    }
+                    for (const auto& mapping : player2KeyMappings) {
+                        if (mapping.second == INPUT_NAMES[i]) replayHeader.keys[1][i] = mapping.first;
                     }
                 }
-    
-                    // Player 2 input
-                if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
-                    bool isKeyDown = (event.type == SDL_KEYDOWN);
-                    auto it2= player2KeyMappings.find(event.key.keysym.sym);
-                    if (it2 != player2KeyMappings.end()) {
-                        const std::string& action = it2->second;
-
-                        Uint32 currentTime = SDL_GetTicks();
-                        if (isKeyDown && (currentTime - lastInputTimePlayer2 >= inputCooldown)) {
-                            player2InputBuffer.push_back(action); // Add input to Player 2's buffer
-                            lastInputTimePlayer2 = currentTime; // Update the last input time
-                            std::cout << "Player 2 Action: " << action << std::endl; // Debug: Log action
-                        }
-
-                        if (action == "up") player2Buffer.up = isKeyDown;
-                        else if (action == "down") player2Buffer.down = isKeyDown;
-                        else if (action == "left") player2Buffer.left = isKeyDown; // Ensure "left" is handled
-                        else if (action == "right") player2Buffer.right = isKeyDown;
-                        else if (action == "attack") player2Buffer.attack = isKeyDown;
-
-                        std::cout << "Player 1 Input: " << action << " = " << isKeyDown << std::endl; // Debug log
-
-                        if (isKeyDown) {
-                            player2InputBuffer.push_back(action); // Add input to Player 2's buffer
-                            std::cout << "Player 2 Action: " << action << std::endl; // Debug: Log action
-                        }
+                std::error_code replayError;
+                std::filesystem::create_directories("replays", replayError);
+                if (!replay.open(replayPath("replays"), replayHeader, match)) {
+                    std::cerr << "Cannot record to " << replay.path << ", this bout has no replay" << std::endl;
+                }
+                flight.start(replayHeader, match);
+                flightDumped = false;
+                review.clear();
+                recording = true;
+                if (cpuOpponent) {
+                    startCpu();
+                    if (cpu) cpu->reset();
+                    if (minimax) minimax->reset();
+                    if (learned) learned->reset();
+                    if (sparring) sparring->reset();
+                    if (userBot) userBot->reset();
+                    if (sandboxed) isolated.reset();
+                }
+                habits.startBout();
+                for (int slot = 0; slot < 2; ++slot) {
+                    if (!pluginSlots[slot]) continue;
+                    if (!pluginBots[slot].begin(pluginSlots[slot], slot)) {
+                        std::cerr << "Plugin " << pluginSlots[slot]->name << " refused to play (built for another version?)" << std::endl;
+                        pluginSlots[slot] = nullptr;
+                    }
+                }
+                capturing = capture && !cpuOpponent && !pluginBots[0].active() && !pluginBots[1].active();
+                if (capturing && !dataset.isOpen()) {
+                    std::error_code error;
+                    std::filesystem::create_directories("datasets", error);
+                    if (!dataset.open(datasetPath("datasets"))) {
+                        std::cerr << "Cannot capture to " << dataset.path << ", this session is not recorded" << std::endl;
+                        capture = capturing = false;
                     }
                 }
+                if (capturing) dataset.beginBout();
             }
-            if (!inMenu) {
-                // Update input buffers
-                processPlayerInput(event, player1InputBuffer, player1KeyMappings);
-                processPlayerInput(event, player2InputBuffer, player2KeyMappings);
+            InputWord player1Input = player1Buffer.inputWord();
+            InputWord player2Input = player2Buffer.inputWord();
+            if (cpuOpponent && !pluginBots[1].active()) {
+                // The CPU holds keys like a player would, deciding from the bout on screen
+                player2Input = minimax     ? minimax->update(match)
+                               : learned   ? learned->update(match)
+                               : sparring  ? sparring->update(match)
+                               : userBot   ? userBot->update(match)
+                               : sandboxed ? isolated.update(match)
+                                           : cpu->update(match);
             }
-        }
-
-        
-        Uint32 currentTimestamp = SDL_GetTicks();
-
-        // Process inputs for Player 1
-        player1.processInputBuffer(player1Buffer);
-
-        // Process inputs for Player 2
-        player2.processInputBuffer(player2Buffer);
-
-
-        // Update the state of Player 1 and Player 2
-        player1.updateState(player2);
-        player2.updateState(player1);
-
-        // Limit the size of the input buffer for Player 1
-        if (player1InputBuffer.size() > 10) {
-            player1InputBuffer.pop_front();
-        }
-
-        if (player1.checkCollision(player2.hurtbox)) {
-            // Check if Player 2 is not performing a parry action
-            if (player2.getCurrentAction() != "parry_high" &&
-                player2.getCurrentAction() != "parry_low" &&
-                player2.getCurrentAction() != "parry_mid") {
-                handleRoundEnd(player2, player1, player1, player2, player1Points, player2Points, periodStartTime);
-            } else {
-                std::cout << "Player 2 successfully parried Player 1's attack!" << std::endl;
+            // Plugins read the match in place and hold keys the same way
+            if (pluginBots[0].active()) player1Input = pluginBots[0].update(match);
+            if (pluginBots[1].active()) player2Input = pluginBots[1].update(match);
+            if (capturing) dataset.record(match, player1Input, player2Input); // Only queued; written on the dataset's thread
+            MatchState before = match;
+            uint8_t events = stepMatch(match, player1Input, player2Input);
+            replay.record(player1Input, player2Input, match); // Only packed and queued; written on the replay's thread
+            flight.record(player1Input, player2Input, match);
+            review.record(match);
+            uint8_t broken = checkInvariants(before, match, events);
+            if (broken != INVARIANT_NONE && !flightDumped) {
+                std::string flightPath = replayPath(FLIGHT_DIRECTORY);
+                flightDumped = true;
+                if (flight.dump(flightPath.c_str())) {
+                    std::cerr << "Invariant broken at tick " << match.tick << " (" << INVARIANT_NAMES[broken] << "), the last minute is in "
+                              << flightPath << std::endl;
+                }
             }
-        } else if (player2.checkCollision(player1.hurtbox)) {
-            // Check if Player 1 is not performing a parry action
-            if (player1.getCurrentAction() != "parry_high" &&
-                player1.getCurrentAction() != "parry_low" &&
-                player1.getCurrentAction() != "parry_mid") {
-                handleRoundEnd(player1, player2, player1, player2, player1Points, player2Points, periodStartTime);
-            } else {
-                std::cout << "Player 1 successfully parried Player 2's attack!" << std::endl;
+            if (events & EVENT_TOUCH_P1) {
+                handleRoundEnd(match, player1, player2, player1Points, player2Points);
+                review.touch(1, before);
+            } else if (events & EVENT_TOUCH_P2) {
+                handleRoundEnd(match, player1, player2, player1Points, player2Points);
+                review.touch(0, before);
             }
-        }
-    
-        if (player1Points <= 0) {
-            winner = "Player 2";
-            running = false; // End the game
-        } else if (player2Points <= 0) {
-            winner = "Player 1";
-            running = false; // End the game
-        } else if (SDL_GetTicks() - periodStartTime >= 180000) { // Timer runs out (3 minutes)
-            if (player1Points > player2Points) {
-                winner = "Player 1";
-            } else if (player2Points > player1Points) {
-                winner = "Player 2";
-            } else {
-                winner = "Draw";
+            if (events & EVENT_PARRY_P2) std::cout << "Player 2 successfully parried Player 1's attack!" << std::endl;
+            if (events & EVENT_PARRY_P1) std::cout << "Player 1 successfully parried Player 2's attack!" << std::endl;
+            if (events & EVENT_PERIOD) std::cout << "Period " << static_cast<int>(match.period) << " started." << std::endl;
+            if (cpuOpponent) habits.watch(match);
+            if (cpuOpponent && minimax) minimax->speculate(match); // Searched while the frame sleeps
+            if (match.over) {
+                int result = matchWinner(match);
+                winner = result == 1 ? "Player 1" : result == 2 ? "Player 2" : "Draw";
+                running = false; // End the game
             }
-            running = false; // End the game
-        }
-        
-        // Limit the size of the input buffer for Player 2
-        if (player2InputBuffer.size() > 10) {
-            player2InputBuffer.pop_front();
-        }
-    
-        // Update Player 1's position
-        if (player1.dashDistanceRemaining > 0) {
-            float dashStep = 100 * deltaTime; // Adjust Dash Thrust speed to 100 pixels per second
-            dashStep = std::min(dashStep, player1.dashDistanceRemaining); // Clamp dashStep
-            player1.position.x += dashStep; // Move forward
-            player1.dashDistanceRemaining -= dashStep; // Reduce the remaining distance
-            if (player1.dashDistanceRemaining <= 0) {
-                player1.dashDistanceRemaining = 0; // Ensure it doesn't go negative
-                std::cout << "Player 1 dash ended." << std::endl;
-            }
-        } else {
-            // Normal movement logic
-            player1.move(SCREEN_WIDTH, SCREEN_HEIGHT, deltaTime);
+        } else if (inMenu && recording) {
+            // Back to the main menu: the bout is over
+            if (!replay.close()) std::cerr << "Failed to save the replay " << replay.path << std::endl;
+            if (cpuOpponent) saveHabits();
+            pluginBots[0].end();
+            pluginBots[1].end();
+            recording = false;
         }
 
-        // Update Player 2's position
-        if (player2.dashDistanceRemaining > 0) {
-            float dashStep = 100 * deltaTime; // Adjust Dash Thrust speed to 100 pixels per second
-            dashStep = std::min(dashStep, player2.dashDistanceRemaining); // Clamp dashStep
-            player2.position.x += dashStep; // Move forward
-            player2.dashDistanceRemaining -= dashStep; // Reduce the remaining distance
-            if (player2.dashDistanceRemaining <= 0) {
-                player2.dashDistanceRemaining = 0; // Ensure it doesn't go negative
-                std::cout << "Player 2 dash ended." << std::endl;
-            }
-        } else {
-            // Normal movement logic
-            player2.move(SCREEN_WIDTH, SCREEN_HEIGHT, deltaTime);
-        }
         // Main menu rendering
 
         if (inMenu) {
             // Reset game-specific variables when returning to the main menu
             player1.reset(); // Reset Player 1
             player2.reset(); // Reset Player 2
-            periodStartTime = SDL_GetTicks(); // Reset the timer
-            currentPeriod = 1; // Reset the period
-            suddenDeath = false; // Reset sudden-death mode
 
             // Render the background for the menu
             SDL_Rect menuBackgroundRect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
@@ -424,63 +609,27 @@ int main(int argc, char* argv[]) {
             continue; // Skip the rest of the game loop
         }
 
-        player1.move(SCREEN_WIDTH, SCREEN_HEIGHT, deltaTime);
-        player2.move(SCREEN_WIDTH, SCREEN_HEIGHT, deltaTime);
+        // Game rendering logic
+        SDL_SetRenderDrawColor(app.renderer, 0, 0, 0, 255); // Black background
+        SDL_RenderClear(app.renderer); // Clear the screen only when not paused
 
-        if (!inMenu) {
-            // Game rendering logic
-            SDL_SetRenderDrawColor(app.renderer, 0, 0, 0, 255); // Black background
-            SDL_RenderClear(app.renderer); // Clear the screen only when not paused
-    
-            // Render the game background
-            SDL_Rect destRect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
-            SDL_RenderCopy(app.renderer, backgroundTexture, nullptr, &destRect);
-    
-            // Process inputs
-            player1.processInputBuffer(player1Buffer);
-            player2.processInputBuffer(player2Buffer);
-
-            // player1.handleParry(player1Buffer);
-            // player1.renderCurrentAction(app.renderer); // Render Player 1's current action
-            // player2.handleParry(player2Buffer);
-            // player2.renderCurrentAction(app.renderer); // Render Player 2's current action
-            // Update game logic
-            player1.updatePosition(player2); // Prevent overlap
-            player2.updatePosition(player1); // Prevent overlap
-
-            // Ensure hurtboxes are updated after movement
-            player1.initializeHurtbox();
-            player2.initializeHurtbox();
-
-            // Play movement animations or render idle state
-            if (player1Buffer.right) {
-                player1.playMovementAnimation(app.renderer, false); // Player 1 moves forward (right)
-            } else if (player1Buffer.left) {
-                player1.playMovementAnimation(app.renderer, true); // Player 1 moves backward (left)
-            } else {
-                player1.render(app);
-            }
+        // Render the game background
+        SDL_Rect destRect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+        SDL_RenderCopy(app.renderer, backgroundTexture, nullptr, &destRect);
 
-            if (player2Buffer.left) {
-                player2.playMovementAnimation(app.renderer, false); // Player 2 moves forward (left)
-            } else if (player2Buffer.right) {
-                player2.playMovementAnimation(app.renderer, true); // Player 2 moves backward (right)
-            } else {
-                player2.render(app);
-            }
-    
-            // Render FPS counter
-            renderFPSCounter(app.font, app.renderer, fps);
-    
-            // Render scores, timer, and period
-            player1.manageGamePeriods(periodStartTime, currentPeriod, suddenDeath, running);
-            player1.renderGameInfo(app.renderer, app.font, currentPeriod, SDL_GetTicks() - periodStartTime);    
-            SDL_RenderPresent(app.renderer); // Present the game frame
-        }
+        // The fencers as they stand in the bout: the walk cycle while moving, the action's sprite otherwise
+        player1.renderState(app, match, 0);
+        player2.renderState(app, match, 1);
+
+        // Render FPS counter
+        renderFPSCounter(app.font, app.renderer, fps);
+
+        // Render scores, timer, and period
+        player1.renderGameInfo(app.renderer, app.font, match.period, match.periodTicks * 1000u / SIM_FPS);
+        SDL_RenderPresent(app.renderer); // Present the game frame
     
         // Frame rate control
         frameEnd = SDL_GetTicks(); // End of the frame
-        deltaTime = (frameEnd - frameStart) / 1000.0f; // Calculate deltaTime in seconds
 
         frameTime = frameEnd - frameStart;
         if (frameDelay > frameTime) {
@@ -498,6 +647,15 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (recording && !replay.close()) {
+        std::cerr << "Failed to save the replay " << replay.path << std::endl;
+    }
+    if (recording && cpuOpponent) saveHabits();
+    if (dataset.isOpen()) {
+        if (dataset.dropped > 0) std::cerr << dataset.dropped << " ticks were not captured: the disk fell behind" << std::endl;
+        if (!dataset.close()) std::cerr << "Failed to write " << dataset.path << std::endl;
+    }
+
     renderWinningScreen(app.renderer, app.font, winner);
 
     // Cleanup
@@ -0,0 +1,32 @@
+// A whole file mapped read-only into memory, for replays and lookup tables that are read in place
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+enum MapAccess {
+    MAP_ACCESS_SEQUENTIAL, // Read front to back once, e.g. replay verification
+    MAP_ACCESS_RANDOM      // Scattered lookups; the kernel should not read ahead
+};
+
+struct MappedFile {
+    const void* data = nullptr;
+    size_t size = 0;
+    std::string error;
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path, size_t minimumSize, MapAccess access); // Fails with error set if shorter than minimumSize
+    void close();
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+#endif // MAPPEDFILE_H
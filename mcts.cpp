@@ -0,0 +1,237 @@
+#include "mcts.h"
+#include <algorithm>
+#include <cmath>
+
+void MctsTree::reset() {
+    nodes.clear();
+    nodes.emplace_back(); // Root
+    iterations = 0;
+}
+
+MctsConfig mctsLevel(int level) {
+    static const int budgets[MCTS_LEVELS] = {500, 2000, 5000, MCTS_MAX_BUDGET_MICROS};
+    static const int threads[MCTS_LEVELS] = {1, 1, 2, 4};
+    level = std::clamp(level, 1, MCTS_LEVELS);
+
+    MctsConfig config;
+    config.budgetMicros = budgets[level - 1];
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    config.threads = std::max(1, std::min(threads[level - 1], cores > 1 ? cores - 1 : 1));
+    return config;
+}
+
+MctsBot::MctsBot(int player, const MctsConfig& config) : config(config), player(player) {
+    if (this->config.threads < 1) this->config.threads = 1;
+    this->config.budgetMicros = std::clamp(this->config.budgetMicros, 0, MCTS_MAX_BUDGET_MICROS);
+    if (this->config.maxNodes < 1) this->config.maxNodes = 1;
+
+    trees.resize(this->config.threads);
+    for (size_t i = 0; i < trees.size(); ++i) {
+        trees[i].nodes.reserve(this->config.maxNodes); // Never reallocates during a search
+        trees[i].rng = SimRandom(seedFor(static_cast<uint64_t>(player) + 1, i));
+    }
+    reset();
+
+    // The calling thread searches trees[0]; one worker per other tree
+    for (int i = 1; i < this->config.threads; ++i) {
+        workers.emplace_back(&MctsBot::workerLoop, this, i);
+    }
+}
+
+MctsBot::~MctsBot() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void MctsBot::reset() {
+    committedMove = MOVE_HOLD;
+    moveTick = config.stepTicks; // Decide on the next update
+    for (MctsTree& tree : trees) tree.reset();
+}
+
+void MctsBot::workerLoop(int index) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+        search(trees[index]);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0) finished.notify_one();
+        }
+    }
+}
+
+// Iterations are a few microseconds each, so checking the clock after every one stops the search
+// within one iteration of the deadline
+void MctsBot::search(MctsTree& tree) {
+    while (std::chrono::steady_clock::now() < deadline) {
+        iterate(tree);
+        tree.iterations++;
+    }
+}
+
+// Plays one macro move for both fencers; returns true with the result (player 1's view) on a touch
+static bool playMoves(MatchState& state, int player1Move, int player2Move, int firstTick, int ticks, float& result) {
+    for (int tick = firstTick; tick < firstTick + ticks; ++tick) {
+        uint8_t events = stepMatch(state, moveInput(player1Move, 0, tick), moveInput(player2Move, 1, tick));
+        if (events & (EVENT_TOUCH_P1 | EVENT_TOUCH_P2)) {
+            result = (events & EVENT_TOUCH_P1) ? 1.0f : -1.0f;
+            return true;
+        }
+    }
+    return false;
+}
+
+// UCB1 over one player's statistics; moves not tried yet come first, in random order
+static int selectMove(const MctsNode& node, int side, float exploration, SimRandom& rng) {
+    if (node.visits < MOVE_COUNT) {
+        int offset = rng.below(MOVE_COUNT);
+        for (int i = 0; i < MOVE_COUNT; ++i) {
+            int move = (offset + i) % MOVE_COUNT;
+            if (node.moveVisits[side][move] == 0) return move;
+        }
+    }
+
+    float logVisits = std::log(static_cast<float>(node.visits));
+    int best = 0;
+    float bestScore = -1e9f;
+    for (int move = 0; move < MOVE_COUNT; ++move) {
+        float visits = static_cast<float>(node.moveVisits[side][move]);
+        float score = node.moveValue[side][move] / visits + exploration * std::sqrt(logVisits / visits);
+        if (score > bestScore) {
+            bestScore = score;
+            best = move;
+        }
+    }
+    return best;
+}
+
+// One iteration: finish the committed move, descend the tree from the decision being searched,
+// add one node and finish the horizon with random moves. Returns the result for player 1.
+float MctsBot::iterate(MctsTree& tree) {
+    MatchState state = root;
+    SimRandom& rng = tree.rng;
+    int moves[2];
+    float result = 0.0f;
+
+    // The opponent's current move is unknown, so each iteration guesses one
+    moves[player] = committedMove;
+    moves[1 - player] = rng.below(MOVE_COUNT);
+    if (playMoves(state, moves[0], moves[1], config.stepTicks - rootRemaining, rootRemaining, result)) return result;
+
+    int path[64];
+    int pairs[64];
+    int length = 0;
+    int node = 0;
+    int step = 0;
+    bool decided = false;
+    int horizon = std::min(config.horizon, 64);
+
+    while (step < horizon && node >= 0) {
+        MctsNode& current = tree.nodes[node];
+        moves[0] = selectMove(current, 0, config.exploration, rng);
+        moves[1] = selectMove(current, 1, config.exploration, rng);
+        path[length] = node;
+        pairs[length] = moves[0] * MOVE_COUNT + moves[1];
+        length++;
+        step++;
+        if (playMoves(state, moves[0], moves[1], 0, config.stepTicks, result)) {
+            decided = true;
+            break;
+        }
+
+        int child = current.children[moves[0] * MOVE_COUNT + moves[1]];
+        if (child < 0) {
+            // Expand one node per iteration, then roll out
+            if (tree.nodes.size() < config.maxNodes) {
+                tree.nodes.emplace_back();
+                current.children[moves[0] * MOVE_COUNT + moves[1]] = static_cast<int32_t>(tree.nodes.size() - 1);
+            }
+            break;
+        }
+        node = child;
+    }
+
+    for (; !decided && step < horizon; ++step) {
+        decided = playMoves(state, rng.below(MOVE_COUNT), rng.below(MOVE_COUNT), 0, config.stepTicks, result);
+    }
+
+    for (int i = 0; i < length; ++i) {
+        MctsNode& current = tree.nodes[path[i]];
+        int player1Move = pairs[i] / MOVE_COUNT;
+        int player2Move = pairs[i] % MOVE_COUNT;
+        current.visits++;
+        current.moveVisits[0][player1Move]++;
+        current.moveValue[0][player1Move] += result;
+        current.moveVisits[1][player2Move]++;
+        current.moveValue[1][player2Move] -= result;
+    }
+    return result;
+}
+
+// Most visited move at the root over every thread's tree
+int MctsBot::bestMove() const {
+    int best = MOVE_HOLD;
+    uint64_t bestVisits = 0;
+    float bestValue = -2.0f;
+    for (int move = 0; move < MOVE_COUNT; ++move) {
+        uint64_t visits = 0;
+        float value = 0.0f;
+        for (const MctsTree& tree : trees) {
+            visits += tree.nodes[0].moveVisits[player][move];
+            value += tree.nodes[0].moveValue[player][move];
+        }
+        float mean = visits ? value / visits : -2.0f;
+        if (visits > bestVisits || (visits == bestVisits && mean > bestValue)) {
+            best = move;
+            bestVisits = visits;
+            bestValue = mean;
+        }
+    }
+    return best;
+}
+
+InputWord MctsBot::update(const MatchState& state) {
+    int remaining = config.stepTicks - moveTick; // 0 when the next move is due this tick
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        root = state;
+        rootRemaining = remaining;
+        deadline = start + std::chrono::microseconds(config.budgetMicros);
+        busy = static_cast<int>(workers.size());
+        generation++;
+    }
+    wake.notify_all();
+    search(trees[0]);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&]() { return busy == 0; });
+    }
+
+    int64_t overrun = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - deadline).count();
+    maxOverrunMicros = std::max(maxOverrunMicros, overrun);
+    frames++;
+    for (MctsTree& tree : trees) {
+        iterations += tree.iterations;
+        tree.iterations = 0;
+    }
+
+    // The statistics gathered while the previous move played out decide the next one
+    if (remaining <= 0) {
+        committedMove = bestMove();
+        moveTick = 0;
+        for (MctsTree& tree : trees) tree.reset();
+    }
+    return moveInput(committedMove, player, moveTick++);
+}
@@ -0,0 +1,91 @@
+// CPU opponent: Monte Carlo tree search over cloned match states, played with the solver's macro moves.
+// The search runs for a fixed time budget every frame, so the difficulty is set by the compute budget
+// (milliseconds and threads) rather than by hand-written rules.
+#ifndef MCTS_H
+#define MCTS_H
+
+#include "simulation.h"
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// Longest search the game loop allows: with rendering well under the rest of a 16.6 ms frame the
+// hardest setting still keeps 60 FPS
+#define MCTS_MAX_BUDGET_MICROS 10000
+#define MCTS_LEVELS 4
+
+struct MctsConfig {
+    int budgetMicros = 4000;    // Search time per frame; the caller blocks for exactly this long
+    int threads = 2;            // Search threads, including the calling thread
+    int stepTicks = 10;         // Ticks each macro move is held for, as in the solver
+    int horizon = 6;            // Macro moves looked ahead per iteration (tree plus random rollout)
+    float exploration = 1.4f;   // UCB1 exploration constant
+    size_t maxNodes = 1 << 14;  // Nodes per search thread; the tree stops growing when full
+};
+
+// Budget and threads for a difficulty level from 1 (easiest) to MCTS_LEVELS; threads are capped by
+// the cores available, leaving one for the renderer
+MctsConfig mctsLevel(int level);
+
+// Decoupled UCT node: both fencers choose a move independently, each from its own statistics,
+// and the pair of moves selects the child
+struct MctsNode {
+    uint32_t visits = 0;
+    uint32_t moveVisits[2][MOVE_COUNT] = {};
+    float moveValue[2][MOVE_COUNT] = {}; // Sum of results from that player's point of view
+    int32_t children[MOVE_COUNT * MOVE_COUNT];
+
+    MctsNode() { std::fill(children, children + MOVE_COUNT * MOVE_COUNT, -1); }
+};
+
+// One search thread's tree. Threads never share a tree: their root statistics are summed at
+// decision time (root parallelisation), so the search itself takes no locks.
+struct MctsTree {
+    std::vector<MctsNode> nodes;
+    SimRandom rng{1};
+    uint64_t iterations = 0;
+
+    void reset();
+};
+
+struct MctsBot {
+    MctsConfig config;
+    int player;                 // 0 or 1
+    std::vector<MctsTree> trees;
+
+    int committedMove = MOVE_HOLD;
+    int moveTick = 0;           // Ticks of committedMove already played
+    uint64_t iterations = 0;    // Over the whole bout, for the statistics
+    uint64_t frames = 0;
+    int64_t maxOverrunMicros = 0;
+
+    MctsBot(int player, const MctsConfig& config);
+    ~MctsBot();
+    MctsBot(const MctsBot&) = delete;
+    MctsBot& operator=(const MctsBot&) = delete;
+
+    InputWord update(const MatchState& state); // Call once per tick: searches, then returns this tick's keys
+    void reset();                              // Forget the current move, e.g. for a new bout
+
+    // Shared with the worker threads
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    MatchState root;
+    int rootRemaining = 0;      // Ticks of committedMove still to play before the searched decision
+    std::chrono::steady_clock::time_point deadline;
+    uint64_t generation = 0;
+    int busy = 0;
+    bool quit = false;
+
+    void workerLoop(int index);
+    void search(MctsTree& tree);
+    float iterate(MctsTree& tree);
+    int bestMove() const;
+};
+
+#endif // MCTS_H
@@ -32,6 +32,8 @@ struct MENU {
     void checkButtonClick(int mouseX, int mouseY) const; // Check for mouse clicks on buttons
 };
 
+#define MENU_MAX_PLUGINS 3 // Plugin options that fit on screen under the standard ones
+
 struct PAUSEMENU {
     std::vector<std::string> options = {"Resume", "Return to main menu", "Quit"};
     std::unordered_map<int, std::function<void()>> actions;
@@ -0,0 +1,135 @@
+#include "opponentmodel.h"
+#include "replay.h"
+#include "lab.h"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+
+// Prediction scores for one run: the model's most likely next action, checked on every action start,
+// against guessing from action frequencies alone
+struct ModelScore {
+    uint64_t actions = 0;
+    uint64_t hits = 0;
+    uint64_t frequencyHits = 0;
+    std::chrono::duration<double, std::nano> watchTime{0};
+    uint64_t ticks = 0;
+};
+
+// Call after stepMatch, before the model has seen the tick
+static void scoreTick(OpponentModel& model, const MatchState& state, ModelScore& score) {
+    uint8_t action = state.fencers[model.player].action;
+    if (action != model.lastAction && action != ACTION_IDLE) {
+        float probability;
+        score.actions++;
+        score.hits += model.likelyAction(probability) == action;
+        score.frequencyHits += model.likelyAction(probability, 0) == action;
+    }
+    auto start = std::chrono::steady_clock::now();
+    model.watch(state);
+    score.watchTime += std::chrono::steady_clock::now() - start;
+    score.ticks++;
+}
+
+// A stand-in human with habits: a loop of combos (a step or two, then a command, then waiting the action
+// out), with a random move instead of the habitual one now and then
+static void playHabits(OpponentModel& model, int bouts, int maxTicks, uint64_t seed, ModelScore& score) {
+    static const int habit[] = {
+        MOVE_ADVANCE, MOVE_ATTACK, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD,
+        MOVE_RETREAT, MOVE_STRIKE_HIGHLOW, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD,
+        MOVE_ADVANCE, MOVE_ADVANCE, MOVE_PARRY_LOW, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD, MOVE_HOLD};
+    const int habitLength = static_cast<int>(sizeof(habit) / sizeof(habit[0]));
+    const int stepTicks = 10;
+    SimRandom rng(seed);
+    for (int bout = 0; bout < bouts; ++bout) {
+        MatchState state;
+        initMatch(state, static_cast<uint8_t>(bout % WEAPON_COUNT));
+        model.startBout();
+        int moves[2] = {MOVE_HOLD, MOVE_HOLD};
+        for (int t = 0, step = 0; t < maxTicks && !state.over; ++t) {
+            if (t % stepTicks == 0) {
+                moves[0] = rng.below(8) == 0 ? rng.below(MOVE_COUNT) : habit[step++ % habitLength];
+                moves[1] = rng.below(MOVE_COUNT);
+            }
+            stepMatch(state, moveInput(moves[0], 0, t % stepTicks), moveInput(moves[1], 1, t % stepTicks));
+            scoreTick(model, state, score);
+        }
+    }
+}
+
+static void printScore(const char* label, const ModelScore& score) {
+    std::cout << label << ": " << score.actions << " action starts, next action predicted "
+              << (score.actions ? 100.0 * score.hits / score.actions : 0.0) << "% (frequencies alone "
+              << (score.actions ? 100.0 * score.frequencyHits / score.actions : 0.0) << "%), "
+              << (score.ticks ? score.watchTime.count() / score.ticks : 0.0) << " ns per watched tick" << std::endl;
+}
+
+// Trains the model on player 1 of the given replays (or on a habitual stand-in player) and reports how
+// well it anticipates actions; --profile saves it and checks the file reloads to the same predictions
+int runModel(int argc, char* argv[]) {
+    std::vector<std::string> paths = collectReplays(argc, argv, {"--profile", "--bouts", "--max-ticks", "--seed"});
+    std::string profilePath = stringOption(argc, argv, "--profile", "");
+    int bouts = intOption(argc, argv, "--bouts", 20);
+    int maxTicks = intOption(argc, argv, "--max-ticks", SIM_PERIOD_TICKS / 3);
+    int seed = intOption(argc, argv, "--seed", 1);
+
+    OpponentModel model(0);
+    std::string error;
+    if (!profilePath.empty() && model.load(profilePath, error)) {
+        std::cout << "Warm start from " << profilePath << " (" << model.observed << " symbols)" << std::endl;
+    }
+
+    ModelScore score;
+    if (paths.empty()) {
+        playHabits(model, bouts, maxTicks, static_cast<uint64_t>(seed), score);
+        printScore("Habitual player", score);
+    } else {
+        MappedReplay replay;
+        for (const std::string& path : paths) {
+            if (!replay.open(path)) {
+                std::cerr << path << ": " << replay.error << std::endl;
+                continue;
+            }
+            MatchState state;
+            replay.startState(state);
+            model.startBout();
+            ReplayReader reader(replay);
+            InputWord player1Input, player2Input;
+            while (reader.next(player1Input, player2Input)) {
+                stepMatch(state, player1Input, player2Input);
+                scoreTick(model, state, score);
+            }
+            replay.close();
+        }
+        printScore("Replays, player 1", score);
+    }
+
+    float probabilities[NGRAM_SYMBOLS];
+    model.predict(probabilities);
+    std::cout << "Next symbol now:";
+    for (int symbol = 0; symbol < NGRAM_SYMBOLS; ++symbol) {
+        if (probabilities[symbol] >= 0.05f) std::cout << " " << NGRAM_SYMBOL_NAMES[symbol] << " " << probabilities[symbol];
+    }
+    std::cout << std::endl;
+
+    if (profilePath.empty()) return 0;
+    if (!model.save(profilePath)) {
+        std::cerr << "model: cannot write " << profilePath << std::endl;
+        return 1;
+    }
+    OpponentModel reloaded(0);
+    if (!reloaded.load(profilePath, error)) {
+        std::cerr << "model: " << profilePath << ": " << error << std::endl;
+        return 1;
+    }
+    float reloadedProbabilities[NGRAM_SYMBOLS];
+    reloaded.predict(reloadedProbabilities, 0); // The context is not saved; compare what the counts say
+    model.predict(probabilities, 0);
+    for (int symbol = 0; symbol < NGRAM_SYMBOLS; ++symbol) {
+        if (std::fabs(probabilities[symbol] - reloadedProbabilities[symbol]) > 1e-6f) {
+            std::cerr << "model: " << profilePath << " reloads to different predictions" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Wrote " << profilePath << " (" << model.observed << " symbols)" << std::endl;
+    return 0;
+}
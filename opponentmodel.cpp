@@ -0,0 +1,183 @@
+#include "opponentmodel.h"
+#include <algorithm>
+#include <fstream>
+
+const char* const NGRAM_SYMBOL_NAMES[NGRAM_SYMBOLS] = {
+    "up", "down", "forward", "back", "attack key",
+    "attack", "parry_low", "parry_high", "parry_mid", "strike_lowhigh", "strike_highlow"
+};
+
+void OpponentModel::clear() {
+    std::fill(table.begin(), table.end(), NgramEntry());
+    observed = 0;
+    startBout();
+}
+
+void OpponentModel::startBout() {
+    historyLength = 0;
+    pendingCount = 0;
+    lastHeld = 0;
+    lastAction = ACTION_IDLE;
+}
+
+// Presses in InputBit order with left/right turned into forward/back, then the action they started
+void OpponentModel::watch(const MatchState& state) {
+    const FencerState& fencer = state.fencers[player];
+    InputWord pressed = fencer.held & ~lastHeld;
+    lastHeld = fencer.held;
+    InputWord forward = forwardInput(player);
+    for (int i = 0; i < INPUT_SYMBOLS; ++i) {
+        InputWord key = static_cast<InputWord>(1 << i);
+        if (!(pressed & key)) continue;
+        if (key == INPUT_LEFT || key == INPUT_RIGHT) {
+            add(key == forward ? 2 : 3);
+        } else {
+            add(key == INPUT_UP ? 0 : key == INPUT_DOWN ? 1 : 4);
+        }
+    }
+    if (fencer.action != lastAction && fencer.action != ACTION_IDLE) add(NGRAM_ACTION_SYMBOL(fencer.action));
+    lastAction = fencer.action;
+}
+
+uint64_t OpponentModel::contextHash(int order) const {
+    uint64_t hash = static_cast<uint64_t>(order) + 1;
+    for (int i = 0; i < order; ++i) hash = hash * 31 + history[i] + 1;
+    // splitmix64 finaliser, as in hashMatchState
+    hash += 0x9e3779b97f4a7c15ULL;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    return hash ^ (hash >> 31);
+}
+
+static uint32_t entryTag(uint64_t hash) {
+    return static_cast<uint32_t>(hash >> 32) | 1;
+}
+
+const NgramEntry* OpponentModel::find(int order) const {
+    uint64_t hash = contextHash(order);
+    const NgramEntry& entry = table[hash & (table.size() - 1)];
+    return entry.tag == entryTag(hash) ? &entry : nullptr;
+}
+
+// Halves every count once the total passes NGRAM_MAX_TOTAL
+template <size_t N>
+static void countSymbol(uint16_t& total, uint16_t (&counts)[N], int symbol) {
+    counts[symbol]++;
+    if (++total > NGRAM_MAX_TOTAL) {
+        total = 0;
+        for (uint16_t& count : counts) {
+            count /= 2;
+            total += count;
+        }
+    }
+}
+
+// A colliding context takes the slot over; the table is a cache of recent habits, not a full record
+void OpponentModel::add(int symbol) {
+    int orders = std::min(historyLength, NGRAM_ORDER);
+    uint32_t* slots = pending[std::min(pendingCount, NGRAM_PENDING - 1)];
+    if (pendingCount == NGRAM_PENDING) {
+        std::copy(pending[1], pending[1] + (NGRAM_PENDING - 1) * (NGRAM_ORDER + 1), pending[0]); // Drop the oldest context
+    } else {
+        pendingCount++;
+    }
+    for (int order = 0; order <= NGRAM_ORDER; ++order) {
+        if (order > orders) {
+            slots[order] = UINT32_MAX;
+            continue;
+        }
+        uint64_t hash = contextHash(order);
+        slots[order] = static_cast<uint32_t>(hash & (table.size() - 1));
+        NgramEntry& entry = table[slots[order]];
+        if (entry.tag != entryTag(hash)) {
+            entry = NgramEntry();
+            entry.tag = entryTag(hash);
+        }
+        countSymbol(entry.total, entry.counts, symbol);
+    }
+
+    // An action is the next action for every context since the previous one; slots that were
+    // taken over since then may be credited wrongly, which the counts' decay absorbs
+    if (symbol >= INPUT_SYMBOLS) {
+        for (int i = 0; i < pendingCount; ++i) {
+            for (uint32_t slot : pending[i]) {
+                if (slot != UINT32_MAX) countSymbol(table[slot].actionTotal, table[slot].actions, symbol - INPUT_SYMBOLS);
+            }
+        }
+        pendingCount = 0;
+    }
+
+    std::copy_backward(history, history + NGRAM_ORDER - 1, history + NGRAM_ORDER);
+    history[0] = static_cast<uint8_t>(symbol);
+    historyLength = std::min(historyLength + 1, NGRAM_ORDER);
+    if (observed != UINT32_MAX) observed++;
+}
+
+void OpponentModel::predict(float probabilities[NGRAM_SYMBOLS], int maxOrder) const {
+    std::fill(probabilities, probabilities + NGRAM_SYMBOLS, 1.0f / NGRAM_SYMBOLS);
+    for (int order = 0; order <= std::min({maxOrder, historyLength, NGRAM_ORDER}); ++order) {
+        const NgramEntry* entry = find(order);
+        if (!entry || entry->total == 0) continue;
+        float weight = static_cast<float>(entry->total) / (entry->total + NGRAM_CONFIDENCE);
+        for (int symbol = 0; symbol < NGRAM_SYMBOLS; ++symbol) {
+            probabilities[symbol] = (1 - weight) * probabilities[symbol] + weight * entry->counts[symbol] / entry->total;
+        }
+    }
+}
+
+// Blended like predict, over each context's next-action counts
+int OpponentModel::likelyAction(float& probability, int maxOrder) const {
+    float probabilities[ACTION_COUNT - 1];
+    std::fill(probabilities, probabilities + ACTION_COUNT - 1, 1.0f / (ACTION_COUNT - 1));
+    bool seen = false;
+    for (int order = 0; order <= std::min({maxOrder, historyLength, NGRAM_ORDER}); ++order) {
+        const NgramEntry* entry = find(order);
+        if (!entry || entry->actionTotal == 0) continue;
+        seen = true;
+        float weight = static_cast<float>(entry->actionTotal) / (entry->actionTotal + NGRAM_CONFIDENCE);
+        for (int i = 0; i < ACTION_COUNT - 1; ++i) {
+            probabilities[i] = (1 - weight) * probabilities[i] + weight * entry->actions[i] / entry->actionTotal;
+        }
+    }
+
+    int best = 0;
+    for (int i = 1; i < ACTION_COUNT - 1; ++i) {
+        if (probabilities[i] > probabilities[best]) best = i;
+    }
+    probability = seen ? probabilities[best] : 0;
+    return seen ? ACTION_ATTACK + best : ACTION_IDLE;
+}
+
+bool OpponentModel::load(const std::string& path, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    NgramHeader header;
+    if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        error = "cannot read";
+        return false;
+    }
+    if (header.magic != NGRAM_MAGIC || header.version != NGRAM_VERSION || header.order != NGRAM_ORDER ||
+        header.tableBits != NGRAM_TABLE_BITS || header.symbolCount != NGRAM_SYMBOLS) {
+        error = "not a version " + std::to_string(NGRAM_VERSION) + " profile for this build";
+        return false;
+    }
+    std::vector<NgramEntry> loaded(table.size());
+    if (!in.read(reinterpret_cast<char*>(loaded.data()), static_cast<std::streamsize>(loaded.size() * sizeof(NgramEntry)))) {
+        error = "truncated";
+        return false;
+    }
+
+    table.swap(loaded);
+    observed = header.observed;
+    startBout();
+    error.clear();
+    return true;
+}
+
+bool OpponentModel::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    NgramHeader header;
+    header.observed = observed;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(NgramEntry)));
+    return static_cast<bool>(out);
+}
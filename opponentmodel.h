@@ -0,0 +1,82 @@
+// Opponent model: n-gram counts over one player's command symbols (key presses, turned to
+// forward/back for their side, and the actions those presses started), kept in a fixed-size hashed
+// table. Each context counts both the symbol that followed it and the next action started after it,
+// however many presses came in between, so a bot can ask what the opponent is about to do before
+// the command is complete. Each symbol touches a bounded number of entries, so watching a tick is
+// O(1). The table is saved per player profile so it keeps what it learned across sessions.
+#ifndef OPPONENTMODEL_H
+#define OPPONENTMODEL_H
+
+#include "simulation.h"
+#include <string>
+#include <vector>
+
+#define NGRAM_MAGIC 0x4d474e46u // "FNGM"
+#define NGRAM_VERSION 1
+#define NGRAM_ORDER 3                // Longest context, in symbols
+#define NGRAM_TABLE_BITS 12          // 4096 entries shared by every context length
+#define NGRAM_MAX_TOTAL 1024         // Counts are halved past this, so old habits fade
+#define NGRAM_CONFIDENCE 4           // Observations before a context outweighs the shorter ones
+#define NGRAM_PENDING 4              // Contexts credited with the next action: a command is at most three presses
+#define NGRAM_SYMBOLS (INPUT_SYMBOLS + ACTION_COUNT - 1)
+
+// Symbols 0-4 are presses of up, down, forward, back and attack; the rest are action starts, in
+// ActionId order from ACTION_ATTACK
+#define NGRAM_ACTION_SYMBOL(action) (INPUT_SYMBOLS + (action) - ACTION_ATTACK)
+extern const char* const NGRAM_SYMBOL_NAMES[NGRAM_SYMBOLS];
+
+struct NgramEntry {
+    uint32_t tag = 0;                  // Context hash, 0 for an empty slot
+    uint16_t total = 0;
+    uint16_t counts[NGRAM_SYMBOLS] = {};        // Next symbol
+    uint16_t actionTotal = 0;
+    uint16_t actions[ACTION_COUNT - 1] = {};    // Next action started, from ACTION_ATTACK
+    uint16_t reserved = 0;
+};
+static_assert(sizeof(NgramEntry) == 44, "NgramEntry is written as is");
+
+// File layout: NgramHeader, then the 1 << tableBits entries
+struct NgramHeader {
+    uint32_t magic = NGRAM_MAGIC;
+    uint16_t version = NGRAM_VERSION;
+    uint8_t order = NGRAM_ORDER;
+    uint8_t tableBits = NGRAM_TABLE_BITS;
+    uint8_t symbolCount = NGRAM_SYMBOLS;
+    uint8_t reserved[3] = {};
+    uint32_t observed = 0;             // Symbols learned from, saturating
+};
+static_assert(sizeof(NgramHeader) == 16, "NgramHeader is written as is");
+
+struct OpponentModel {
+    int player;                        // The player being watched
+    std::vector<NgramEntry> table;
+    uint8_t history[NGRAM_ORDER] = {}; // Most recent symbol first
+    int historyLength = 0;
+    InputWord lastHeld = 0;
+    uint8_t lastAction = ACTION_IDLE;
+    uint32_t observed = 0;
+    uint32_t pending[NGRAM_PENDING][NGRAM_ORDER + 1] = {}; // Recent contexts (slot per order) awaiting the next action
+    int pendingCount = 0;
+
+    explicit OpponentModel(int player) : player(player), table(1u << NGRAM_TABLE_BITS) {}
+
+    void clear();                       // Forget everything
+    void startBout();                   // Forget the context but keep the counts
+    void watch(const MatchState& state); // Call after every stepMatch
+    void add(int symbol);
+
+    // Blend of every context length up to maxOrder, longer contexts weighted by how often they were seen
+    void predict(float probabilities[NGRAM_SYMBOLS], int maxOrder = NGRAM_ORDER) const;
+    // Most likely next action to start, from the next-action counts, and its probability among the
+    // actions; ACTION_IDLE before any action was seen
+    int likelyAction(float& probability, int maxOrder = NGRAM_ORDER) const;
+
+    bool load(const std::string& path, std::string& error);
+    bool save(const std::string& path) const;
+
+private:
+    uint64_t contextHash(int order) const;
+    const NgramEntry* find(int order) const;
+};
+
+#endif // OPPONENTMODEL_H
@@ -0,0 +1,56 @@
+// Example bot plugin. Every tick it plays each macro move a second ahead against the opponent holding
+// its current keys, and picks the first move that touches without being touched, else a parry that
+// stops a touch, else an advance. Built with its own copy of the simulation (see CMakeLists.txt).
+#include "../botplugin.h"
+#include <new>
+
+#define LUNGE_LOOKAHEAD_TICKS SIM_FPS
+
+struct LungeBot {
+    int player;
+    MoveRunner runner;
+};
+
+// Touch events for the bot and its opponent when it plays move from state
+static void tryMove(const MatchState& state, int player, int move, bool& scores, bool& conceded) {
+    MatchState next = state;
+    InputWord held = state.fencers[1 - player].held;
+    scores = conceded = false;
+    for (int tick = 0; tick < LUNGE_LOOKAHEAD_TICKS && !scores && !conceded && !next.over; ++tick) {
+        InputWord own = moveInput(move, player, tick);
+        uint8_t events = stepMatch(next, player == 0 ? own : held, player == 0 ? held : own);
+        scores = events & (player == 0 ? EVENT_TOUCH_P1 : EVENT_TOUCH_P2);
+        conceded = events & (player == 0 ? EVENT_TOUCH_P2 : EVENT_TOUCH_P1);
+    }
+}
+
+FENCING_PLUGIN_EXPORT void* fencing_bot_init(uint32_t abi, int player) {
+    if (abi != FENCING_PLUGIN_ABI) return nullptr;
+    return new (std::nothrow) LungeBot{player, MoveRunner()};
+}
+
+FENCING_PLUGIN_EXPORT void fencing_bot_decide(void* context, const MatchState* state, InputWord* input) {
+    LungeBot& bot = *static_cast<LungeBot*>(context);
+    bool scores, conceded;
+    tryMove(*state, bot.player, MOVE_HOLD, scores, conceded);
+    bool threatened = conceded;
+
+    int wanted = MOVE_ADVANCE;
+    int parry = -1;
+    for (int move = MOVE_ATTACK; move < MOVE_COUNT; ++move) {
+        tryMove(*state, bot.player, move, scores, conceded);
+        if (scores && !conceded) {
+            wanted = move;
+            parry = -1;
+            break;
+        }
+        bool isParry = move >= MOVE_PARRY_LOW && move <= MOVE_PARRY_MID;
+        if (threatened && isParry && !conceded && parry < 0) parry = move;
+    }
+    if (parry >= 0) wanted = parry;
+    *input = bot.runner.next(wanted, *state, bot.player);
+}
+
+FENCING_PLUGIN_EXPORT void fencing_bot_shutdown(void* context) {
+    delete static_cast<LungeBot*>(context);
+}
@@ -0,0 +1,284 @@
+#include "policy.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+// x86 builds with GCC or Clang carry every path and pick one for the CPU they run on, so a build for
+// the baseline instruction set still gets AVX2. Other builds use what the compiler was allowed.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define POLICY_DISPATCH 1
+#define POLICY_AVX2 __attribute__((target("avx2")))
+#define POLICY_SSSE3 __attribute__((target("ssse3")))
+#elif defined(__AVX2__) || defined(__SSSE3__)
+#define POLICY_AVX2
+#define POLICY_SSSE3
+#endif
+#if defined(POLICY_DISPATCH) || defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+// Activations are 0-127 and weights -128-127, so the pairwise 16-bit sums of maddubs cannot saturate
+#if defined(POLICY_DISPATCH) || defined(__AVX2__)
+POLICY_AVX2 static int32_t dotAvx2(const uint8_t* activations, const int8_t* weights, int count) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < count; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(activations + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(a, w), ones));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(half);
+}
+#endif
+
+#if defined(POLICY_DISPATCH) || (defined(__SSSE3__) && !defined(__AVX2__))
+POLICY_SSSE3 static int32_t dotSsse3(const uint8_t* activations, const int8_t* weights, int count) {
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < count; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(activations + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(a, w), ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+#if defined(POLICY_DISPATCH) || !(defined(__AVX2__) || defined(__SSSE3__))
+static int32_t dotScalar(const uint8_t* activations, const int8_t* weights, int count) {
+    int32_t sum = 0;
+    for (int i = 0; i < count; ++i) sum += activations[i] * weights[i];
+    return sum;
+}
+#endif
+
+typedef int32_t (*DotFunction)(const uint8_t* activations, const int8_t* weights, int count);
+
+struct DotPath {
+    DotFunction function;
+    const char* name;
+};
+
+static DotPath pickDot() {
+#if defined(POLICY_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {dotAvx2, "AVX2"};
+    if (__builtin_cpu_supports("ssse3")) return {dotSsse3, "SSSE3"};
+    return {dotScalar, "scalar"};
+#elif defined(__AVX2__)
+    return {dotAvx2, "AVX2"};
+#elif defined(__SSSE3__)
+    return {dotSsse3, "SSSE3"};
+#else
+    return {dotScalar, "scalar"};
+#endif
+}
+
+static const DotPath dotPath = pickDot();
+
+static int32_t dot(const uint8_t* activations, const int8_t* weights, int count) {
+    return dotPath.function(activations, weights, count);
+}
+
+const char* policySimdName() {
+    return dotPath.name;
+}
+
+static int paddedWidth(int width) {
+    return (width + POLICY_ALIGN - 1) / POLICY_ALIGN * POLICY_ALIGN;
+}
+
+bool PolicyNetwork::load(const std::string& path, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    PolicyHeader header;
+    if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        error = "cannot read";
+        return false;
+    }
+    if (header.magic != POLICY_MAGIC || header.version != POLICY_VERSION || header.layerCount == 0) {
+        error = "not a version " + std::to_string(POLICY_VERSION) + " policy";
+        return false;
+    }
+
+    std::vector<PolicyLayer> loaded(header.layerCount);
+    int width = POLICY_INPUTS;
+    for (PolicyLayer& layer : loaded) {
+        PolicyLayerHeader layerHeader;
+        if (!in.read(reinterpret_cast<char*>(&layerHeader), sizeof(layerHeader))) {
+            error = "truncated";
+            return false;
+        }
+        if (layerHeader.inputs != width || layerHeader.outputs == 0 || layerHeader.outputs > POLICY_MAX_WIDTH) {
+            error = "layer sizes do not chain from " + std::to_string(POLICY_INPUTS) + " inputs";
+            return false;
+        }
+        layer.inputs = layerHeader.inputs;
+        layer.paddedInputs = paddedWidth(layer.inputs);
+        layer.outputs = layerHeader.outputs;
+        layer.scale = layerHeader.scale;
+        layer.biases.resize(layer.outputs);
+        layer.weights.resize(static_cast<size_t>(layer.outputs) * layer.paddedInputs);
+        in.read(reinterpret_cast<char*>(layer.biases.data()), static_cast<std::streamsize>(layer.biases.size() * sizeof(int32_t)));
+        in.read(reinterpret_cast<char*>(layer.weights.data()), static_cast<std::streamsize>(layer.weights.size()));
+        if (!in) {
+            error = "truncated";
+            return false;
+        }
+        width = layer.outputs;
+    }
+    if (width != MOVE_COUNT) {
+        error = "last layer must have " + std::to_string(MOVE_COUNT) + " outputs";
+        return false;
+    }
+
+    layers.swap(loaded);
+    error.clear();
+    return true;
+}
+
+bool PolicyNetwork::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    PolicyHeader header;
+    header.layerCount = static_cast<uint16_t>(layers.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const PolicyLayer& layer : layers) {
+        PolicyLayerHeader layerHeader;
+        layerHeader.inputs = static_cast<uint16_t>(layer.inputs);
+        layerHeader.outputs = static_cast<uint16_t>(layer.outputs);
+        layerHeader.scale = layer.scale;
+        out.write(reinterpret_cast<const char*>(&layerHeader), sizeof(layerHeader));
+        out.write(reinterpret_cast<const char*>(layer.biases.data()), static_cast<std::streamsize>(layer.biases.size() * sizeof(int32_t)));
+        out.write(reinterpret_cast<const char*>(layer.weights.data()), static_cast<std::streamsize>(layer.weights.size()));
+    }
+    return static_cast<bool>(out);
+}
+
+// Weights uniform in [-64, 64]; the scale keeps a typical activation near the middle of 0-127
+void PolicyNetwork::randomise(const std::vector<int>& hidden, SimRandom& rng) {
+    std::vector<int> widths = {POLICY_INPUTS};
+    for (int width : hidden) widths.push_back(std::clamp(width, 1, POLICY_MAX_WIDTH));
+    widths.push_back(MOVE_COUNT);
+
+    layers.assign(widths.size() - 1, PolicyLayer());
+    for (size_t i = 0; i < layers.size(); ++i) {
+        PolicyLayer& layer = layers[i];
+        layer.inputs = widths[i];
+        layer.paddedInputs = paddedWidth(layer.inputs);
+        layer.outputs = widths[i + 1];
+        layer.scale = 1.0f / (32.0f * std::sqrt(static_cast<float>(layer.inputs)));
+        layer.biases.assign(layer.outputs, 0);
+        layer.weights.assign(static_cast<size_t>(layer.outputs) * layer.paddedInputs, 0);
+        for (int output = 0; output < layer.outputs; ++output) {
+            for (int input = 0; input < layer.inputs; ++input) {
+                layer.weights[static_cast<size_t>(output) * layer.paddedInputs + input] = static_cast<int8_t>(rng.below(129) - 64);
+            }
+        }
+    }
+}
+
+// Layer by layer over the whole batch, so each weight row is reused while it is in cache
+void PolicyNetwork::evaluate(const uint8_t* observations, int batch, int* moves) const {
+    thread_local std::vector<uint8_t> buffers[2];
+    const int stride = paddedWidth(POLICY_MAX_WIDTH);
+    for (std::vector<uint8_t>& buffer : buffers) {
+        if (buffer.size() < static_cast<size_t>(batch) * stride) buffer.resize(static_cast<size_t>(batch) * stride);
+    }
+
+    uint8_t* current = buffers[0].data();
+    uint8_t* next = buffers[1].data();
+    for (int b = 0; b < batch; ++b) {
+        uint8_t* row = current + static_cast<size_t>(b) * stride;
+        std::copy(observations + b * POLICY_INPUTS, observations + (b + 1) * POLICY_INPUTS, row);
+        std::fill(row + POLICY_INPUTS, row + paddedWidth(POLICY_INPUTS), 0);
+    }
+
+    for (size_t l = 0; l + 1 < layers.size(); ++l) {
+        const PolicyLayer& layer = layers[l];
+        int padded = paddedWidth(layer.outputs);
+        for (int b = 0; b < batch; ++b) {
+            std::fill(next + static_cast<size_t>(b) * stride + layer.outputs, next + static_cast<size_t>(b) * stride + padded, 0);
+        }
+        for (int output = 0; output < layer.outputs; ++output) {
+            const int8_t* row = layer.weights.data() + static_cast<size_t>(output) * layer.paddedInputs;
+            for (int b = 0; b < batch; ++b) {
+                int32_t sum = dot(current + static_cast<size_t>(b) * stride, row, layer.paddedInputs) + layer.biases[output];
+                float activation = static_cast<float>(sum) * layer.scale;
+                next[static_cast<size_t>(b) * stride + output] = static_cast<uint8_t>(std::clamp(activation, 0.0f, 127.0f));
+            }
+        }
+        std::swap(current, next);
+    }
+
+    // Output layer: the raw scores only need comparing
+    const PolicyLayer& last = layers.back();
+    for (int b = 0; b < batch; ++b) {
+        const uint8_t* input = current + static_cast<size_t>(b) * stride;
+        int best = 0;
+        int32_t bestScore = INT32_MIN;
+        for (int output = 0; output < last.outputs; ++output) {
+            int32_t score = dot(input, last.weights.data() + static_cast<size_t>(output) * last.paddedInputs, last.paddedInputs) +
+                            last.biases[output];
+            if (score > bestScore) {
+                bestScore = score;
+                best = output;
+            }
+        }
+        moves[b] = best;
+    }
+}
+
+static uint8_t feature(int value, int range) {
+    return static_cast<uint8_t>(std::clamp(value * 127 / range, 0, 127));
+}
+
+void observe(const MatchState& state, int side, uint8_t* observation) {
+    std::fill(observation, observation + POLICY_INPUTS, 0);
+    const FencerState& own = state.fencers[side];
+    const FencerState& opponent = state.fencers[1 - side];
+    int forward = side == 0 ? 1 : -1;
+
+    // Positions measured from the fencer's own end of the piste
+    observation[0] = feature(side == 0 ? own.x : SIM_MAX_X - own.x, SIM_MAX_X);
+    observation[1] = feature(side == 0 ? opponent.x : SIM_MAX_X - opponent.x, SIM_MAX_X);
+    observation[2] = feature(std::abs(opponent.x - own.x), SIM_MAX_X);
+    observation[3 + own.action] = 127;
+    observation[10 + opponent.action] = 127;
+    observation[17] = feature(own.actionTicks, SIM_ACTION_TICKS);
+    observation[18] = feature(opponent.actionTicks, SIM_ACTION_TICKS);
+    observation[19] = own.velocityX * forward > 0 ? 127 : 0;
+    observation[20] = own.velocityX * forward < 0 ? 127 : 0;
+    observation[21] = opponent.velocityX * forward < 0 ? 127 : 0; // Towards the observer
+    observation[22] = opponent.velocityX * forward > 0 ? 127 : 0;
+
+    // Own input history, with left/right turned into forward/back: it decides which command a press starts
+    InputWord forwardKey = forwardInput(side);
+    for (int i = 0; i < INPUT_SYMBOLS; ++i) {
+        if (own.pressAge[i] == SIM_NO_PRESS || own.pressAge[i] > SIM_COMMAND_WINDOW_TICKS) continue;
+        InputWord key = static_cast<InputWord>(1 << i);
+        int slot = key == INPUT_UP ? 0 : key == INPUT_DOWN ? 1 : key == INPUT_ATTACK ? 4 : key == forwardKey ? 2 : 3;
+        observation[23 + slot] = 127;
+    }
+    observation[28] = state.weapon == WEAPON_SABRE ? 127 : 0;
+    observation[29] = feature(state.points[side] - state.points[1 - side] + SIM_START_POINTS, 2 * SIM_START_POINTS);
+    observation[30] = feature(state.periodTicks, SIM_PERIOD_TICKS);
+    observation[31] = 127; // Constant input, a second bias
+}
+
+void PolicyBot::reset() {
+    committedMove = MOVE_HOLD;
+    moveTick = stepTicks;
+}
+
+InputWord PolicyBot::update(const MatchState& state) {
+    if (moveTick >= stepTicks) {
+        uint8_t observation[POLICY_INPUTS];
+        observe(state, player, observation);
+        network.evaluate(observation, 1, &committedMove);
+        moveTick = 0;
+    }
+    return moveInput(committedMove, player, moveTick++);
+}
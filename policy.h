@@ -0,0 +1,71 @@
+// Learned CPU opponent: a small int8-quantised MLP from the match observation to a macro move.
+// The forward pass uses AVX2 or SSSE3 integer dot products when the compiler targets them and plain
+// loops otherwise, and takes a batch of observations so the live bot and the trainer share it.
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "simulation.h"
+#include <string>
+#include <vector>
+
+#define POLICY_MAGIC 0x4c4f5046u // "FPOL"
+#define POLICY_VERSION 1
+#define POLICY_INPUTS 32         // Observation features, each 0-127
+#define POLICY_ALIGN 32          // Layer inputs are padded to this many bytes for the SIMD loads
+#define POLICY_MAX_WIDTH 256     // Widest layer
+
+// File layout: PolicyHeader, then per layer PolicyLayerHeader, outputs int32_t biases and
+// outputs x paddedInputs int8_t weights (row per output, padding zero)
+struct PolicyHeader {
+    uint32_t magic = POLICY_MAGIC;
+    uint16_t version = POLICY_VERSION;
+    uint16_t layerCount = 0;
+};
+static_assert(sizeof(PolicyHeader) == 8, "PolicyHeader is written as is");
+
+struct PolicyLayerHeader {
+    uint16_t inputs = 0;
+    uint16_t outputs = 0;
+    float scale = 1.0f; // Hidden layers: activation = clamp((dot + bias) * scale, 0, 127)
+};
+static_assert(sizeof(PolicyLayerHeader) == 8, "PolicyLayerHeader is written as is");
+
+struct PolicyLayer {
+    int inputs = 0;
+    int paddedInputs = 0;
+    int outputs = 0;
+    float scale = 1.0f;
+    std::vector<int32_t> biases;
+    std::vector<int8_t> weights;
+};
+
+struct PolicyNetwork {
+    std::vector<PolicyLayer> layers; // The last layer's outputs are the MOVE_COUNT move scores
+
+    bool load(const std::string& path, std::string& error);
+    bool save(const std::string& path) const;
+    void randomise(const std::vector<int>& hidden, SimRandom& rng); // Fresh network, e.g. for the trainer's first generation
+
+    // observations: batch x POLICY_INPUTS; moves: batch best macro moves
+    void evaluate(const uint8_t* observations, int batch, int* moves) const;
+};
+
+const char* policySimdName(); // Dot-product path this CPU runs: "AVX2", "SSSE3" or "scalar"
+
+// Observation for one side, mirrored so player 2 sees the bout as player 1 does
+void observe(const MatchState& state, int side, uint8_t* observation);
+
+struct PolicyBot {
+    const PolicyNetwork& network;
+    int player;
+    int stepTicks = 10;      // Ticks each macro move is held for, as in the other bots
+    int committedMove = MOVE_HOLD;
+    int moveTick = 0;
+
+    PolicyBot(const PolicyNetwork& network, int player) : network(network), player(player) { reset(); }
+
+    InputWord update(const MatchState& state); // Call once per tick
+    void reset();
+};
+
+#endif // POLICY_H
@@ -0,0 +1,351 @@
+#include "replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <string>
+
+bool ReplayWriter::open(const std::string& path, const ReplayHeader& header, const MatchState& state) {
+    close();
+    this->path = path;
+    this->header = header;
+    this->header.magic = REPLAY_MAGIC;
+    this->header.version = REPLAY_VERSION;
+    this->header.weapon = state.weapon;
+    this->header.distance = static_cast<int16_t>(state.fencers[1].x - state.fencers[0].x);
+    this->header.tickCount = 0;
+    this->header.points[0] = state.points[0];
+    this->header.points[1] = state.points[1];
+    this->header.over = state.over ? 1 : 0;
+    this->header.finalHash = hashMatchState(state);
+    this->header.streamBytes = 0;
+    if (this->header.checkpointTicks == 0 || this->header.checkpointTicks > INPUT_RUN_MAX_TICKS) {
+        this->header.checkpointTicks = REPLAY_CHECKPOINT_TICKS;
+    }
+    if (this->header.keyframeTicks == 0) this->header.keyframeTicks = REPLAY_KEYFRAME_TICKS;
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    // Written again on close with the outcome; a replay cut short reads as a bout without ticks
+    if (std::fwrite(&this->header, sizeof(ReplayHeader), 1, file) != 1) {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    queue = std::make_unique<uint8_t[]>(REPLAY_QUEUE_BYTES);
+    head = 0;
+    tail = 0;
+    closing = false;
+    failed = false;
+    runs = InputRunEncoder();
+    keyframe = zeroState();
+    index.clear();
+    pushKeyframe(state);
+    writer = std::thread(&ReplayWriter::writerLoop, this);
+    return true;
+}
+
+// A full queue loses the replay rather than stalling the frame; at a few bytes a second it takes the
+// disk stalling for minutes
+void ReplayWriter::push(const uint8_t* bytes, size_t count) {
+    uint64_t index = head.load(std::memory_order_relaxed);
+    if (index + count - tail.load(std::memory_order_acquire) > REPLAY_QUEUE_BYTES) {
+        failed = true;
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) queue[(index + i) % REPLAY_QUEUE_BYTES] = bytes[i];
+    head.store(index + count, std::memory_order_release);
+}
+
+// Bytes are pushed in order from the start of the stream, so head is where the delta starts
+void ReplayWriter::pushKeyframe(const MatchState& state) {
+    index.push_back({header.tickCount, static_cast<uint32_t>(head.load(std::memory_order_relaxed))});
+    uint8_t bytes[STATE_DELTA_MAX_BYTES];
+    uint8_t* end = encodeStateDelta(keyframe, state, bytes);
+    push(bytes, static_cast<size_t>(end - bytes));
+    keyframe = state;
+}
+
+void ReplayWriter::record(InputWord player1Input, InputWord player2Input, const MatchState& after) {
+    if (!file) return;
+    uint8_t bytes[INPUT_RUN_MAX_BYTES * 2 + sizeof(uint64_t)];
+    uint8_t* out = runs.add(packInputs(player1Input, player2Input), bytes);
+
+    uint64_t hash = hashMatchState(after);
+    header.tickCount++;
+    bool checkpoint = header.tickCount % header.checkpointTicks == 0;
+    bool keyframe = header.tickCount % header.keyframeTicks == 0;
+    if (checkpoint || keyframe) out = runs.flush(out);
+    if (checkpoint) {
+        std::memcpy(out, &hash, sizeof(hash));
+        out += sizeof(hash);
+    }
+    if (out != bytes) push(bytes, static_cast<size_t>(out - bytes));
+    if (keyframe) pushKeyframe(after);
+
+    header.finalHash = hash;
+    header.points[0] = after.points[0];
+    header.points[1] = after.points[1];
+    header.over = after.over ? 1 : 0;
+}
+
+bool ReplayWriter::close() {
+    if (!file) return true;
+    uint8_t bytes[INPUT_RUN_MAX_BYTES];
+    uint8_t* out = runs.flush(bytes);
+    if (out != bytes) push(bytes, static_cast<size_t>(out - bytes));
+    closing = true;
+    writer.join();
+    header.streamBytes = static_cast<uint32_t>(head.load());
+    queue.reset();
+
+    bool ok = !failed;
+    if (header.tickCount == 0) {
+        std::fclose(file);
+        file = nullptr;
+        std::remove(path.c_str()); // Nothing was played
+        return ok;
+    }
+    uint8_t padding[4] = {};
+    ReplayIndexFooter footer;
+    footer.keyframeCount = static_cast<uint32_t>(index.size());
+    size_t paddingBytes = (4 - (sizeof(ReplayHeader) + header.streamBytes) % 4) % 4;
+    ok = ok && std::fwrite(padding, 1, paddingBytes, file) == paddingBytes;
+    ok = ok && std::fwrite(index.data(), sizeof(ReplayKeyframe), index.size(), file) == index.size();
+    ok = ok && std::fwrite(&footer, sizeof(footer), 1, file) == 1;
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+}
+
+// Polls like DatasetWriter, so recording a tick never makes a system call
+void ReplayWriter::writerLoop() {
+    while (true) {
+        uint64_t index = tail.load(std::memory_order_relaxed);
+        uint64_t end = head.load(std::memory_order_acquire);
+        if (index == end) {
+            if (closing) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+            continue;
+        }
+        // At most two spans, split where the queue wraps
+        while (index != end) {
+            size_t start = index % REPLAY_QUEUE_BYTES;
+            size_t count = static_cast<size_t>(std::min<uint64_t>(end - index, REPLAY_QUEUE_BYTES - start));
+            if (std::fwrite(&queue[start], 1, count, file) != count) failed = true;
+            index += count;
+        }
+        tail.store(end, std::memory_order_release);
+    }
+}
+
+bool MappedReplay::open(const std::string& path, MapAccess access) {
+    close();
+    if (!file.open(path, sizeof(ReplayHeader) + sizeof(ReplayIndexFooter), access)) {
+        error = file.error;
+        return false;
+    }
+
+    header = static_cast<const ReplayHeader*>(file.data);
+    if (header->magic != REPLAY_MAGIC || header->version != REPLAY_VERSION || header->weapon >= WEAPON_COUNT ||
+        header->checkpointTicks == 0 || header->checkpointTicks > INPUT_RUN_MAX_TICKS || header->keyframeTicks == 0) {
+        error = "not a version " + std::to_string(REPLAY_VERSION) + " replay";
+        header = nullptr;
+        return false;
+    }
+    const char* base = static_cast<const char*>(file.data);
+    const ReplayIndexFooter* footer = reinterpret_cast<const ReplayIndexFooter*>(base + file.size - sizeof(ReplayIndexFooter));
+    size_t indexStart = (sizeof(ReplayHeader) + static_cast<size_t>(header->streamBytes) + 3) / 4 * 4;
+    if (footer->magic != REPLAY_INDEX_MAGIC ||
+        file.size != indexStart + static_cast<size_t>(footer->keyframeCount) * sizeof(ReplayKeyframe) + sizeof(ReplayIndexFooter)) {
+        error = "truncated or without an index (" + std::to_string(file.size) + " bytes)";
+        header = nullptr;
+        return false;
+    }
+    stream = reinterpret_cast<const uint8_t*>(base + sizeof(ReplayHeader));
+    keyframes = reinterpret_cast<const ReplayKeyframe*>(base + indexStart);
+    keyframeCount = footer->keyframeCount;
+
+    // Readers trust the index, so the stream is decoded once here: it must add up to tickCount with
+    // every keyframe where the index says. The snapshots are kept, so a seek decodes no delta chain.
+    size_t keyframe = 0;
+    bool indexed = keyframeCount > 0 && keyframes[0].tick == 0 && keyframes[0].offset == 0;
+    ReplayReader reader(*this);
+    snapshots.clear();
+    snapshots.reserve(keyframeCount);
+    if (indexed && !reader.failed) {
+        snapshots.push_back(zeroState());
+        decodeStateDelta(stream, stream + header->streamBytes, snapshots[0], snapshots[0]);
+    }
+    InputWord player1Input, player2Input;
+    while (indexed && reader.next(player1Input, player2Input)) {
+        if (!reader.keyframe) continue;
+        keyframe++;
+        indexed = keyframe < keyframeCount && keyframes[keyframe].tick == reader.tick &&
+                  keyframes[keyframe].offset == reader.keyframeOffset;
+        if (indexed) snapshots.push_back(*reader.keyframe);
+    }
+    if (!indexed || reader.failed || reader.tick != header->tickCount || keyframe + 1 != keyframeCount) {
+        error = reader.failed ? "stream breaks off at tick " + std::to_string(reader.tick)
+                              : "stream holds " + std::to_string(reader.tick) + " ticks and " + std::to_string(keyframe + 1) +
+                                    " keyframes, the header and index " + std::to_string(header->tickCount) + " and " +
+                                    std::to_string(keyframeCount);
+        header = nullptr;
+        return false;
+    }
+    error.clear();
+    return true;
+}
+
+void MappedReplay::close() {
+    file.close();
+    header = nullptr;
+    stream = nullptr;
+    keyframes = nullptr;
+    keyframeCount = 0;
+    snapshots.clear();
+}
+
+// Each keyframe is a delta of the one before, so the chain was decoded from the first by open()
+void MappedReplay::keyframeState(size_t k, MatchState& state) const {
+    state = snapshots[k];
+}
+
+void MappedReplay::startState(MatchState& state) const {
+    keyframeState(0, state);
+    if (state.tick != 0) return;
+    initMatch(state, header->weapon);
+    placeFencers(state, header->distance);
+}
+
+ReplayReader MappedReplay::seek(uint32_t tick, MatchState& state) const {
+    tick = std::min(tick, header->tickCount);
+    const ReplayKeyframe* from =
+        std::upper_bound(keyframes, keyframes + keyframeCount, tick, [](uint32_t t, const ReplayKeyframe& k) { return t < k.tick; }) - 1;
+    keyframeState(static_cast<size_t>(from - keyframes), state);
+    ReplayReader reader(*this, *from, state);
+    InputWord player1Input, player2Input;
+    for (uint32_t t = from->tick; t < tick && reader.next(player1Input, player2Input); ++t) {
+        stepMatch(state, player1Input, player2Input);
+    }
+    return reader;
+}
+
+ReplayReader::ReplayReader(const MappedReplay& replay)
+    : start(replay.stream), in(replay.stream), end(replay.stream + replay.header->streamBytes),
+      checkpointTicks(replay.header->checkpointTicks), keyframeTicks(replay.header->keyframeTicks) {
+    // The snapshot before the first tick
+    in = decodeStateDelta(in, end, zeroState(), snapshot);
+    if (!in) fail();
+}
+
+ReplayReader::ReplayReader(const MappedReplay& replay, const ReplayKeyframe& from, const MatchState& state)
+    : tick(from.tick), start(replay.stream), in(replay.stream + from.offset), end(replay.stream + replay.header->streamBytes),
+      checkpointTicks(replay.header->checkpointTicks), keyframeTicks(replay.header->keyframeTicks), snapshot(state) {
+    keyframeOffset = from.offset;
+    MatchState skipped;
+    in = decodeStateDelta(in, end, snapshot, skipped); // Only to step over it
+    if (!in) fail();
+}
+
+bool ReplayReader::fail() {
+    failed = true;
+    in = end;
+    left = 0;
+    return false;
+}
+
+// Runs end on every boundary, so marks are taken as soon as a run is used up
+void ReplayReader::readMarks() {
+    if (tick % checkpointTicks == 0) {
+        if (end - in < static_cast<ptrdiff_t>(sizeof(uint64_t))) {
+            fail();
+            return;
+        }
+        std::memcpy(&checkpointHash, in, sizeof(uint64_t));
+        in += sizeof(uint64_t);
+        checked = true;
+    }
+    if (tick % keyframeTicks == 0) {
+        keyframeOffset = static_cast<size_t>(in - start);
+        in = decodeStateDelta(in, end, snapshot, snapshot);
+        if (!in) {
+            fail();
+            return;
+        }
+        keyframe = &snapshot;
+    }
+}
+
+bool ReplayReader::next(InputWord& player1Input, InputWord& player2Input) {
+    checked = false;
+    keyframe = nullptr;
+    if (left == 0) {
+        if (in == end) return false;
+        in = getInputRun(in, end, keys, left);
+        if (!in) return fail();
+        // A run may not cross the next mark
+        uint32_t boundary = std::min(checkpointTicks - tick % checkpointTicks, keyframeTicks - tick % keyframeTicks);
+        if (left > boundary) return fail();
+    }
+    player1Input = static_cast<InputWord>(keys & 0x1F);
+    player2Input = static_cast<InputWord>(keys >> 5 & 0x1F);
+    tick++;
+    if (--left == 0) readMarks();
+    return true;
+}
+
+// Re-simulates the replay from its inputs and compares every checkpoint and keyframe and the final outcome
+ReplayCheck verifyReplay(const MappedReplay& replay) {
+    ReplayCheck check;
+    if (!replay.header) return check;
+    check.valid = true;
+
+    const ReplayHeader& header = *replay.header;
+    MatchState state;
+    replay.startState(state);
+
+    ReplayReader reader(replay);
+    InputWord player1Input, player2Input;
+    uint32_t t = 0;
+    for (; reader.next(player1Input, player2Input); ++t) {
+        stepMatch(state, player1Input, player2Input);
+        if (check.divergentTick >= 0 || (!reader.checked && !reader.keyframe)) continue;
+        // Once diverged only the outcome is still of interest, so later marks are skipped
+        uint64_t hash = hashMatchState(state);
+        uint64_t expected = reader.checkpointHash;
+        if (reader.keyframe && (!reader.checked || hash == expected)) expected = hashMatchState(*reader.keyframe);
+        if (hash != expected) {
+            check.divergentTick = t;
+            check.expectedHash = expected;
+            check.actualHash = hash;
+        }
+    }
+    uint64_t hash = hashMatchState(state);
+    if (check.divergentTick < 0 && hash != header.finalHash) {
+        check.divergentTick = header.tickCount > 0 ? header.tickCount - 1 : 0;
+        check.expectedHash = header.finalHash;
+        check.actualHash = hash;
+    }
+
+    check.points[0] = state.points[0];
+    check.points[1] = state.points[1];
+    check.over = state.over;
+    check.matches = check.divergentTick < 0 && state.points[0] == header.points[0] && state.points[1] == header.points[1] &&
+                    state.over == (header.over != 0);
+    return check;
+}
+
+std::string replayPath(const std::string& directory) {
+    char stamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&now));
+    std::string path = directory + "/bout_" + stamp + REPLAY_EXTENSION;
+    for (int copy = 1; std::filesystem::exists(path); ++copy) {
+        path = directory + "/bout_" + stamp + "_" + std::to_string(copy) + REPLAY_EXTENSION;
+    }
+    return path;
+}
@@ -0,0 +1,181 @@
+// Bout replays: the keys both players held, run-length coded, with a hash of the match state every
+// few seconds, so a replay can be re-simulated after an engine change and checked. Delta-coded
+// snapshots every ten seconds, listed in an index at the end of the file, let a viewer jump into the
+// middle of a bout and re-simulate only from the keyframe before it. A three-period bout takes a
+// few kilobytes. The game records the match it plays (main.cpp steps only this state), so a replay
+// re-simulates to the bout that was on screen; it records through a background writer, so the disk
+// is never touched on the frame.
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "simulation.h"
+#include "compress.h"
+#include "mappedfile.h"
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define REPLAY_MAGIC 0x4c505246u // "FRPL"
+#define REPLAY_VERSION 4
+#define REPLAY_EXTENSION ".rpl"
+#define REPLAY_CHECKPOINT_TICKS 120   // Two seconds between state hashes
+#define REPLAY_KEYFRAME_TICKS 600     // Ten seconds between snapshots; a seek re-simulates fewer ticks than this
+#define REPLAY_QUEUE_BYTES (1 << 17)  // Minutes of play buffered for the writer thread
+#define REPLAY_INDEX_MAGIC 0x58444946u // "FIDX"
+
+// File layout: ReplayHeader, then streamBytes bytes of runs and marks, then the keyframe index.
+// Each run is an InputRunEncoder varint holding both players' keys and how many ticks they were held.
+// Runs end at every checkpointTicks and keyframeTicks boundary, and what is due there follows:
+// - A checkpoint: the 8-byte hashMatchState after the ticks so far.
+// - A keyframe: the MatchState after the ticks so far, encodeStateDelta against the keyframe before
+//   it. The stream starts with one, against zeroState(), for tick 0.
+// The checkpoint comes first when both are due. A flight recorder dump (flightrecorder.h) is an
+// excerpt: its first snapshot is taken mid-bout, so its MatchState::tick is not 0, and tick counts in
+// the file are from there. The index starts at the next 4-byte boundary: a
+// ReplayKeyframe per keyframe, then a ReplayIndexFooter.
+struct ReplayHeader {
+    uint32_t magic = REPLAY_MAGIC;
+    uint16_t version = REPLAY_VERSION;
+    uint8_t weapon = WEAPON_EPEE;
+    uint8_t over = 0;              // The bout ended on the last tick
+    uint64_t seed = 0;             // Seed of a generated bout, 0 when people played it
+    uint64_t finalHash = 0;        // hashMatchState after the last tick
+    uint32_t tickCount = 0;
+    int16_t distance = SIM_START_X2 - SIM_START_X1; // placeFencers gap at tick 0
+    int8_t points[2] = {SIM_START_POINTS, SIM_START_POINTS}; // Outcome after the last tick
+    uint16_t checkpointTicks = REPLAY_CHECKPOINT_TICKS; // At most INPUT_RUN_MAX_TICKS
+    uint16_t keyframeTicks = REPLAY_KEYFRAME_TICKS;
+    int32_t keys[2][INPUT_SYMBOLS] = {}; // SDL_Keycode bound to each InputBit from input.txt, 0 if unbound
+    uint32_t streamBytes = 0;      // Length of the run and mark stream
+};
+static_assert(sizeof(ReplayHeader) == 80, "ReplayHeader is written as is");
+
+struct ReplayKeyframe {
+    uint32_t tick;                 // Ticks played before the snapshot
+    uint32_t offset;               // Where its delta starts in the stream
+};
+
+struct ReplayIndexFooter {
+    uint32_t keyframeCount;
+    uint32_t magic = REPLAY_INDEX_MAGIC;
+};
+
+// Records a bout as it is played. record() codes the tick into the current run and hands finished
+// bytes to a writer thread through a wait-free single-producer queue; the index is appended and the
+// header written again with the outcome on close.
+struct ReplayWriter {
+    ReplayHeader header;
+    std::string path;
+
+    ReplayWriter() = default;
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+    ~ReplayWriter() { close(); }
+
+    // Takes seed, keys and the intervals from header; state is the match at tick 0
+    bool open(const std::string& path, const ReplayHeader& header, const MatchState& state);
+    bool isOpen() const { return file != nullptr; }
+    // Call after stepMatch with the keys just played. Any other change to the match (e.g. an annulled
+    // touch) breaks re-simulation: close the replay and open a new one from the changed state.
+    void record(InputWord player1Input, InputWord player2Input, const MatchState& after);
+    // Writes the last run, the index and the outcome; a bout without ticks leaves no file. False on a
+    // write error.
+    bool close();
+
+private:
+    FILE* file = nullptr;
+    std::thread writer;
+    std::unique_ptr<uint8_t[]> queue;
+    alignas(64) std::atomic<uint64_t> head{0}; // Next byte to write, advanced by the playing thread
+    alignas(64) std::atomic<uint64_t> tail{0}; // Next byte to read, advanced by the writer thread
+    alignas(64) std::atomic<bool> closing{false};
+    std::atomic<bool> failed{false};
+    InputRunEncoder runs;
+    MatchState keyframe;           // Last snapshot, what the next is coded against
+    std::vector<ReplayKeyframe> index;
+
+    void push(const uint8_t* bytes, size_t count);
+    void pushKeyframe(const MatchState& state);
+    void writerLoop();
+};
+
+struct ReplayReader;
+
+// A replay file mapped read-only into memory; the stream and index point straight into the mapping
+struct MappedReplay {
+    const ReplayHeader* header = nullptr;
+    const uint8_t* stream = nullptr;
+    const ReplayKeyframe* keyframes = nullptr;
+    size_t keyframeCount = 0;
+    std::string error;
+
+    MappedReplay() = default;
+    MappedReplay(const MappedReplay&) = delete;
+    MappedReplay& operator=(const MappedReplay&) = delete;
+    ~MappedReplay() { close(); }
+
+    // Decodes the whole stream once to check it adds up to tickCount and agrees with the index.
+    // Viewers that seek around pass MAP_ACCESS_RANDOM.
+    bool open(const std::string& path, MapAccess access = MAP_ACCESS_SEQUENTIAL);
+    void close();
+    // The snapshot of keyframe k, kept by open(); no delta chain is decoded
+    void keyframeState(size_t k, MatchState& state) const;
+    // The match before the first tick, as re-simulation starts it: from the rules (initMatch and the
+    // header's gap) for a whole bout, from the first snapshot for an excerpt that starts mid-bout
+    void startState(MatchState& state) const;
+    // The state after tick ticks (clamped to tickCount): the last keyframe at or before it,
+    // re-simulated to the tick. Returns a reader at that tick, so playback can go on from there.
+    ReplayReader seek(uint32_t tick, MatchState& state) const;
+
+    MappedFile file;
+    std::vector<MatchState> snapshots; // Every keyframe's, decoded by open() (40 bytes per ten seconds)
+};
+
+// Walks a replay tick by tick, from the start or from a keyframe, in constant memory. Safe on any
+// bytes: a stream that runs out early or breaks its boundaries sets failed and ends.
+struct ReplayReader {
+    bool checked = false;          // A checkpoint follows the tick just read
+    uint64_t checkpointHash = 0;   // Its hash
+    const MatchState* keyframe = nullptr; // Snapshot following the tick just read, nullptr if none
+    size_t keyframeOffset = 0;     // Where the last snapshot read starts in the stream
+    uint32_t tick = 0;             // Ticks read
+    bool failed = false;
+
+    explicit ReplayReader(const MappedReplay& replay);
+    // Continues after keyframe from, whose decoded snapshot is state
+    ReplayReader(const MappedReplay& replay, const ReplayKeyframe& from, const MatchState& state);
+    bool next(InputWord& player1Input, InputWord& player2Input); // False after the last tick
+
+private:
+    const uint8_t* start;
+    const uint8_t* in;
+    const uint8_t* end;
+    uint16_t checkpointTicks;
+    uint16_t keyframeTicks;
+    uint16_t keys = 0;
+    uint32_t left = 0;             // Ticks still to play from the current run
+    MatchState snapshot;
+
+    void readMarks();
+    bool fail();
+};
+
+// Result of re-simulating a replay
+struct ReplayCheck {
+    bool valid = false;        // The file could be read
+    bool matches = false;      // Every checkpoint hash and the outcome are unchanged
+    int64_t divergentTick = -1; // Tick of the first checkpoint whose hash differs, -1 if none
+    uint64_t expectedHash = 0;
+    uint64_t actualHash = 0;
+    int8_t points[2] = {0, 0}; // Outcome of the re-simulation
+    bool over = false;
+};
+
+ReplayCheck verifyReplay(const MappedReplay& replay);
+// New file in directory named after the current time, numbering bouts started within the same second
+std::string replayPath(const std::string& directory);
+
+#endif // REPLAY_H
@@ -0,0 +1,135 @@
+#include "replayviewer.h"
+#include "common.h"
+#include "character.h"
+#include "replay.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+static const int speeds[] = REPLAY_VIEWER_SPEEDS;
+static const int speedCount = static_cast<int>(sizeof(speeds) / sizeof(speeds[0]));
+
+// Speed, position and the simulation rate at max speed, in the top-left corner
+void renderReplayStatus(SDL_Renderer* renderer, TTF_Font* font, const std::string& text) {
+    SDL_Color color = {255, 255, 255, 255}; // White color
+    SDL_Surface* surface = TTF_RenderText_Solid(font, text.c_str(), color);
+    if (!surface) return;
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture) {
+        SDL_Rect destRect = {10, 10, surface->w, surface->h};
+        SDL_RenderCopy(renderer, texture, nullptr, &destRect);
+        SDL_DestroyTexture(texture);
+    }
+    SDL_FreeSurface(surface);
+}
+
+int runReplayViewer(INITSDL& app, SDL_Texture* background, Character& player1, Character& player2, const std::string& path) {
+    MappedReplay replay;
+    if (!replay.open(path, MAP_ACCESS_RANDOM)) {
+        std::cerr << "Cannot play " << path << ": " << replay.error << std::endl;
+        return -1;
+    }
+    uint32_t tickCount = replay.header->tickCount;
+    std::string weapon = WEAPON_NAMES[replay.header->weapon];
+    player1.setWeaponType(weapon);
+    player2.setWeaponType(weapon);
+    std::cout << "Playing " << path << ": " << weapon << ", " << tickCount << " ticks" << std::endl;
+
+    const int frameDelay = 1000 / SIM_FPS;
+    MatchState state;
+    ReplayReader reader = replay.seek(0, state);
+    int speed = 0;             // Index into speeds
+    bool paused = false;
+    double owed = 0.0;         // Ticks due at a fixed speed but not yet played
+    Uint32 lastFrame = SDL_GetTicks();
+    Uint32 lastRate = lastFrame;
+    uint32_t rateTicks = 0;    // Ticks played since lastRate
+    uint32_t tickRate = 0;     // Ticks per second, measured over the last second
+
+    auto advance = [&]() {
+        InputWord player1Input, player2Input;
+        if (!reader.next(player1Input, player2Input)) return false;
+        stepMatch(state, player1Input, player2Input);
+        rateTicks++;
+        return true;
+    };
+    auto jump = [&](int64_t tick) {
+        tick = std::max<int64_t>(0, std::min<int64_t>(tick, tickCount));
+        reader = replay.seek(static_cast<uint32_t>(tick), state);
+        owed = 0.0;
+    };
+
+    bool running = true;
+    SDL_Event event;
+    while (running) {
+        Uint32 frameStart = SDL_GetTicks();
+        int steps = 0;         // Single ticks asked for this frame
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) running = false;
+            if (event.type != SDL_KEYDOWN) continue;
+            SDL_Keycode key = event.key.keysym.sym;
+            if (key == SDLK_ESCAPE) running = false;
+            if (key == SDLK_SPACE) paused = !paused;
+            if (key >= SDLK_1 && key < SDLK_1 + speedCount) speed = key - SDLK_1;
+            if (key == SDLK_UP) speed = std::min(speed + 1, speedCount - 1);
+            if (key == SDLK_DOWN) speed = std::max(speed - 1, 0);
+            if (key == SDLK_PERIOD) {
+                paused = true;
+                steps++;
+            }
+            if (key == SDLK_COMMA) {
+                paused = true;
+                jump(static_cast<int64_t>(reader.tick) - 1);
+            }
+            if (key == SDLK_LEFT) jump(static_cast<int64_t>(reader.tick) - REPLAY_VIEWER_JUMP_TICKS);
+            if (key == SDLK_RIGHT) jump(static_cast<int64_t>(reader.tick) + REPLAY_VIEWER_JUMP_TICKS);
+            if (key == SDLK_HOME) jump(0);
+        }
+
+        // Play this frame's ticks, then draw only where they ended
+        for (; steps > 0 && advance(); --steps) {}
+        if (!paused && speeds[speed] == 0) {
+            Uint32 deadline = frameStart + REPLAY_VIEWER_BUDGET_MS;
+            bool more = true;
+            while (more && SDL_GetTicks() < deadline) {
+                for (int i = 0; i < 256 && (more = advance()); ++i) {} // The clock is read every 256 ticks
+            }
+        } else if (!paused) {
+            // Elapsed time rather than a fixed count per frame, so a slow frame does not slow playback;
+            // a stall longer than a few frames is not caught up
+            owed += speeds[speed] * (frameStart - lastFrame) * SIM_FPS / 1000.0;
+            owed = std::min(owed, 4.0 * speeds[speed]);
+            for (; owed >= 1.0 && advance(); owed -= 1.0) {}
+        }
+        lastFrame = frameStart;
+        if (reader.tick >= tickCount) paused = true; // Held on the last tick until a jump back
+
+        if (frameStart - lastRate >= 1000) {
+            tickRate = rateTicks * 1000 / (frameStart - lastRate);
+            rateTicks = 0;
+            lastRate = frameStart;
+        }
+
+        SDL_SetRenderDrawColor(app.renderer, 0, 0, 0, 255); // Black background
+        SDL_RenderClear(app.renderer);
+        SDL_Rect destRect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+        SDL_RenderCopy(app.renderer, background, nullptr, &destRect);
+        player1.renderState(app, state, 0);
+        player2.renderState(app, state, 1);
+        player1Points = state.points[0];
+        player2Points = state.points[1];
+        player1.renderGameInfo(app.renderer, app.font, state.period, state.periodTicks * 1000u / SIM_FPS);
+        std::string speedText = speeds[speed] == 0 ? "max" : std::to_string(speeds[speed]) + "x";
+        renderReplayStatus(app.renderer, app.font,
+                     (paused ? "Paused" : "Replay " + speedText) + "  tick " + std::to_string(reader.tick) + " / " +
+                         std::to_string(tickCount) + "  " + std::to_string(tickRate) + " ticks/s");
+        SDL_RenderPresent(app.renderer);
+
+        // Max speed draws as soon as its budget is spent; every other speed keeps the game's frame rate
+        Uint32 frameTime = SDL_GetTicks() - frameStart;
+        if ((paused || speeds[speed] != 0) && frameTime < static_cast<Uint32>(frameDelay)) {
+            SDL_Delay(frameDelay - frameTime);
+        }
+    }
+    return 0;
+}
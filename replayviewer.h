@@ -0,0 +1,29 @@
+// Plays a recorded bout back in the game window (Fencing --replay FILE). Playback is decoupled from
+// drawing: each displayed frame simulates as many ticks as the speed asks for and draws only the last
+// state, so 16x costs one frame of drawing like 1x does, and max speed is limited by the simulation
+// rather than by the 60 FPS frame delay.
+//
+// Keys: Space pauses, 1-5 pick 1x/2x/4x/16x/max (Up/Down step through them), Period and Comma step one
+// tick forward or back while paused, Left and Right jump ten seconds, Home restarts, Escape quits.
+#ifndef REPLAYVIEWER_H
+#define REPLAYVIEWER_H
+
+#include "simulation.h"
+#include <string>
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+struct INITSDL;
+struct Character;
+
+#define REPLAY_VIEWER_SPEEDS {1, 2, 4, 16, 0} // Ticks per 60 FPS frame; 0 is as fast as the simulation goes
+#define REPLAY_VIEWER_BUDGET_MS 12            // Simulation time per frame at max speed; drawing gets the rest
+#define REPLAY_VIEWER_JUMP_TICKS (10 * SIM_FPS)
+
+// Returns 0 when the viewer is closed, -1 if the replay cannot be read
+int runReplayViewer(INITSDL& app, SDL_Texture* background, Character& player1, Character& player2, const std::string& path);
+
+// A line of white text in the top-left corner
+void renderReplayStatus(SDL_Renderer* renderer, TTF_Font* font, const std::string& text);
+
+#endif // REPLAYVIEWER_H
@@ -0,0 +1,119 @@
+#include "review.h"
+#include "common.h"
+#include "character.h"
+#include "replayviewer.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+void ReviewRing::clear() {
+    count = 0;
+    valid = 0;
+    loser = -1;
+    touchCount = 0;
+}
+
+void ReviewRing::record(const MatchState& after) {
+    states[count % REVIEW_TICKS] = after;
+    count++;
+    if (valid < REVIEW_TICKS) valid++;
+    if (loser >= 0 && count - touchCount >= REVIEW_TICKS) loser = -1; // The touch has left the ring: too late to call
+}
+
+void ReviewRing::touch(int player, const MatchState& before) {
+    loser = player;
+    touchCount = count;
+    beforeTouch = before;
+}
+
+MatchState ReviewRing::annul() {
+    // Back to the tick before the touch: the touch and every tick after it leave the ring
+    uint32_t dropped = count - touchCount + 1;
+    count -= dropped;
+    valid = valid > dropped ? valid - dropped : 0;
+    loser = -1;
+    // Halted on guard where they stood, so the attack that touched cannot land again on the next tick
+    MatchState restored = beforeTouch;
+    for (FencerState& fencer : restored.fencers) {
+        fencer.velocityX = 0;
+        fencer.action = ACTION_IDLE;
+        fencer.actionTicks = 0;
+    }
+    return restored;
+}
+
+uint32_t ReviewRing::size() const {
+    return valid;
+}
+
+const MatchState& ReviewRing::at(uint32_t back) const {
+    return states[(count - 1 - back) % REVIEW_TICKS];
+}
+
+ReviewCall runReview(INITSDL& app, SDL_Texture* background, Character& player1, Character& player2, ReviewRing& ring,
+                     const MatchState& match) {
+    uint32_t frames = ring.size();
+    if (frames == 0) return REVIEW_NONE;
+    // Opens on the touch when it is still in the ring, on the newest tick otherwise
+    uint32_t touchBack = ring.count - ring.touchCount;
+    bool touchShown = ring.loser >= 0 && touchBack < frames;
+    uint32_t back = touchShown ? touchBack : 0;
+    std::cout << "Review: " << frames << " ticks" << (touchShown ? ", point against P" + std::to_string(ring.loser + 1) : "")
+              << std::endl;
+
+    const int frameDelay = 1000 / SIM_FPS;
+    bool playing = false;
+    ReviewCall call = REVIEW_NONE;
+    bool reviewing = true;
+    SDL_Event event;
+    while (reviewing) {
+        Uint32 frameStart = SDL_GetTicks();
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT) {
+                call = REVIEW_QUIT;
+                reviewing = false;
+            }
+            if (event.type != SDL_KEYDOWN) continue;
+            SDL_Keycode key = event.key.keysym.sym;
+            if (key == SDLK_LEFT) back = std::min(back + 1, frames - 1);
+            if (key == SDLK_RIGHT) back = back > 0 ? back - 1 : 0;
+            if (key == SDLK_DOWN) back = std::min<uint32_t>(back + SIM_FPS, frames - 1);
+            if (key == SDLK_UP) back = back > SIM_FPS ? back - SIM_FPS : 0;
+            if (key == SDLK_HOME) back = frames - 1;
+            if (key == SDLK_END) back = 0;
+            if (key == SDLK_LEFT || key == SDLK_RIGHT || key == SDLK_DOWN || key == SDLK_UP || key == SDLK_HOME || key == SDLK_END) {
+                playing = false;
+            }
+            if (key == SDLK_SPACE) playing = !playing && back > 0;
+            if ((key == SDLK_y || key == SDLK_n) && touchShown) { // Only a touch the referee can see
+                call = key == SDLK_y ? REVIEW_CONFIRMED : REVIEW_ANNULLED;
+                reviewing = false;
+            }
+            if (key == SDLK_ESCAPE || key == REVIEW_KEY) reviewing = false;
+        }
+        if (playing && back > 0) back--;
+        if (back == 0) playing = false;
+
+        SDL_SetRenderDrawColor(app.renderer, 0, 0, 0, 255); // Black background
+        SDL_RenderClear(app.renderer);
+        SDL_Rect destRect = {0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+        SDL_RenderCopy(app.renderer, background, nullptr, &destRect);
+        const MatchState& state = ring.at(back);
+        player1.renderState(app, state, 0);
+        player2.renderState(app, state, 1);
+        player1.renderGameInfo(app.renderer, app.font, match.period, match.periodTicks * 1000u / SIM_FPS); // The score being called
+        char when[32];
+        std::snprintf(when, sizeof(when), "-%.2f s", static_cast<double>(back) / SIM_FPS);
+        std::string status = std::string(playing ? "Review 1x  " : "Review  ") + when + (touchShown && back == touchBack ? "  TOUCH" : "");
+        status += touchShown ? "  Y confirms, N annuls the point against P" + std::to_string(ring.loser + 1) : "  No point to call";
+        renderReplayStatus(app.renderer, app.font, status);
+        SDL_RenderPresent(app.renderer);
+
+        Uint32 frameTime = SDL_GetTicks() - frameStart;
+        if (frameTime < static_cast<Uint32>(frameDelay)) SDL_Delay(frameDelay - frameTime);
+    }
+
+    if (call == REVIEW_CONFIRMED) ring.loser = -1;
+    return call;
+}
@@ -0,0 +1,47 @@
+// Referee video review (F11 during a bout). The game keeps the headless match after each of the last
+// ten seconds of ticks in a ring; a review freezes the bout and scrubs through them, drawn with the
+// game's sprites (Character::renderState, as in a replay). The referee then confirms or annuls the last
+// touch while it is still among those ticks. A confirmed touch, or none, resumes the bout from the
+// state it was frozen in; an annulled one resumes it from the tick before the touch, both fencers on
+// guard where they stood and the point back.
+//
+// Keys: Left and Right step one tick (held, they scrub), Down and Up jump a second, Home and End go to
+// the oldest and newest tick, Space plays forward at 1x. Y confirms, N annuls, Escape or F11 resumes
+// with the call left as it stands.
+#ifndef REVIEW_H
+#define REVIEW_H
+
+#include "simulation.h"
+#include <SDL.h>
+
+struct INITSDL;
+struct Character;
+
+#define REVIEW_KEY SDLK_F11
+#define REVIEW_TICKS (10 * SIM_FPS)
+
+// The match after each of the last REVIEW_TICKS ticks, and the touch under review
+struct ReviewRing {
+    void clear(); // A new bout
+    void record(const MatchState& after);
+    void touch(int player, const MatchState& before); // player (0 or 1) was touched on the newest tick, from before
+    MatchState annul(); // The match to resume from: before the touch, fencers halted; drops the ticks since
+    uint32_t size() const;  // Ticks that can be shown
+    const MatchState& at(uint32_t back) const; // back ticks before the newest, below size()
+
+    MatchState states[REVIEW_TICKS]; // Tick t at t % REVIEW_TICKS
+    uint32_t count = 0;              // Ticks recorded this bout, less those an annul dropped
+    uint32_t valid = 0;              // Newest ticks still held, at most REVIEW_TICKS
+    int loser = -1;                  // Whose point is under review; -1 once called, out of the ring, or if none was taken
+    uint32_t touchCount = 0;         // count when it was taken
+    MatchState beforeTouch;          // The match before the tick of the touch
+};
+
+enum ReviewCall { REVIEW_NONE, REVIEW_CONFIRMED, REVIEW_ANNULLED, REVIEW_QUIT };
+
+// Runs until the referee resumes (REVIEW_NONE when no call was made) or closes the window, showing
+// match's clock and the global points meanwhile. After REVIEW_ANNULLED the caller resumes from annul().
+ReviewCall runReview(INITSDL& app, SDL_Texture* background, Character& player1, Character& player2, ReviewRing& ring,
+                     const MatchState& match);
+
+#endif // REVIEW_H
@@ -0,0 +1,457 @@
+#include "sandbox.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#ifndef _WIN32
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <climits>
+#include <cstddef>
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/futex.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
+using SandboxClock = std::chrono::steady_clock;
+
+bool HostedBot::load(const std::string& path, int player, std::string& error) {
+    bool isTree = path.size() > 3 && path.compare(path.size() - 3, 3, ".bt") == 0;
+    if (isTree) {
+        if (!tree.load(path, error)) return false;
+        sparring = std::make_unique<BtBot>(tree, player);
+    } else {
+        if (!program.load(path, player, error)) return false;
+        script = std::make_unique<ScriptBot>(program, player);
+        script->model = &model;
+    }
+    return true;
+}
+
+InputWord HostedBot::update(const MatchState& state) {
+    model.watch(state);
+    return script ? script->update(state) : sparring->update(state);
+}
+
+void HostedBot::reset() {
+    if (script) script->reset();
+    if (sparring) sparring->reset();
+    model.startBout();
+}
+
+#ifdef _WIN32
+
+bool BotSandbox::start(const std::string& path, int player) {
+    this->path = path;
+    this->player = player;
+    error = "bot processes are not supported on Windows";
+    return false;
+}
+
+void BotSandbox::stop() {}
+void BotSandbox::reset() {}
+void BotSandbox::killChild() {}
+void BotSandbox::pauseChild(bool) {}
+InputWord BotSandbox::update(const MatchState&) { return 0; }
+
+int runBotHost(int, char*[]) {
+    std::fprintf(stderr, "bot processes are not supported on Windows\n");
+    return 1;
+}
+
+#else
+
+#ifdef __linux__
+// Shared (not FUTEX_PRIVATE) operations: the words live in memory mapped into both processes
+static void futexWait(std::atomic<uint32_t>& word, uint32_t expected, const timespec* timeout) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+static void futexWake(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+#else
+// Without futexes the sleeper polls in short naps and a wake is not needed
+static void futexWait(std::atomic<uint32_t>& word, uint32_t expected, const timespec*) {
+    if (word.load() == expected) usleep(50);
+}
+
+static void futexWake(std::atomic<uint32_t>&) {}
+#endif
+
+// Spin before sleeping only with a core to spare: on a single core spinning only delays the other side
+static int spinMicros() {
+    static const int micros = std::thread::hardware_concurrency() > 1 ? SANDBOX_SPIN_MICROS : 0;
+    return micros;
+}
+
+// Returns the word once it differs from seen, or seen at the deadline (none waits for ever). Spins
+// first: a child that keeps up answers within the spin. waiting is raised while asleep, so the other
+// side only pays for a wake-up when one is needed.
+static uint32_t waitChange(std::atomic<uint32_t>& word, uint32_t seen, std::atomic<uint32_t>& waiting,
+                           const SandboxClock::time_point* deadline) {
+    auto spinEnd = SandboxClock::now() + std::chrono::microseconds(spinMicros());
+    uint32_t value;
+    while ((value = word.load(std::memory_order_acquire)) == seen) {
+        auto now = SandboxClock::now();
+        if (deadline && now >= *deadline) return seen;
+        if (now < spinEnd) continue;
+
+        waiting.store(1);
+        if (word.load() == seen) {
+            timespec timeout;
+            if (deadline) {
+                auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline - now).count();
+                timeout.tv_sec = static_cast<time_t>(nanos / 1000000000);
+                timeout.tv_nsec = static_cast<long>(nanos % 1000000000);
+            }
+            futexWait(word, seen, deadline ? &timeout : nullptr);
+        }
+        waiting.store(0);
+    }
+    return value;
+}
+
+// Caps what a runaway bot can take: memory, descriptors, file writes and core dumps
+static void limitHost() {
+    const struct {
+        int resource;
+        rlim_t limit;
+    } limits[] = {
+        {RLIMIT_AS, SANDBOX_MEMORY_BYTES},
+        {RLIMIT_NOFILE, SANDBOX_MAX_FILES},
+        {RLIMIT_FSIZE, 0},
+        {RLIMIT_CORE, 0},
+    };
+    for (const auto& entry : limits) {
+        rlimit limit = {entry.limit, entry.limit};
+        setrlimit(entry.resource, &limit);
+    }
+}
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define SANDBOX_SECCOMP 1
+#if defined(__x86_64__)
+#define SANDBOX_AUDIT_ARCH AUDIT_ARCH_X86_64
+#else
+#define SANDBOX_AUDIT_ARCH AUDIT_ARCH_AARCH64
+#endif
+
+// Once the bot is loaded the host only answers requests: it waits and wakes on futexes and allocates.
+// Any other system call (opening files, sockets, exec, fork) kills it, and the game restarts it.
+static bool allowAnswersOnly() {
+    static const long allowed[] = {
+        __NR_futex, __NR_mmap, __NR_munmap, __NR_mremap, __NR_brk, __NR_madvise, __NR_clock_gettime,
+        __NR_clock_nanosleep, __NR_nanosleep, __NR_sched_yield, __NR_getrandom, __NR_rt_sigreturn,
+        __NR_exit, __NR_exit_group,
+    };
+    const unsigned count = sizeof(allowed) / sizeof(allowed[0]);
+    sock_filter filter[4 + 2 * count + 1];
+    unsigned n = 0;
+    filter[n++] = BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, arch));
+    filter[n++] = BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SANDBOX_AUDIT_ARCH, 1, 0);
+    filter[n++] = BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS);
+    filter[n++] = BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, nr));
+    for (long call : allowed) {
+        filter[n++] = BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(call), 0, 1);
+        filter[n++] = BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW);
+    }
+    filter[n++] = BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS);
+    sock_fprog program = {static_cast<unsigned short>(n), filter};
+    return prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0 && prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program) == 0;
+}
+#endif
+
+static void hostFailed(SandboxChannel* channel, const std::string& error) {
+    std::snprintf(channel->error, sizeof(channel->error), "%s", error.c_str());
+    channel->state.store(SANDBOX_FAILED);
+    futexWake(channel->state);
+    _exit(1);
+}
+
+// The host: confines itself, loads the bot, then answers the newest request until killed. A request
+// overwritten while it was being read is skipped, as are ticks the host fell behind on.
+int runBotHost(int argc, char* argv[]) {
+    if (argc != 5) {
+        std::fprintf(stderr, "usage: %s <channel fd> <player> <game pid> <bot file>\n", argv[0]);
+        return 2;
+    }
+    int fd = std::atoi(argv[1]);
+    int player = std::atoi(argv[2]) == 0 ? 0 : 1;
+    pid_t parent = static_cast<pid_t>(std::atol(argv[3]));
+    std::string path = argv[4];
+#ifdef __linux__
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+    if (getppid() != parent) return 0; // The game exited before the host got this far
+
+    void* memory = mmap(nullptr, sizeof(SandboxChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        std::fprintf(stderr, "%s: cannot map the channel\n", argv[0]);
+        return 1;
+    }
+    SandboxChannel* channel = static_cast<SandboxChannel*>(memory); // Constructed by the game
+    long openMax = sysconf(_SC_OPEN_MAX);
+    for (int other = 3; other < (openMax > 0 && openMax < 65536 ? openMax : 65536); other++) {
+        if (other != fd) close(other);
+    }
+    limitHost();
+
+    HostedBot bot(player);
+    std::string error;
+    if (!bot.load(path, player, error)) hostFailed(channel, error);
+#ifdef SANDBOX_SECCOMP
+    spinMicros(); // Counts the cores now: the filter refuses the files that come from
+    if (!allowAnswersOnly()) hostFailed(channel, "cannot install the system call filter");
+#endif
+    channel->state.store(SANDBOX_READY);
+    futexWake(channel->state);
+
+    uint32_t seen = 0;
+    uint32_t bout = UINT32_MAX;
+    while (true) {
+        uint32_t request = waitChange(channel->requestSeq, seen, channel->childWaiting, nullptr);
+        seen = request;
+        SandboxSlot& slot = channel->slots[request % SANDBOX_RING];
+        MatchState state = slot.state;
+        uint32_t slotBout = slot.bout;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (channel->requestSeq.load() - request >= SANDBOX_RING - 1) continue; // The game may be rewriting the slot
+
+        if (slotBout != bout) {
+            bot.reset();
+            bout = slotBout;
+        }
+        slot.input = bot.update(state);
+        channel->responseSeq.store(request, std::memory_order_release);
+        if (channel->gameWaiting.load()) futexWake(channel->responseSeq);
+    }
+}
+
+// FencingBotHost in the running executable's directory, or on the PATH where that cannot be found
+static std::string defaultHostPath() {
+#ifdef __linux__
+    char self[4096];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length > 0) {
+        std::string exe(self, static_cast<size_t>(length));
+        size_t slash = exe.rfind('/');
+        if (slash != std::string::npos) return exe.substr(0, slash + 1) + SANDBOX_HOST;
+    }
+#endif
+    return SANDBOX_HOST;
+}
+
+// An unnamed file of shared memory the host inherits across exec
+static int createChannelFile() {
+#ifdef __linux__
+    return memfd_create("fencing-sandbox", MFD_CLOEXEC);
+#else
+    static std::atomic<unsigned> counter{0};
+    std::string name = "/fencing-sandbox-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+        shm_unlink(name.c_str());
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+#endif
+}
+
+bool BotSandbox::start(const std::string& path, int player) {
+    stop();
+    this->path = path;
+    this->player = player;
+    if (hostPath.empty()) hostPath = defaultHostPath();
+    channelFd = createChannelFile();
+    if (channelFd < 0 || ftruncate(channelFd, sizeof(SandboxChannel)) != 0) {
+        error = "cannot create shared memory";
+        stop();
+        return false;
+    }
+    void* memory = mmap(nullptr, sizeof(SandboxChannel), PROT_READ | PROT_WRITE, MAP_SHARED, channelFd, 0);
+    if (memory == MAP_FAILED) {
+        error = "cannot map shared memory";
+        stop();
+        return false;
+    }
+    channel = new (memory) SandboxChannel();
+    if (!spawn()) {
+        stop();
+        return false;
+    }
+    error.clear();
+    return true;
+}
+
+void BotSandbox::stop() {
+    if (restarter.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(restartMutex);
+            quitting = true;
+        }
+        restartWake.notify_one();
+        restarter.join();
+        quitting = false;
+        restartWanted = false;
+    }
+    restarting.store(false);
+    if (pid > 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        pid = -1;
+    }
+    if (channel) {
+        channel->~SandboxChannel();
+        munmap(channel, sizeof(SandboxChannel));
+        channel = nullptr;
+    }
+    if (channelFd >= 0) {
+        close(channelFd);
+        channelFd = -1;
+    }
+}
+
+// Starts a fresh host on the channel and waits until it has loaded the bot. Everything the child
+// needs is built before the fork: between fork and exec it only moves the channel and execs.
+bool BotSandbox::spawn() {
+    channel->requestSeq.store(0);
+    channel->responseSeq.store(0);
+    channel->childWaiting.store(0);
+    channel->gameWaiting.store(0);
+    channel->state.store(SANDBOX_STARTING);
+    channel->error[0] = '\0';
+    seq = 0;
+
+    std::string fdArg = std::to_string(SANDBOX_CHANNEL_FD);
+    std::string playerArg = std::to_string(player);
+    std::string parentArg = std::to_string(getpid());
+    char* args[] = {const_cast<char*>(hostPath.c_str()), &fdArg[0], &playerArg[0], &parentArg[0],
+                    const_cast<char*>(path.c_str()), nullptr};
+    pid_t child = fork();
+    if (child < 0) {
+        error = "cannot fork";
+        return false;
+    }
+    if (child == 0) {
+        // dup2 onto the same number keeps close-on-exec, so that case clears it instead
+        if (channelFd == SANDBOX_CHANNEL_FD ? fcntl(channelFd, F_SETFD, 0) < 0 : dup2(channelFd, SANDBOX_CHANNEL_FD) < 0) _exit(127);
+        execvp(args[0], args);
+        _exit(127);
+    }
+    pid = child;
+
+    auto deadline = SandboxClock::now() + std::chrono::milliseconds(SANDBOX_START_MILLIS);
+    while (channel->state.load() == SANDBOX_STARTING && SandboxClock::now() < deadline && childAlive()) {
+        timespec nap = {0, 1000000};
+        futexWait(channel->state, SANDBOX_STARTING, &nap);
+    }
+    if (channel->state.load() != SANDBOX_READY) {
+        error = channel->error[0] ? std::string(channel->error) : "the bot process (" + hostPath + ") did not start";
+        if (pid > 0) {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            pid = -1;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool BotSandbox::childAlive() {
+    if (pid <= 0) return false;
+    if (waitpid(pid, nullptr, WNOHANG) == 0) return true;
+    pid = -1;
+    return false;
+}
+
+void BotSandbox::restartLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(restartMutex);
+            restartWake.wait(lock, [this] { return restartWanted || quitting; });
+            if (quitting) return;
+            restartWanted = false;
+        }
+        if (!spawn()) pid = -1; // Gives up: neutral input from now on
+        restarting.store(false, std::memory_order_release);
+    }
+}
+
+void BotSandbox::reset() {
+    bout++;
+}
+
+void BotSandbox::killChild() {
+    if (!restarting.load(std::memory_order_acquire) && pid > 0) kill(pid, SIGKILL);
+}
+
+void BotSandbox::pauseChild(bool paused) {
+    if (!restarting.load(std::memory_order_acquire) && pid > 0) kill(pid, paused ? SIGSTOP : SIGCONT);
+}
+
+InputWord BotSandbox::update(const MatchState& state) {
+    if (!channel) return 0;
+    if (restarting.load(std::memory_order_acquire)) {
+        requests++;
+        misses++;
+        return 0; // Neutral while the new child loads its bot
+    }
+    if (pid <= 0) return 0;
+    requests++;
+    auto start = SandboxClock::now();
+
+    // A child still on an older request is hung, crashed or slow: it gets the new state to catch up
+    // on, but the tick does not wait for it
+    bool keepingUp = channel->responseSeq.load(std::memory_order_acquire) == seq;
+    uint32_t request = ++seq;
+    SandboxSlot& slot = channel->slots[request % SANDBOX_RING];
+    slot.state = state;
+    slot.bout = bout;
+    channel->requestSeq.store(request);
+    if (channel->childWaiting.load()) futexWake(channel->requestSeq);
+
+    uint32_t answered = request - 1;
+    if (keepingUp) {
+        auto deadline = start + std::chrono::microseconds(deadlineMicros);
+        while (answered != request && SandboxClock::now() < deadline) {
+            answered = waitChange(channel->responseSeq, answered, channel->gameWaiting, &deadline);
+        }
+    }
+    if (answered != request) {
+        misses++;
+        if (++behindTicks >= SANDBOX_HANG_TICKS && childAlive()) {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            pid = 0; // Reaped; restarted below like a crash
+        }
+        if (!childAlive() && restarts < SANDBOX_MAX_RESTARTS) {
+            behindTicks = 0;
+            restarts++;
+            restarting.store(true);
+            if (!restarter.joinable()) restarter = std::thread(&BotSandbox::restartLoop, this);
+            {
+                std::lock_guard<std::mutex> lock(restartMutex);
+                restartWanted = true;
+            }
+            restartWake.notify_one();
+        }
+        return 0; // Neutral: every key released
+    }
+
+    behindTicks = 0;
+    lastRoundTripNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(SandboxClock::now() - start).count();
+    return slot.input;
+}
+
+#endif
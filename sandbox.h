@@ -0,0 +1,129 @@
+// Out-of-process bots: a script or behavior-tree bot runs in its own process, FencingBotHost (built
+// next to the game from bothost.cpp), so a bot that crashes or hangs cannot take the game down with
+// it. The game forks and at once execs the host, handing it the shared-memory channel as an inherited
+// descriptor; nothing of the game's threads or state survives into the child. Before it loads the bot
+// the host closes every other descriptor and caps its memory, files and core dumps (rlimits); on
+// Linux it then allows itself only the system calls answering needs (seccomp).
+// Every tick the game writes the match state into a ring in shared memory and wakes the child through
+// a futex; the child answers with its keys in the same ring. A watchdog plays the neutral input (no
+// keys) for any tick the child does not answer within the deadline, stops waiting on a child that is
+// still behind, and restarts one that died or stayed silent for a second. Restarts run on a thread of
+// their own, kept for the sandbox's life since a child dies with the thread that started it; the tick
+// never waits for a bot to load and plays neutral until the new child is ready.
+// Both sides spin briefly before sleeping, so a round trip costs a few microseconds when the child
+// keeps up. Linux uses futexes; other POSIX systems poll, and Windows has no sandbox.
+#ifndef SANDBOX_H
+#define SANDBOX_H
+
+#include "simulation.h"
+#include "behaviortree.h"
+#include "botscript.h"
+#include "opponentmodel.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#define SANDBOX_RING 8                 // Requests in flight; a slot is rewritten this many ticks later
+#define SANDBOX_DEADLINE_MICROS 1000   // Default wait per tick before the neutral input is played
+#define SANDBOX_SPIN_MICROS 20         // Busy-wait before sleeping on the futex, on both sides
+#define SANDBOX_MAX_RESTARTS 3         // Child crashes tolerated before the bot only plays neutral
+#define SANDBOX_HANG_TICKS 60          // Ticks without an answer before a live child is killed and restarted
+#define SANDBOX_START_MILLIS 2000      // Time for the child to load its bot
+#define SANDBOX_HOST "FencingBotHost"  // Looked for next to the running executable
+#define SANDBOX_CHANNEL_FD 3           // The channel's descriptor in the host
+#define SANDBOX_MEMORY_BYTES (256u << 20) // Address-space cap of the host
+#define SANDBOX_MAX_FILES 16           // Descriptor cap of the host; it writes no files at all
+
+static_assert(std::is_trivially_copyable<MatchState>::value, "MatchState is copied through shared memory");
+
+// A script (.bot) or behavior tree (.bt) with its own opponent model, as the child runs it
+struct HostedBot {
+    ScriptProgram program;
+    BehaviorTree tree;
+    std::unique_ptr<ScriptBot> script;
+    std::unique_ptr<BtBot> sparring;
+    OpponentModel model;
+
+    explicit HostedBot(int player) : model(1 - player) {}
+
+    bool load(const std::string& path, int player, std::string& error);
+    InputWord update(const MatchState& state); // Call once per tick
+    void reset();
+};
+
+struct SandboxSlot {
+    MatchState state;
+    uint32_t bout;                     // The child resets its bot when this changes
+    InputWord input;                   // The child's answer
+};
+
+// Lives in an anonymous shared-memory file mapped by both processes; the sequence numbers are the futex words
+struct SandboxChannel {
+    std::atomic<uint32_t> requestSeq{0};   // Last request written by the game
+    std::atomic<uint32_t> responseSeq{0};  // Last request answered by the child
+    std::atomic<uint32_t> childWaiting{0}; // Set while the child sleeps, so the game only wakes it then
+    std::atomic<uint32_t> gameWaiting{0};
+    std::atomic<uint32_t> state{0};        // SandboxChildState
+    char error[128] = {};                  // Why the child failed to start
+    SandboxSlot slots[SANDBOX_RING];
+};
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Futex words must be plain 32-bit integers");
+
+enum SandboxChildState : uint32_t {
+    SANDBOX_STARTING,
+    SANDBOX_READY,
+    SANDBOX_FAILED
+};
+
+struct BotSandbox {
+    std::string path;
+    int player = 1;
+    int deadlineMicros = SANDBOX_DEADLINE_MICROS;
+    std::string error;
+    uint64_t requests = 0;
+    uint64_t misses = 0;               // Ticks played with the neutral input
+    uint64_t restarts = 0;
+    int64_t lastRoundTripNanos = 0;    // Of the last answered request
+
+    std::string hostPath;              // FencingBotHost; empty looks next to the running executable
+
+    BotSandbox() = default;
+    BotSandbox(const BotSandbox&) = delete;
+    BotSandbox& operator=(const BotSandbox&) = delete;
+    ~BotSandbox() { stop(); }
+
+    bool start(const std::string& path, int player); // Fails with error set if the child cannot load the bot
+    void stop();
+    InputWord update(const MatchState& state); // Call once per tick; never waits past the deadline or for a restart
+    void reset();                              // New bout: the child resets its bot on the next request
+    // Fault drills for the lab: kill the child, or stop and resume it to stand in for a hang
+    void killChild();
+    void pauseChild(bool paused);
+
+private:
+    SandboxChannel* channel = nullptr;
+    int channelFd = -1;
+    int pid = -1;                      // Written by the restarter while it runs
+    uint32_t seq = 0;
+    uint32_t bout = 0;
+    int behindTicks = 0;
+    std::thread restarter;             // Started with the first restart
+    std::mutex restartMutex;
+    std::condition_variable restartWake;
+    bool restartWanted = false;
+    bool quitting = false;
+    std::atomic<bool> restarting{false}; // The restarter owns pid and the channel while set
+
+    bool spawn();
+    bool childAlive();
+    void restartLoop();
+};
+
+// FencingBotHost's main: FencingBotHost <channel fd> <player> <game pid> <bot file>
+int runBotHost(int argc, char* argv[]);
+
+#endif // SANDBOX_H
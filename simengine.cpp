@@ -0,0 +1,62 @@
+#include "simengine.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+bool SimEngine::open(const std::string& path) {
+    close();
+    this->path = path;
+    SimAbiFunction abi = nullptr;
+
+#ifdef _WIN32
+    HMODULE module = LoadLibraryA(path.c_str());
+    if (!module) {
+        error = "cannot load";
+        return false;
+    }
+    handle = module;
+    abi = reinterpret_cast<SimAbiFunction>(GetProcAddress(module, "fencing_sim_abi"));
+    step = reinterpret_cast<SimStepFunction>(GetProcAddress(module, "fencing_sim_step"));
+#else
+    // RTLD_LOCAL, as for bot plugins: the engine's simulation must not interpose on this build's
+    handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        const char* reason = dlerror();
+        error = reason ? reason : "cannot load";
+        return false;
+    }
+    abi = reinterpret_cast<SimAbiFunction>(dlsym(handle, "fencing_sim_abi"));
+    step = reinterpret_cast<SimStepFunction>(dlsym(handle, "fencing_sim_step"));
+#endif
+
+    if (!abi || !step) {
+        error = "missing fencing_sim_abi or fencing_sim_step";
+        close();
+        return false;
+    }
+    if (abi() != FENCING_SIM_ABI) {
+        error = "built with another MatchState (ABI " + std::to_string(abi()) + ", this build " + std::to_string(FENCING_SIM_ABI) + ")";
+        close();
+        return false;
+    }
+    error.clear();
+    return true;
+}
+
+void SimEngine::close() {
+    if (handle) {
+#ifdef _WIN32
+        FreeLibrary(static_cast<HMODULE>(handle));
+#else
+        dlclose(handle);
+#endif
+        handle = nullptr;
+    }
+    step = nullptr;
+}
+
+uint8_t stepThisBuild(MatchState* state, InputWord player1Input, InputWord player2Input) {
+    return stepMatch(*state, player1Input, player2Input);
+}
@@ -0,0 +1,42 @@
+// Match rules of another build, loaded from a shared object, so two builds can re-simulate the same
+// keys side by side in one process (FencingLab bisect --engine). The fencingsim target builds the
+// object from simexport.cpp and that checkout's simulation.cpp; it exports two C functions:
+//   uint32_t fencing_sim_abi()                                                 FENCING_SIM_ABI
+//   uint8_t fencing_sim_step(MatchState* state, InputWord p1, InputWord p2)  its stepMatch
+// States are compared byte for byte, so a build whose MatchState has another layout is refused.
+#ifndef SIMENGINE_H
+#define SIMENGINE_H
+
+#include "botplugin.h" // FENCING_PLUGIN_EXPORT
+#include "simulation.h"
+#include <string>
+
+// Bumped with any change to the meaning of MatchState's fields that keeps its size
+#define FENCING_SIM_VERSION 1
+#define FENCING_SIM_ABI ((FENCING_SIM_VERSION << 16) | static_cast<uint32_t>(sizeof(MatchState)))
+
+typedef uint32_t (*SimAbiFunction)();
+typedef uint8_t (*SimStepFunction)(MatchState* state, InputWord player1Input, InputWord player2Input);
+
+struct SimEngine {
+    std::string path;
+    std::string error;
+    SimStepFunction step = nullptr;
+
+    SimEngine() = default;
+    SimEngine(const SimEngine&) = delete;
+    SimEngine& operator=(const SimEngine&) = delete;
+    ~SimEngine() { close(); }
+
+    // Fails with error set if the file or an entry point is missing or the ABI differs
+    bool open(const std::string& path);
+    void close();
+
+private:
+    void* handle = nullptr;
+};
+
+// stepMatch of this build, with the engine entry point's signature
+uint8_t stepThisBuild(MatchState* state, InputWord player1Input, InputWord player2Input);
+
+#endif // SIMENGINE_H
@@ -0,0 +1,11 @@
+// The match rules of this checkout as a loadable engine (see simengine.h). Build the fencingsim target
+// in the checkout to compare against, then pass the object to FencingLab bisect --engine.
+#include "simengine.h"
+
+FENCING_PLUGIN_EXPORT uint32_t fencing_sim_abi() {
+    return FENCING_SIM_ABI;
+}
+
+FENCING_PLUGIN_EXPORT uint8_t fencing_sim_step(MatchState* state, InputWord player1Input, InputWord player2Input) {
+    return stepMatch(*state, player1Input, player2Input);
+}
@@ -0,0 +1,451 @@
+#include "simulation.h"
+#include <cstring>
+
+const char* const ACTION_NAMES[ACTION_COUNT] = {
+    "idle", "attack", "parry_low", "parry_high", "parry_mid", "strike_lowhigh", "strike_highlow"
+};
+
+const char* const WEAPON_NAMES[WEAPON_COUNT] = {"Epee", "Sabre"};
+
+const char* const INPUT_NAMES[INPUT_SYMBOLS] = {"up", "down", "left", "right", "attack"};
+
+const char* const MOVE_NAMES[MOVE_COUNT] = {
+    "hold", "advance", "retreat", "attack", "parry_low", "parry_high", "parry_mid", "strike_lowhigh", "strike_highlow"
+};
+
+// Commands per player, back being left for player 1 and right for player 2. The first match wins, so
+// the three-key parries are tried before the two-key commands they contain.
+const SimCommand SIM_COMMANDS[2][5] = {
+    {
+        {ACTION_PARRY_LOW, INPUT_UP | INPUT_LEFT | INPUT_ATTACK},    // Up, Back, Attack
+        {ACTION_PARRY_HIGH, INPUT_DOWN | INPUT_LEFT | INPUT_ATTACK}, // Down, Back, Attack
+        {ACTION_PARRY_MID, INPUT_LEFT | INPUT_ATTACK},               // Back, Attack
+        {ACTION_STRIKE_LOWHIGH, INPUT_DOWN | INPUT_ATTACK},
+        {ACTION_STRIKE_HIGHLOW, INPUT_UP | INPUT_ATTACK},
+    },
+    {
+        {ACTION_PARRY_LOW, INPUT_UP | INPUT_RIGHT | INPUT_ATTACK},    // Up, Forward, Attack
+        {ACTION_PARRY_HIGH, INPUT_DOWN | INPUT_RIGHT | INPUT_ATTACK}, // Down, Forward, Attack
+        {ACTION_PARRY_MID, INPUT_RIGHT | INPUT_ATTACK},               // Forward, Attack
+        {ACTION_STRIKE_LOWHIGH, INPUT_DOWN | INPUT_ATTACK},
+        {ACTION_STRIKE_HIGHLOW, INPUT_UP | INPUT_ATTACK},
+    },
+};
+
+void initMatch(MatchState& state, uint8_t weapon) {
+    state = MatchState();
+    state.weapon = weapon;
+    resetFencers(state);
+}
+
+// Both fencers back on guard at their start marks, as after a touch
+void resetFencers(MatchState& state) {
+    for (int i = 0; i < 2; ++i) {
+        FencerState& fencer = state.fencers[i];
+        fencer.x = i == 0 ? SIM_START_X1 : SIM_START_X2;
+        fencer.velocityX = 0;
+        fencer.action = ACTION_IDLE;
+        fencer.actionTicks = 0;
+    }
+}
+
+// Place both fencers around the centre of the piste with the given gap between their hurtboxes
+void placeFencers(MatchState& state, int distance) {
+    if (distance < 0) distance = 0;
+    if (distance > SIM_MAX_X) distance = SIM_MAX_X;
+    state.fencers[0].x = (SIM_MAX_X - distance) / 2;
+    state.fencers[1].x = state.fencers[0].x + distance;
+}
+
+// Gap between the two hurtboxes, negative once they overlap
+int fencerDistance(const MatchState& state) {
+    SimRect left = fencerHurtbox(state, 0);
+    SimRect right = fencerHurtbox(state, 1);
+    return right.x - (left.x + left.w);
+}
+
+// The body, 150 wide, at the back half of the sprite for player 1 and the front half for player 2
+SimRect hurtboxAt(int x, int y, int player, uint8_t weapon) {
+    int offset = player == 0 ? SIM_SPRITE_SIZE / 4 - 75 : SIM_SPRITE_SIZE * 3 / 4 - 75;
+    if (weapon == WEAPON_SABRE) {
+        // Sabre hurtbox: half the height, same width, higher on the Y-axis
+        return {x + offset, y + (SIM_SPRITE_SIZE - 150) / 2 - 25, 150, 150};
+    }
+    return {x + offset, y + (SIM_SPRITE_SIZE - 200) / 2, 150, 200};
+}
+
+// Empty when the action has none. A hitbox is live for the whole action, not only its first frames: an
+// attack still touches a fencer who walks into it late in the second.
+SimRect hitboxAt(uint8_t action, int actionTicks, int x, int y, int player) {
+    bool secondFrame = actionTicks >= SIM_STRIKE_FRAME_TICKS;
+
+    switch (action) {
+    case ACTION_ATTACK:
+        // The 50 pixels in front of the hurtbox, the same reach for both sides
+        return player == 0 ? SimRect{x + 150, y + 100, 50, 50} : SimRect{x + 100, y + 100, 50, 50};
+    case ACTION_STRIKE_LOWHIGH:
+        // Frame 1 covers the lower half of the texture, frame 2 is centred vertically
+        return secondFrame ? SimRect{x, y + SIM_SPRITE_SIZE / 4, SIM_SPRITE_SIZE, SIM_SPRITE_SIZE / 2}
+                           : SimRect{x, y + SIM_SPRITE_SIZE / 2, SIM_SPRITE_SIZE, SIM_SPRITE_SIZE / 2};
+    case ACTION_STRIKE_HIGHLOW:
+        return secondFrame ? SimRect{x, y + SIM_SPRITE_SIZE / 2, SIM_SPRITE_SIZE, SIM_SPRITE_SIZE / 2}
+                           : SimRect{x, y + SIM_SPRITE_SIZE / 4, SIM_SPRITE_SIZE, SIM_SPRITE_SIZE / 2};
+    default:
+        return {0, 0, 0, 0};
+    }
+}
+
+// The box a parry covers, in front of the fencer; empty for other actions
+SimRect parryBoxAt(uint8_t action, int x, int y, int player, uint8_t weapon) {
+    int size = PARRY_BOX_SIZE;
+    int front = player == 0 ? x + SIM_SPRITE_SIZE : x - size; // In front of the texture
+
+    switch (action) {
+    case ACTION_PARRY_LOW:
+        return {front, y + SIM_SPRITE_SIZE / 2, size, size}; // Lower half of the texture
+    case ACTION_PARRY_HIGH:
+        return {front, y, size, size}; // Upper half of the texture
+    case ACTION_PARRY_MID: {
+        // In front of the hurtbox, centred vertically
+        SimRect hurtbox = hurtboxAt(x, y, player, weapon);
+        int hurtboxFront = player == 0 ? hurtbox.x + hurtbox.w : hurtbox.x - size;
+        return {hurtboxFront, hurtbox.y + (hurtbox.h - size) / 2, size, size};
+    }
+    default:
+        return {0, 0, 0, 0};
+    }
+}
+
+SimRect fencerHurtbox(const MatchState& state, int player) {
+    return hurtboxAt(state.fencers[player].x, SIM_GROUND_Y, player, state.weapon);
+}
+
+SimRect fencerHitbox(const MatchState& state, int player) {
+    const FencerState& fencer = state.fencers[player];
+    return hitboxAt(fencer.action, fencer.actionTicks, fencer.x, SIM_GROUND_Y, player);
+}
+
+SimRect fencerParryBox(const MatchState& state, int player) {
+    const FencerState& fencer = state.fencers[player];
+    return parryBoxAt(fencer.action, fencer.x, SIM_GROUND_Y, player, state.weapon);
+}
+
+bool fencerParrying(const FencerState& fencer) {
+    return fencer.action == ACTION_PARRY_LOW || fencer.action == ACTION_PARRY_HIGH || fencer.action == ACTION_PARRY_MID;
+}
+
+// Same result as SDL_HasIntersection
+bool simIntersects(const SimRect& a, const SimRect& b) {
+    if (a.w <= 0 || a.h <= 0 || b.w <= 0 || b.h <= 0) return false;
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+static void startAction(FencerState& fencer, uint8_t action) {
+    fencer.action = action;
+    fencer.actionTicks = 0;
+}
+
+// Key presses go into the input history, where they are matched against the commands; held keys
+// drive walking. An action only starts from guard: presses during one start nothing, and the history
+// keeps them until they are too old, so the first press after the action can complete a command begun
+// during it.
+static void processFencerInput(FencerState& fencer, int player, InputWord input) {
+    InputWord pressed = input & ~fencer.held;
+    fencer.held = input;
+
+    // Age the input history and drop stale presses
+    uint8_t present = 0;
+    uint8_t oldest = 0;
+    for (int i = 0; i < INPUT_SYMBOLS; ++i) {
+        uint8_t& age = fencer.pressAge[i];
+        if (pressed & (1 << i)) {
+            age = 0;
+        } else if (age != SIM_NO_PRESS && ++age > SIM_INPUT_MAX_AGE_TICKS) {
+            age = SIM_NO_PRESS;
+        }
+        if (age != SIM_NO_PRESS) {
+            present |= 1 << i;
+            if (age > oldest) oldest = age;
+        }
+    }
+
+    if (pressed && fencer.action == ACTION_IDLE) {
+        if (oldest <= SIM_COMMAND_WINDOW_TICKS) {
+            for (const SimCommand& command : SIM_COMMANDS[player]) {
+                if ((present & command.required) == command.required) {
+                    startAction(fencer, command.action);
+                    memset(fencer.pressAge, SIM_NO_PRESS, sizeof(fencer.pressAge)); // Clear history on a match
+                    break;
+                }
+            }
+        }
+        if (fencer.action == ACTION_IDLE && (pressed & INPUT_ATTACK)) {
+            startAction(fencer, ACTION_ATTACK);
+        }
+    }
+
+    // Handle "left" input
+    if (input & INPUT_LEFT) {
+        fencer.velocityX = -SIM_WALK_SPEED;
+        fencer.leftFrames = 0;
+    } else if (fencer.leftFrames < SIM_RELEASE_FRAMES) {
+        fencer.leftFrames++;
+    } else if (!(input & INPUT_RIGHT)) {
+        fencer.velocityX = 0;
+    }
+
+    // Handle "right" input
+    if (input & INPUT_RIGHT) {
+        fencer.velocityX = SIM_WALK_SPEED;
+        fencer.rightFrames = 0;
+    } else if (fencer.rightFrames < SIM_RELEASE_FRAMES) {
+        fencer.rightFrames++;
+    } else if (!(input & INPUT_LEFT)) {
+        fencer.velocityX = 0;
+    }
+}
+
+// Stop when the next hurtbox would run into the opponent; the whole sprite stays on screen
+static void moveFencer(MatchState& state, int player) {
+    FencerState& fencer = state.fencers[player];
+    if (fencer.velocityX == 0) return;
+
+    SimRect next = hurtboxAt(fencer.x + fencer.velocityX, SIM_GROUND_Y, player, state.weapon);
+    SimRect other = fencerHurtbox(state, 1 - player);
+    if (simIntersects(next, other) && (fencer.velocityX > 0) == (next.x < other.x)) {
+        fencer.velocityX = 0;
+        return;
+    }
+
+    int x = fencer.x + fencer.velocityX;
+    if (x < 0) x = 0;
+    if (x > SIM_MAX_X) x = SIM_MAX_X;
+    fencer.x = static_cast<int16_t>(x);
+}
+
+static void advanceAction(FencerState& fencer) {
+    if (fencer.action != ACTION_IDLE && ++fencer.actionTicks >= SIM_ACTION_TICKS) {
+        startAction(fencer, ACTION_IDLE);
+    }
+}
+
+// The touched player loses a point and both fencers go back on guard with the period clock restarted
+static void awardTouch(MatchState& state, int loser) {
+    state.points[loser]--;
+    resetFencers(state);
+    state.periodTicks = 0;
+}
+
+uint8_t stepMatch(MatchState& state, InputWord player1Input, InputWord player2Input) {
+    if (state.over) return 0;
+    uint8_t events = 0;
+
+    processFencerInput(state.fencers[0], 0, player1Input);
+    processFencerInput(state.fencers[1], 1, player2Input);
+
+    // Touches are checked before movement, player 1 first
+    if (simIntersects(fencerHitbox(state, 0), fencerHurtbox(state, 1))) {
+        if (!fencerParrying(state.fencers[1])) {
+            events |= EVENT_TOUCH_P1;
+            awardTouch(state, 1);
+        } else {
+            events |= EVENT_PARRY_P2;
+        }
+    } else if (simIntersects(fencerHitbox(state, 1), fencerHurtbox(state, 0))) {
+        if (!fencerParrying(state.fencers[0])) {
+            events |= EVENT_TOUCH_P2;
+            awardTouch(state, 0);
+        } else {
+            events |= EVENT_PARRY_P1;
+        }
+    }
+
+    if (!(events & (EVENT_TOUCH_P1 | EVENT_TOUCH_P2))) {
+        moveFencer(state, 0);
+        moveFencer(state, 1);
+        advanceAction(state.fencers[0]);
+        advanceAction(state.fencers[1]);
+    }
+
+    state.tick++;
+    state.periodTicks++;
+
+    // Three periods; level after the last, the next touch wins (sudden death)
+    if (state.points[0] <= 0 || state.points[1] <= 0) {
+        state.over = true;
+    } else if (state.periodTicks >= SIM_PERIOD_TICKS && !state.suddenDeath) {
+        if (state.period < SIM_PERIODS) {
+            state.period++;
+            state.periodTicks = 0;
+            events |= EVENT_PERIOD;
+        } else if (state.points[0] == state.points[1]) {
+            state.suddenDeath = true; // Enter sudden-death mode
+        } else {
+            state.over = true;
+        }
+    } else if (state.suddenDeath && state.points[0] != state.points[1]) {
+        state.over = true; // A touch in sudden death ends the bout
+    }
+
+    if (state.over) events |= EVENT_GAME_OVER;
+    return events;
+}
+
+// 1 or 2 for the player with more points left, 0 for a draw
+int matchWinner(const MatchState& state) {
+    if (state.points[0] > state.points[1]) return 1;
+    if (state.points[1] > state.points[0]) return 2;
+    return 0;
+}
+
+static uint64_t mixHash(uint64_t hash, uint64_t value) {
+    // splitmix64 finaliser over the running hash
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    return hash ^ (hash >> 31);
+}
+
+static uint64_t packFencer(const FencerState& fencer) {
+    uint64_t packed = static_cast<uint16_t>(fencer.x);
+    packed |= static_cast<uint64_t>(static_cast<uint8_t>(fencer.velocityX)) << 16;
+    packed |= static_cast<uint64_t>(fencer.action) << 24;
+    packed |= static_cast<uint64_t>(fencer.actionTicks) << 32;
+    packed |= static_cast<uint64_t>(fencer.held) << 40;
+    packed |= static_cast<uint64_t>(fencer.leftFrames) << 48;
+    packed |= static_cast<uint64_t>(fencer.rightFrames) << 56;
+    return packed;
+}
+
+// Hash of everything that decides how the fencers play on from here, without the clocks and score
+uint64_t hashFencers(const MatchState& state) {
+    uint64_t hash = state.weapon;
+    for (const FencerState& fencer : state.fencers) {
+        hash = mixHash(hash, packFencer(fencer));
+        uint64_t ages = 0;
+        for (int i = 0; i < INPUT_SYMBOLS; ++i) {
+            ages |= static_cast<uint64_t>(fencer.pressAge[i]) << (8 * i);
+        }
+        hash = mixHash(hash, ages);
+    }
+    return hash;
+}
+
+// Hash of the full match state, used to compare runs tick by tick
+uint64_t hashMatchState(const MatchState& state) {
+    uint64_t hash = hashFencers(state);
+    hash = mixHash(hash, state.tick);
+    hash = mixHash(hash, static_cast<uint64_t>(state.periodTicks) | static_cast<uint64_t>(state.period) << 16);
+    hash = mixHash(hash, static_cast<uint64_t>(static_cast<uint8_t>(state.points[0])) |
+                         static_cast<uint64_t>(static_cast<uint8_t>(state.points[1])) << 8 |
+                         static_cast<uint64_t>(state.suddenDeath) << 16 |
+                         static_cast<uint64_t>(state.over) << 17);
+    return hash;
+}
+
+bool sameMatchState(const MatchState& a, const MatchState& b) {
+    for (int player = 0; player < 2; ++player) {
+        const FencerState& x = a.fencers[player];
+        const FencerState& y = b.fencers[player];
+        if (x.x != y.x || x.velocityX != y.velocityX || x.action != y.action || x.actionTicks != y.actionTicks ||
+            x.held != y.held || x.leftFrames != y.leftFrames || x.rightFrames != y.rightFrames) {
+            return false;
+        }
+        for (int symbol = 0; symbol < INPUT_SYMBOLS; ++symbol) {
+            if (x.pressAge[symbol] != y.pressAge[symbol]) return false;
+        }
+    }
+    return a.tick == b.tick && a.periodTicks == b.periodTicks && a.period == b.period && a.weapon == b.weapon &&
+           a.points[0] == b.points[0] && a.points[1] == b.points[1] && a.suddenDeath == b.suddenDeath && a.over == b.over;
+}
+
+// Independent seed for the index-th case of a run (splitmix64), so results do not depend on the thread count
+uint64_t seedFor(uint64_t baseSeed, uint64_t index) {
+    uint64_t seed = baseSeed + (index + 1) * 0x9e3779b97f4a7c15ULL;
+    seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebULL;
+    return seed ^ (seed >> 31);
+}
+
+InputWord forwardInput(int player) {
+    return player == 0 ? INPUT_RIGHT : INPUT_LEFT;
+}
+
+InputWord backInput(int player) {
+    return player == 0 ? INPUT_LEFT : INPUT_RIGHT;
+}
+
+// Key presses that start an action from idle. Attack is a single press; commands press their keys
+// one at a time on even ticks, releasing in between so each registers as a new press.
+InputWord commandInput(uint8_t action, int player, int tick) {
+    if (tick < 0 || tick % 2 != 0) return 0;
+    if (action == ACTION_ATTACK) return tick == 0 ? INPUT_ATTACK : 0;
+
+    for (const SimCommand& command : SIM_COMMANDS[player]) {
+        if (command.action != action) continue;
+        int press = tick / 2;
+        for (int i = 0; i < INPUT_SYMBOLS; ++i) {
+            if (!(command.required & (1 << i))) continue;
+            if (press-- == 0) return static_cast<InputWord>(1 << i);
+        }
+    }
+    return 0;
+}
+
+// Ticks from the first press of commandInput until the action starts
+int commandTicks(uint8_t action, int player) {
+    for (const SimCommand& command : SIM_COMMANDS[player]) {
+        if (command.action != action) continue;
+        int presses = 0;
+        for (int i = 0; i < INPUT_SYMBOLS; ++i) {
+            if (command.required & (1 << i)) presses++;
+        }
+        return 2 * (presses - 1);
+    }
+    return 0;
+}
+
+// Input for one tick of a macro move
+InputWord moveInput(int move, int player, int tick) {
+    switch (move) {
+    case MOVE_HOLD:
+        return 0;
+    case MOVE_ADVANCE:
+        return forwardInput(player);
+    case MOVE_RETREAT:
+        return backInput(player);
+    case MOVE_ATTACK:
+        return commandInput(ACTION_ATTACK, player, tick);
+    default:
+        return commandInput(static_cast<uint8_t>(ACTION_PARRY_LOW + (move - MOVE_PARRY_LOW)), player, tick);
+    }
+}
+
+InputWord MoveRunner::next(int wanted, const MatchState& state, int player) {
+    if (tick >= ticks || move < MOVE_ATTACK) {
+        if (wanted >= MOVE_ATTACK && state.fencers[player].action != ACTION_IDLE) wanted = MOVE_HOLD;
+        if (wanted != move || tick >= ticks) {
+            move = wanted;
+            tick = 0;
+            ticks = 1;
+            if (move > MOVE_ATTACK) ticks += commandTicks(static_cast<uint8_t>(ACTION_PARRY_LOW + move - MOVE_PARRY_LOW), player);
+        }
+    }
+    return moveInput(move, player, tick++);
+}
+
+int actionFromName(const char* name) {
+    for (int i = 0; i < ACTION_COUNT; ++i) {
+        if (strcmp(ACTION_NAMES[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+int weaponFromName(const char* name) {
+    for (int i = 0; i < WEAPON_COUNT; ++i) {
+        if (strcmp(WEAPON_NAMES[i], name) == 0) return i;
+    }
+    return -1;
+}
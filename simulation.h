@@ -0,0 +1,184 @@
+// Headless, tick-based model of a bout: action timings, hitboxes, touches and periods, without SDL.
+// The game plays its bouts on it (main.cpp steps it once a frame and draws the fencers from it), so
+// tools and bots copy and step exactly the match that is played. One tick is one frame at 60 FPS.
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Declare constants
+#define SCREEN_WIDTH 854
+#define SCREEN_HEIGHT 480
+
+// Action timings
+#define ACTION_DURATION_MS 1000         // Every action returns to idle after this long
+#define STRIKE_FRAME_MS 500             // Strikes switch to their second frame after this long
+#define COMMAND_WINDOW_MS 1000          // A command's presses must all fall within this long
+#define INPUT_MAX_AGE_MS 2000           // Presses leave the input history after this long
+#define PARRY_BOX_SIZE 50               // Width and height of the parry hitbox
+
+#define SIM_FPS 60
+#define SIM_ACTION_TICKS (ACTION_DURATION_MS * SIM_FPS / 1000)
+#define SIM_STRIKE_FRAME_TICKS (STRIKE_FRAME_MS * SIM_FPS / 1000)
+#define SIM_COMMAND_WINDOW_TICKS (COMMAND_WINDOW_MS * SIM_FPS / 1000)
+#define SIM_INPUT_MAX_AGE_TICKS (INPUT_MAX_AGE_MS * SIM_FPS / 1000)
+#define SIM_PERIOD_TICKS (180 * SIM_FPS) // 3 minutes per period
+#define SIM_PERIODS 3
+#define SIM_START_POINTS 5              // player1Points / player2Points at the start of a bout
+#define SIM_WALK_SPEED 6                // Pixels a tick while a direction is held
+#define SIM_RELEASE_FRAMES 2            // Ticks a released direction keeps walking
+#define SIM_SPRITE_SIZE 300             // positionRect width and height
+#define SIM_GROUND_Y (SCREEN_HEIGHT - 300)
+#define SIM_MAX_X (SCREEN_WIDTH - SIM_SPRITE_SIZE)
+#define SIM_START_X1 50                 // Start mark of player 1 (Character::reset draws it)
+#define SIM_START_X2 (SCREEN_WIDTH - 350) // Start mark of player 2
+#define SIM_NO_PRESS 0xFF               // pressAge value for a key not in the input history
+
+// Held keys for one tick, one bit per action name from input.txt
+enum InputBit : uint8_t {
+    INPUT_UP = 1 << 0,
+    INPUT_DOWN = 1 << 1,
+    INPUT_LEFT = 1 << 2,
+    INPUT_RIGHT = 1 << 3,
+    INPUT_ATTACK = 1 << 4
+};
+#define INPUT_SYMBOLS 5
+typedef uint8_t InputWord;
+
+// Actions, in the same spelling as Character::currentAction
+enum ActionId : uint8_t {
+    ACTION_IDLE,
+    ACTION_ATTACK,
+    ACTION_PARRY_LOW,
+    ACTION_PARRY_HIGH,
+    ACTION_PARRY_MID,
+    ACTION_STRIKE_LOWHIGH,
+    ACTION_STRIKE_HIGHLOW,
+    ACTION_COUNT
+};
+
+enum WeaponId : uint8_t {
+    WEAPON_EPEE,
+    WEAPON_SABRE,
+    WEAPON_COUNT
+};
+
+// Events reported by stepMatch
+enum SimEvent : uint8_t {
+    EVENT_TOUCH_P1 = 1 << 0,  // Player 1 touched player 2
+    EVENT_TOUCH_P2 = 1 << 1,  // Player 2 touched player 1
+    EVENT_PARRY_P1 = 1 << 2,  // Player 1 parried a touch
+    EVENT_PARRY_P2 = 1 << 3,  // Player 2 parried a touch
+    EVENT_PERIOD = 1 << 4,    // A new period started
+    EVENT_GAME_OVER = 1 << 5  // The bout ended on this tick
+};
+
+// Macro moves for the solver and the bots: walking, or the key presses of one SIM_COMMANDS entry
+enum MacroMove : uint8_t {
+    MOVE_HOLD,
+    MOVE_ADVANCE,
+    MOVE_RETREAT,
+    MOVE_ATTACK,
+    MOVE_PARRY_LOW,
+    MOVE_PARRY_HIGH,
+    MOVE_PARRY_MID,
+    MOVE_STRIKE_LOWHIGH,
+    MOVE_STRIKE_HIGHLOW,
+    MOVE_COUNT
+};
+
+extern const char* const ACTION_NAMES[ACTION_COUNT];
+extern const char* const WEAPON_NAMES[WEAPON_COUNT];
+extern const char* const INPUT_NAMES[INPUT_SYMBOLS];
+extern const char* const MOVE_NAMES[MOVE_COUNT];
+
+// Declare structs
+struct SimRect {
+    int x, y, w, h;
+};
+
+// A command: the action it starts and the keys that must all be in the input history
+struct SimCommand {
+    uint8_t action;   // ActionId triggered by the command
+    uint8_t required; // InputBits that must all be in the input history
+};
+
+struct FencerState {
+    int16_t x = SIM_START_X1;      // Character::x
+    int8_t velocityX = 0;          // -SIM_WALK_SPEED, 0 or SIM_WALK_SPEED
+    uint8_t action = ACTION_IDLE;  // ActionId
+    uint8_t actionTicks = 0;       // Ticks since the current action started
+    uint8_t held = 0;              // InputWord held on the previous tick
+    uint8_t leftFrames = 0;        // Ticks since left was released, up to SIM_RELEASE_FRAMES
+    uint8_t rightFrames = 0;       // Ticks since right was released, up to SIM_RELEASE_FRAMES
+    uint8_t pressAge[INPUT_SYMBOLS] = {SIM_NO_PRESS, SIM_NO_PRESS, SIM_NO_PRESS, SIM_NO_PRESS, SIM_NO_PRESS}; // Input history: ticks since each key was pressed
+};
+
+struct MatchState {
+    FencerState fencers[2];        // [0] is player 1 (facing right), [1] is player 2 (flipped)
+    uint32_t tick = 0;             // Ticks since the bout started
+    uint16_t periodTicks = 0;      // Ticks into the current period, restarted by a touch
+    uint8_t period = 1;            // currentPeriod
+    uint8_t weapon = WEAPON_EPEE;  // WeaponId
+    int8_t points[2] = {SIM_START_POINTS, SIM_START_POINTS}; // player1Points / player2Points
+    bool suddenDeath = false;
+    bool over = false;
+};
+
+extern const SimCommand SIM_COMMANDS[2][5];
+
+// xorshift64* generator for the tools and bots, cheap to copy along with a MatchState
+struct SimRandom {
+    uint64_t state;
+
+    explicit SimRandom(uint64_t seed) : state(seed ? seed : 1) {} // xorshift gets stuck on zero
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1dULL;
+    }
+    int below(int bound) { return static_cast<int>(next() % static_cast<uint64_t>(bound)); }
+};
+
+// Declare functions
+void initMatch(MatchState& state, uint8_t weapon);
+void resetFencers(MatchState& state);
+void placeFencers(MatchState& state, int distance);
+int fencerDistance(const MatchState& state);
+SimRect hurtboxAt(int x, int y, int player, uint8_t weapon);
+SimRect hitboxAt(uint8_t action, int actionTicks, int x, int y, int player);
+SimRect parryBoxAt(uint8_t action, int x, int y, int player, uint8_t weapon);
+SimRect fencerHurtbox(const MatchState& state, int player);
+SimRect fencerHitbox(const MatchState& state, int player);
+SimRect fencerParryBox(const MatchState& state, int player);
+bool fencerParrying(const FencerState& fencer);
+bool simIntersects(const SimRect& a, const SimRect& b);
+uint8_t stepMatch(MatchState& state, InputWord player1Input, InputWord player2Input);
+int matchWinner(const MatchState& state);
+uint64_t hashFencers(const MatchState& state);
+uint64_t hashMatchState(const MatchState& state);
+bool sameMatchState(const MatchState& a, const MatchState& b); // Field by field: the padding bytes are not compared
+uint64_t seedFor(uint64_t baseSeed, uint64_t index);
+InputWord forwardInput(int player);
+InputWord backInput(int player);
+InputWord commandInput(uint8_t action, int player, int tick);
+int commandTicks(uint8_t action, int player);
+InputWord moveInput(int move, int player, int tick);
+int actionFromName(const char* name);
+int weaponFromName(const char* name);
+
+// Plays macro moves for bots that pick one every tick: walking follows the latest pick, while a
+// command keeps its keys until all of them are pressed and only starts from idle, so no stray
+// presses sit in the input history
+struct MoveRunner {
+    int move = MOVE_HOLD;
+    int tick = 0;
+    int ticks = 1;  // Ticks the current move keeps its keys
+
+    void reset() { *this = MoveRunner(); }
+    InputWord next(int wanted, const MatchState& state, int player);
+};
+
+#endif // SIMULATION_H
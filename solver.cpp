@@ -0,0 +1,229 @@
+#include "solver.h"
+#include "lab.h"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <string>
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    size_t count = 1;
+    size_t limit = megabytes * 1024 * 1024 / sizeof(TTEntry);
+    while (count * 2 <= limit) count *= 2;
+    entries.reset(new TTEntry[count]);
+    mask = count - 1;
+}
+
+// data: value + 1 in bits 0-1, move in bits 2-5, reply in bits 6-9, bit 10 marks a used entry
+bool TranspositionTable::probe(uint64_t key, int& value, int& move, int& reply) const {
+    const TTEntry& entry = entries[key & mask];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t check = entry.check.load(std::memory_order_relaxed);
+    if (!(data & (1 << 10)) || (check ^ data) != key) return false;
+
+    value = static_cast<int>(data & 3) - 1;
+    move = static_cast<int>((data >> 2) & 15);
+    reply = static_cast<int>((data >> 6) & 15);
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, int value, int move, int reply) {
+    TTEntry& entry = entries[key & mask];
+    uint64_t data = static_cast<uint64_t>(value + 1) | static_cast<uint64_t>(move) << 2 |
+                    static_cast<uint64_t>(reply) << 6 | (1 << 10);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
+
+static uint64_t searchKey(const MatchState& state, int side, int depth) {
+    uint64_t key = hashFencers(state);
+    key ^= (static_cast<uint64_t>(depth) << 1 | side) * 0x9e3779b97f4a7c15ULL;
+    return key;
+}
+
+// Plays one decision step; returns true with the result (player 1's point of view) on a touch
+bool GameSolver::playStep(MatchState& state, int player1Move, int player2Move, int& result) const {
+    for (int tick = 0; tick < config.stepTicks; ++tick) {
+        uint8_t events = stepMatch(state, moveInput(player1Move, 0, tick), moveInput(player2Move, 1, tick));
+        if (events & EVENT_TOUCH_P1) {
+            result = 1;
+            return true;
+        }
+        if (events & EVENT_TOUCH_P2) {
+            result = -1;
+            return true;
+        }
+    }
+    result = 0;
+    return false;
+}
+
+int GameSolver::guaranteed(const MatchState& state, int side, int depth) {
+    if (depth == 0) return 0;
+
+    uint64_t key = searchKey(state, side, depth);
+    int value, move, reply;
+    if (table.probe(key, value, move, reply)) return value;
+
+    int best = -2;
+    int bestMove = MOVE_HOLD;
+    int bestReply = MOVE_HOLD;
+    for (int candidate = 0; candidate < MOVE_COUNT && best < 1; ++candidate) {
+        int candidateReply;
+        int worst = moveValue(state, side, candidate, depth, best, candidateReply);
+        if (worst > best) {
+            best = worst;
+            bestMove = candidate;
+            bestReply = candidateReply;
+        }
+    }
+
+    table.store(key, best, bestMove, bestReply);
+    return best;
+}
+
+// Worst case of a move over every opponent reply. Stops early once it cannot beat floor.
+int GameSolver::moveValue(const MatchState& state, int side, int move, int depth, int floor, int& reply) {
+    int worst = 2;
+    reply = MOVE_HOLD;
+    for (int opponent = 0; opponent < MOVE_COUNT; ++opponent) {
+        MatchState child = state;
+        nodes++;
+
+        int result;
+        int value;
+        bool touched = side == 0 ? playStep(child, move, opponent, result) : playStep(child, opponent, move, result);
+        if (touched) {
+            value = side == 0 ? result : -result;
+        } else {
+            value = guaranteed(child, side, depth - 1);
+        }
+
+        if (value < worst) {
+            worst = value;
+            reply = opponent;
+            if (worst <= floor || worst == -1) break;
+        }
+    }
+    return worst;
+}
+
+// Follows the stored best moves from the root for as long as the table still holds them
+std::vector<std::pair<int, int>> GameSolver::principalLine(MatchState state, int side, int move, int reply, int depth) const {
+    std::vector<std::pair<int, int>> line;
+    while (depth > 0) {
+        line.push_back({move, reply});
+        int result;
+        bool touched = side == 0 ? playStep(state, move, reply, result) : playStep(state, reply, move, result);
+        if (touched || --depth == 0) break;
+
+        int value;
+        if (!table.probe(searchKey(state, side, depth), value, move, reply)) break;
+    }
+    return line;
+}
+
+struct SolverJob {
+    int weapon;
+    int distance;
+    int side;
+    int move;
+    int value = 0;
+    int reply = 0;
+};
+
+static std::string valueName(int value) {
+    if (value > 0) return "scores";
+    if (value < 0) return "can lose";
+    return "never loses";
+}
+
+int runSolver(int argc, char* argv[]) {
+    SolverConfig config;
+    config.depth = intOption(argc, argv, "--depth", config.depth);
+    config.stepTicks = intOption(argc, argv, "--step-ticks", config.stepTicks);
+    config.tableMegabytes = static_cast<size_t>(intOption(argc, argv, "--table-mb", static_cast<int>(config.tableMegabytes)));
+    std::vector<int> distances = intListOption(argc, argv, "--distances", {SIM_START_X2 - SIM_START_X1, 300, 200, 150, 100, 50});
+    std::vector<int> weapons = weaponOption(argc, argv);
+    int threads = threadOption(argc, argv);
+
+    if (weapons.empty()) return 1;
+    if (config.depth < 1 || config.stepTicks < 6 || config.tableMegabytes < 1) {
+        std::cerr << "solve: --depth must be at least 1, --step-ticks at least 6 and --table-mb at least 1" << std::endl;
+        return 1;
+    }
+
+    // One job per root move, so the workers share out the first ply and meet again in the table
+    std::vector<SolverJob> jobs;
+    for (int weapon : weapons) {
+        for (int distance : distances) {
+            for (int side = 0; side < 2; ++side) {
+                for (int move = 0; move < MOVE_COUNT; ++move) {
+                    jobs.push_back({weapon, distance, side, move});
+                }
+            }
+        }
+    }
+
+    TranspositionTable table(config.tableMegabytes);
+    std::cout << "Searching " << jobs.size() << " root moves, depth " << config.depth << " x " << config.stepTicks
+              << " ticks, " << table.size() << " table entries, " << threads << " threads" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> nextJob{0};
+    std::vector<uint64_t> workerNodes(threads, 0);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            GameSolver solver(config, table);
+            for (size_t index = nextJob++; index < jobs.size(); index = nextJob++) {
+                SolverJob& job = jobs[index];
+                MatchState state;
+                initMatch(state, static_cast<uint8_t>(job.weapon));
+                placeFencers(state, job.distance);
+                job.value = solver.moveValue(state, job.side, job.move, config.depth, -2, job.reply);
+            }
+            workerNodes[i] = solver.nodes;
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t nodes = 0;
+    for (uint64_t count : workerNodes) nodes += count;
+
+    // Report per weapon and distance, in job order
+    GameSolver reporter(config, table);
+    for (size_t first = 0; first < jobs.size(); first += 2 * MOVE_COUNT) {
+        const SolverJob& head = jobs[first];
+        MatchState root;
+        initMatch(root, static_cast<uint8_t>(head.weapon));
+        placeFencers(root, head.distance);
+        std::cout << "\n" << WEAPON_NAMES[head.weapon] << ", distance " << fencerDistance(root) << ":" << std::endl;
+
+        for (int side = 0; side < 2; ++side) {
+            const SolverJob* best = nullptr;
+            std::string neverLosing;
+            std::string dominant;
+            for (int move = 0; move < MOVE_COUNT; ++move) {
+                const SolverJob& job = jobs[first + side * MOVE_COUNT + move];
+                if (!best || job.value > best->value) best = &job;
+                if (job.value >= 0) neverLosing += std::string(" ") + MOVE_NAMES[move];
+                if (job.value > 0) dominant += std::string(" ") + MOVE_NAMES[move];
+            }
+
+            std::cout << "  Player " << side + 1 << " " << valueName(best->value) << " with best play" << std::endl;
+            std::cout << "    never-losing:" << (neverLosing.empty() ? " none" : neverLosing) << std::endl;
+            std::cout << "    dominant:" << (dominant.empty() ? " none" : dominant) << std::endl;
+            if (!dominant.empty()) std::cout << "    WARNING: unbeatable option for player " << side + 1 << std::endl;
+
+            std::cout << "    line:";
+            for (const auto& [move, reply] : reporter.principalLine(root, side, best->move, best->reply, config.depth)) {
+                std::cout << " " << MOVE_NAMES[move] << "/" << MOVE_NAMES[reply];
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    std::cout << "\n" << nodes << " nodes in " << seconds << " s" << std::endl;
+    return 0;
+}
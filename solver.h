@@ -0,0 +1,50 @@
+// Exhaustive game-tree search over the macro moves both fencers can pick at each decision step.
+// Used by "FencingLab solve" to find options that can never lose (or always score) within the horizon.
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "simulation.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <utility>
+
+// Fixed-size, lock-free table shared by every worker. Each entry stores its key XOR its data so a
+// torn write from another thread is detected on probe instead of returning someone else's result.
+struct TTEntry {
+    std::atomic<uint64_t> check{0};
+    std::atomic<uint64_t> data{0};
+};
+
+struct TranspositionTable {
+    std::unique_ptr<TTEntry[]> entries;
+    uint64_t mask = 0;
+
+    explicit TranspositionTable(size_t megabytes); // Rounded down to a power-of-two entry count
+    size_t size() const { return static_cast<size_t>(mask + 1); }
+    bool probe(uint64_t key, int& value, int& move, int& reply) const;
+    void store(uint64_t key, int value, int move, int reply);
+};
+
+struct SolverConfig {
+    int depth = 5;              // Decision steps searched from the root
+    int stepTicks = 10;         // Ticks each macro move is held for
+    size_t tableMegabytes = 256; // Memory bound for the transposition table
+};
+
+// Values are from the searching side's point of view: 1 it scores, -1 it is touched, 0 no touch
+// within the horizon. The side commits to its move first, so a value is what it can guarantee.
+struct GameSolver {
+    const SolverConfig& config;
+    TranspositionTable& table;
+    uint64_t nodes = 0;
+
+    GameSolver(const SolverConfig& config, TranspositionTable& table) : config(config), table(table) {}
+
+    int guaranteed(const MatchState& state, int side, int depth);
+    int moveValue(const MatchState& state, int side, int move, int depth, int floor, int& reply);
+    bool playStep(MatchState& state, int player1Move, int player2Move, int& result) const;
+    std::vector<std::pair<int, int>> principalLine(MatchState state, int side, int move, int reply, int depth) const;
+};
+
+#endif // SOLVER_H
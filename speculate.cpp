@@ -0,0 +1,177 @@
+#include "speculate.h"
+#include <algorithm>
+
+// What the opponent is assumed to hold until the decision, most likely first: players hold keys for
+// many ticks at a time, so keeping the current keys comes first
+enum SpeculationPlan {
+    PLAN_HOLD,      // The keys held now
+    PLAN_RELEASE,   // Nothing
+    PLAN_LIKELY,    // The command of the opponent model's most likely next action, from the next tick
+    PLAN_ADVANCE,
+    PLAN_RETREAT,
+    PLAN_COUNT
+};
+
+SpeculativeBot::SpeculativeBot(int player, const AlphaBetaConfig& config) : bot(player, config), searcher(player, config) {
+    searcher.cancel = &cancel;
+    worker = std::thread(&SpeculativeBot::workerLoop, this);
+}
+
+SpeculativeBot::~SpeculativeBot() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        cancel = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void SpeculativeBot::attach(const OpeningBook* book, const Tablebase* tablebase) {
+    bot.book = searcher.book = book;
+    bot.tablebase = searcher.tablebase = tablebase;
+}
+
+void SpeculativeBot::reset() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Speculation& slot : slots) dropSlot(slot);
+    }
+    bot.reset();
+}
+
+void SpeculativeBot::dropSlot(Speculation& slot) {
+    if (slot.id != 0 && slot.id == searchingId) {
+        cancel = true;
+        cancelled++;
+    }
+    slot.id = 0;
+}
+
+// Searches the most likely unsearched speculation until told to quit; a cancelled search is thrown away
+void SpeculativeBot::workerLoop() {
+    while (true) {
+        MatchState state;
+        uint64_t id;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            Speculation* next = nullptr;
+            wake.wait(lock, [&]() {
+                next = nullptr;
+                for (Speculation& slot : slots) {
+                    if (slot.id != 0 && slot.move < 0 && (!next || slot.priority < next->priority)) next = &slot;
+                }
+                return quit || next;
+            });
+            if (quit) return;
+            id = next->id;
+            state = next->state;
+            searchingId = id;
+            searches++;
+            cancel = false;
+        }
+
+        int move = searcher.choose(state);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (Speculation& slot : slots) {
+                if (slot.id == id && !cancel) slot.move = move;
+            }
+            searchingId = 0;
+        }
+        finished.notify_all();
+    }
+}
+
+// Replays each plan from the real state up to the decision; about a stepMatch per plan and tick, so
+// the main thread spends a few microseconds here
+void SpeculativeBot::speculate(const MatchState& state) {
+    int player = bot.player;
+    int opponent = 1 - player;
+    int ticks = bot.remainingTicks();
+    InputWord held = state.fencers[opponent].held;
+    int likely = -1;
+    if (model) {
+        float probability;
+        int action = model->likelyAction(probability);
+        if (action != ACTION_IDLE) likely = MOVE_ATTACK + action - ACTION_ATTACK;
+    }
+
+    MatchState wanted[PLAN_COUNT];
+    uint64_t hashes[PLAN_COUNT];
+    int count = 0;
+    for (int plan = 0; plan < PLAN_COUNT && count < SPECULATE_SLOTS; ++plan) {
+        if (plan == PLAN_LIKELY && likely < 0) continue;
+        MatchState next = state;
+        for (int i = 0; i < ticks && !next.over; ++i) {
+            InputWord own = moveInput(bot.committedMove, player, bot.moveTick + i);
+            InputWord theirs = plan == PLAN_HOLD      ? held
+                               : plan == PLAN_RELEASE ? 0
+                               : plan == PLAN_LIKELY  ? moveInput(likely, opponent, i)
+                               : plan == PLAN_ADVANCE ? forwardInput(opponent)
+                                                      : backInput(opponent);
+            stepMatch(next, player == 0 ? own : theirs, player == 0 ? theirs : own);
+        }
+        uint64_t hash = hashMatchState(next);
+        if (std::find(hashes, hashes + count, hash) != hashes + count) continue;
+        wanted[count] = next;
+        hashes[count++] = hash;
+        if (ticks == 0) break; // The decision state is already known
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Speculation& slot : slots) {
+            if (slot.id != 0 && std::find(hashes, hashes + count, slot.hash) == hashes + count) dropSlot(slot);
+        }
+        for (int i = 0; i < count; ++i) {
+            Speculation* kept = nullptr;
+            Speculation* empty = nullptr;
+            for (Speculation& slot : slots) {
+                if (slot.id != 0 && slot.hash == hashes[i]) kept = &slot;
+                if (slot.id == 0 && !empty) empty = &slot;
+            }
+            if (!kept) {
+                kept = empty;
+                kept->id = nextId++;
+                kept->hash = hashes[i];
+                kept->state = wanted[i];
+                kept->move = -1;
+            }
+            kept->priority = i;
+        }
+    }
+    wake.notify_one();
+}
+
+InputWord SpeculativeBot::update(const MatchState& state) {
+    if (!bot.decisionDue()) return bot.play(bot.committedMove);
+
+    uint64_t hash = hashMatchState(state);
+    int move = -1;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        Speculation* match = nullptr;
+        for (Speculation& slot : slots) {
+            if (slot.id != 0 && slot.hash == hash) match = &slot;
+        }
+        if (match && match->move < 0 && match->id == searchingId) {
+            // Started before this frame, so it finishes sooner than a new search would
+            uint64_t id = match->id;
+            finished.wait(lock, [&]() { return searchingId != id; });
+            if (match->move >= 0) waits++;
+        } else if (match && match->move >= 0) {
+            hits++;
+        }
+        if (match) move = match->move;
+
+        // Every speculation was for this decision; the next ones start from the move it commits to
+        for (Speculation& slot : slots) dropSlot(slot);
+    }
+
+    if (move < 0) {
+        misses++;
+        move = bot.choose(state);
+    }
+    return bot.play(move);
+}
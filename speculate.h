@@ -0,0 +1,62 @@
+// Speculative decisions for the alpha-beta opponent. The game loop sleeps for most of every frame, so
+// after each tick a worker thread searches the states the bot's next decision is likely to be made in:
+// the exact state when the decision is due on the next tick, otherwise the state each of a few likely
+// opponent input plans leads to. When the decision comes the answer is usually a table lookup on the
+// main thread. Every tick the plans are replayed from the real state; speculations no longer reached
+// are dropped and the one being searched is cancelled through a flag the search polls.
+#ifndef SPECULATE_H
+#define SPECULATE_H
+
+#include "alphabeta.h"
+#include "opponentmodel.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#define SPECULATE_SLOTS 6 // States searched ahead at most: one per opponent input plan
+
+struct Speculation {
+    uint64_t id = 0;          // 0 for a free slot
+    uint64_t hash = 0;        // hashMatchState of the decision state
+    MatchState state;
+    int priority = 0;         // Most likely plan first
+    int move = -1;            // -1 until searched
+};
+
+struct SpeculativeBot {
+    AlphaBetaBot bot;         // Plays the moves; searches on the main thread when no speculation matches
+    AlphaBetaBot searcher;    // The worker's own search state, with the same config, book and tablebase
+    const OpponentModel* model = nullptr; // Watching the opponent, for a plan playing its likely action
+    uint64_t hits = 0;        // Decisions answered by a finished speculation
+    uint64_t waits = 0;       // ... by one still being searched, after waiting for it
+    uint64_t misses = 0;      // Decisions searched on the main thread
+    uint64_t searches = 0;    // Worker searches, finished or cancelled
+    uint64_t cancelled = 0;   // Speculations dropped while being searched
+
+    SpeculativeBot(int player, const AlphaBetaConfig& config);
+    ~SpeculativeBot();
+    SpeculativeBot(const SpeculativeBot&) = delete;
+    SpeculativeBot& operator=(const SpeculativeBot&) = delete;
+
+    void attach(const OpeningBook* book, const Tablebase* tablebase);
+    InputWord update(const MatchState& state); // Call once per tick, like AlphaBetaBot::update
+    void speculate(const MatchState& state);  // Call after stepMatch, before the frame's idle time
+    void reset();                              // Forget the current move and the speculations
+
+    // Shared with the worker thread
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    Speculation slots[SPECULATE_SLOTS];
+    uint64_t nextId = 1;
+    uint64_t searchingId = 0; // Slot id being searched, 0 when idle
+    std::atomic<bool> cancel{false};
+    bool quit = false;
+
+    void workerLoop();
+    void dropSlot(Speculation& slot); // Caller holds the mutex
+};
+
+#endif // SPECULATE_H
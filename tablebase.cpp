@@ -0,0 +1,123 @@
+#include "tablebase.h"
+#include <algorithm>
+
+uint16_t packTablebaseEntry(const TablebaseEntry& entry) {
+    return static_cast<uint16_t>(entry.result | std::min<int>(entry.plies, 63) << 2 | entry.move << 8);
+}
+
+TablebaseEntry unpackTablebaseEntry(uint16_t packed) {
+    TablebaseEntry entry;
+    entry.result = static_cast<uint8_t>(packed & 3);
+    entry.plies = static_cast<uint8_t>((packed >> 2) & 63);
+    entry.move = static_cast<uint8_t>((packed >> 8) & 15);
+    return entry;
+}
+
+size_t tablebaseStateCount() {
+    return static_cast<size_t>(WEAPON_COUNT) * TB_GAP_BUCKETS * TB_FENCER_STATES * TB_FENCER_STATES;
+}
+
+size_t tablebaseIndex(int side, int weapon, int gapBucket, int fencer0, int fencer1) {
+    size_t index = static_cast<size_t>(side);
+    index = index * WEAPON_COUNT + weapon;
+    index = index * TB_GAP_BUCKETS + gapBucket;
+    index = index * TB_FENCER_STATES + fencer0;
+    return index * TB_FENCER_STATES + fencer1;
+}
+
+// Phases are rounded to the nearest bucket; an action about to end stays in the last one
+int tablebaseFencerState(const FencerState& fencer) {
+    if (fencer.action == ACTION_IDLE) return 0;
+    int phase = std::min((fencer.actionTicks + TB_PHASE_STEP / 2) / TB_PHASE_STEP, TB_PHASES - 1);
+    return 1 + (fencer.action - 1) * TB_PHASES + phase;
+}
+
+bool tablebaseCanonical(const MatchState& state) {
+    for (const FencerState& fencer : state.fencers) {
+        if (fencer.velocityX != 0 || fencer.held != 0) return false;
+        for (uint8_t age : fencer.pressAge) {
+            if (age != SIM_NO_PRESS) return false;
+        }
+    }
+    return true;
+}
+
+bool tablebaseIndexFor(const MatchState& state, int side, size_t& index) {
+    int gap = state.fencers[1].x - state.fencers[0].x;
+    int gapBucket = (gap + TB_GAP_STEP / 2) / TB_GAP_STEP;
+    if (gap < 0 || gapBucket >= TB_GAP_BUCKETS) return false;
+
+    index = tablebaseIndex(side, state.weapon, gapBucket, tablebaseFencerState(state.fencers[0]),
+                           tablebaseFencerState(state.fencers[1]));
+    return true;
+}
+
+void tablebaseState(size_t stateIndex, MatchState& state) {
+    int fencer1 = static_cast<int>(stateIndex % TB_FENCER_STATES);
+    stateIndex /= TB_FENCER_STATES;
+    int fencer0 = static_cast<int>(stateIndex % TB_FENCER_STATES);
+    stateIndex /= TB_FENCER_STATES;
+    int gapBucket = static_cast<int>(stateIndex % TB_GAP_BUCKETS);
+    int weapon = static_cast<int>(stateIndex / TB_GAP_BUCKETS);
+
+    initMatch(state, static_cast<uint8_t>(weapon));
+    placeFencers(state, gapBucket * TB_GAP_STEP);
+    int fencerStates[2] = {fencer0, fencer1};
+    for (int p = 0; p < 2; ++p) {
+        if (fencerStates[p] == 0) continue;
+        state.fencers[p].action = static_cast<uint8_t>(1 + (fencerStates[p] - 1) / TB_PHASES);
+        state.fencers[p].actionTicks = static_cast<uint8_t>((fencerStates[p] - 1) % TB_PHASES * TB_PHASE_STEP);
+    }
+}
+
+bool Tablebase::open(const std::string& path) {
+    close();
+    if (!file.open(path, sizeof(TablebaseHeader), MAP_ACCESS_RANDOM)) {
+        error = file.error;
+        return false;
+    }
+
+    header = static_cast<const TablebaseHeader*>(file.data);
+    size_t blocks = (2 * tablebaseStateCount() + TB_BLOCK_ENTRIES - 1) / TB_BLOCK_ENTRIES;
+    size_t indexBytes = sizeof(TablebaseHeader) + (blocks + 1) * sizeof(uint32_t);
+    if (header->magic != TABLEBASE_MAGIC || header->version != TABLEBASE_VERSION ||
+        header->entryCount != 2 * tablebaseStateCount() || header->blockCount != blocks || file.size < indexBytes) {
+        error = "not a version " + std::to_string(TABLEBASE_VERSION) + " tablebase for this build";
+        close();
+        return false;
+    }
+    offsets = reinterpret_cast<const uint32_t*>(static_cast<const char*>(file.data) + sizeof(TablebaseHeader));
+    runs = static_cast<const uint8_t*>(file.data) + indexBytes;
+    if (indexBytes + offsets[blocks] != file.size) {
+        error = "truncated or padded";
+        close();
+        return false;
+    }
+    error.clear();
+    return true;
+}
+
+void Tablebase::close() {
+    file.close();
+    header = nullptr;
+    offsets = nullptr;
+    runs = nullptr;
+}
+
+bool Tablebase::probe(const MatchState& state, int side, TablebaseEntry& entry) const {
+    size_t index;
+    if (!header || !tablebaseCanonical(state) || !tablebaseIndexFor(state, side, index)) return false;
+
+    size_t block = index / TB_BLOCK_ENTRIES;
+    size_t skip = index % TB_BLOCK_ENTRIES;
+    const uint8_t* run = runs + offsets[block];
+    const uint8_t* end = runs + offsets[block + 1];
+    for (; run + 3 <= end; run += 3) {
+        if (skip < run[0]) {
+            entry = unpackTablebaseEntry(static_cast<uint16_t>(run[1] | run[2] << 8));
+            return true;
+        }
+        skip -= run[0];
+    }
+    return false; // Corrupt block
+}
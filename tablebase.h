@@ -0,0 +1,74 @@
+// Close-range tablebase: win/loss/draw and plies-to-touch for every quantized close-range state
+// (weapon, gap, both actions and their phases), solved offline by retrograde analysis in
+// "FencingLab tablebase" and memory-mapped by the game. Values use the solver's rule: the side to
+// look up commits to its macro move first and the opponent answers it.
+//
+// A tablebase state is canonical: no keys held, no walk momentum and an empty input history. The
+// action phase stands in for a lockout timer, since an action cannot be cancelled until it ends.
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include "simulation.h"
+#include "mappedfile.h"
+#include <string>
+
+#define TABLEBASE_MAGIC 0x53425446u // "FTBS"
+#define TABLEBASE_VERSION 1
+#define TB_GAP_STEP SIM_WALK_SPEED  // Walking keeps the gap on the grid
+#define TB_GAP_BUCKETS 26           // Gaps 0-150: inside the strikes' reach
+#define TB_PHASE_STEP 5             // Ticks per phase bucket; macro steps are two buckets long
+#define TB_PHASES (SIM_ACTION_TICKS / TB_PHASE_STEP)
+#define TB_FENCER_STATES (1 + (ACTION_COUNT - 1) * TB_PHASES) // Idle, or an action and its phase
+#define TB_BLOCK_ENTRIES 1024       // Entries per independently decodable block
+
+enum TablebaseResult : uint8_t {
+    TB_DRAW, // Neither side can force a touch, or play leaves close range
+    TB_WIN,
+    TB_LOSS
+};
+
+// Packed entry: result in bits 0-1, plies to the touch in bits 2-7, best macro move in bits 8-11
+struct TablebaseEntry {
+    uint8_t result = TB_DRAW;
+    uint8_t plies = 0;
+    uint8_t move = MOVE_HOLD;
+};
+uint16_t packTablebaseEntry(const TablebaseEntry& entry);
+TablebaseEntry unpackTablebaseEntry(uint16_t packed);
+
+// File layout: TablebaseHeader, blockCount + 1 uint32_t offsets into the run data, then the run data:
+// per block, (count uint8_t, packed entry uint16_t little-endian) runs covering TB_BLOCK_ENTRIES
+// entries. A lookup decodes at most one block.
+struct TablebaseHeader {
+    uint32_t magic = TABLEBASE_MAGIC;
+    uint16_t version = TABLEBASE_VERSION;
+    uint8_t stepTicks = 10;        // Macro-move length the table was solved with
+    uint8_t maxPlies = 0;          // Longest forced line found
+    uint32_t entryCount = 0;
+    uint32_t blockCount = 0;
+};
+static_assert(sizeof(TablebaseHeader) == 16, "TablebaseHeader is written as is");
+
+size_t tablebaseStateCount(); // Per side
+size_t tablebaseIndex(int side, int weapon, int gapBucket, int fencer0, int fencer1);
+int tablebaseFencerState(const FencerState& fencer);
+// True when nothing outside the table's key can change how the state plays on
+bool tablebaseCanonical(const MatchState& state);
+// Index of a live or simulated state (gap rounded to the grid), or false outside close range
+bool tablebaseIndexFor(const MatchState& state, int side, size_t& index);
+// Canonical state for a per-side index
+void tablebaseState(size_t stateIndex, MatchState& state);
+
+struct Tablebase {
+    const TablebaseHeader* header = nullptr;
+    const uint32_t* offsets = nullptr;
+    const uint8_t* runs = nullptr;
+    std::string error;
+    MappedFile file;
+
+    bool open(const std::string& path);
+    void close();
+    bool probe(const MatchState& state, int side, TablebaseEntry& entry) const; // False when not canonical or not in the table
+};
+
+#endif // TABLEBASE_H
@@ -0,0 +1,285 @@
+#include "tablebase.h"
+#include "lab.h"
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+// Child codes above every state index
+#define TB_CHILD_TOUCH_P1 0xFFFFFFFDu
+#define TB_CHILD_TOUCH_P2 0xFFFFFFFEu
+#define TB_CHILD_OUT 0xFFFFFFFFu // Left close range or the canonical states: a draw as far as the table is concerned
+
+#define TB_PAIRS (MOVE_COUNT * MOVE_COUNT)
+
+// Runs work(begin, end) over [0, count) in chunks on every thread
+static void parallelFor(size_t count, int threads, const std::function<void(size_t, size_t)>& work) {
+    const size_t chunk = 1024;
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() {
+            for (size_t begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk)) {
+                work(begin, std::min(begin + chunk, count));
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+}
+
+// Plays one macro-move pair from a canonical state. Keys left in the input history change what later
+// presses do, so a child that is not canonical is off the table rather than rounded onto it.
+static uint32_t playChild(size_t stateIndex, int player1Move, int player2Move, int stepTicks) {
+    MatchState state;
+    tablebaseState(stateIndex, state);
+    for (int tick = 0; tick < stepTicks; ++tick) {
+        uint8_t events = stepMatch(state, moveInput(player1Move, 0, tick), moveInput(player2Move, 1, tick));
+        if (events & EVENT_TOUCH_P1) return TB_CHILD_TOUCH_P1;
+        if (events & EVENT_TOUCH_P2) return TB_CHILD_TOUCH_P2;
+    }
+    size_t index;
+    if (!tablebaseCanonical(state) || !tablebaseIndexFor(state, 0, index)) return TB_CHILD_OUT;
+    return static_cast<uint32_t>(index);
+}
+
+struct TablebaseSolver {
+    size_t states = tablebaseStateCount();
+    std::vector<uint32_t> children;      // [state][player 1 move][player 2 move]
+    std::vector<uint32_t> parentStart;   // Predecessor lists, CSR layout
+    std::vector<uint32_t> parents;
+    std::vector<uint16_t> entries[2];    // Packed TablebaseEntry per side, final values
+    std::vector<uint8_t> decidedAt[2];   // Ply a state was decided at, 0 while undecided
+
+    // Outcome of one child for side: 1 side touched first, -1 touched, 0 undecided or draw. plies is
+    // the length of the forced line through the child, including this step.
+    int childOutcome(int side, uint32_t child, int level, int& plies) const {
+        plies = 1;
+        if (child == TB_CHILD_TOUCH_P1) return side == 0 ? 1 : -1;
+        if (child == TB_CHILD_TOUCH_P2) return side == 1 ? 1 : -1;
+        if (child == TB_CHILD_OUT) return 0;
+        uint8_t ply = decidedAt[side][child];
+        if (ply == 0 || ply >= level) return 0; // Only lines shorter than this level count
+        TablebaseEntry entry = unpackTablebaseEntry(entries[side][child]);
+        plies = ply + 1;
+        return entry.result == TB_WIN ? 1 : -1;
+    }
+
+    uint32_t child(size_t state, int side, int move, int reply) const {
+        return side == 0 ? children[state * TB_PAIRS + move * MOVE_COUNT + reply]
+                         : children[state * TB_PAIRS + reply * MOVE_COUNT + move];
+    }
+
+    // Result of a state at this level: a win if some move wins against every reply, a loss if every
+    // move loses to some reply. The chosen move is the fastest win, or the slowest loss.
+    TablebaseEntry evaluate(size_t state, int side, int level) const {
+        TablebaseEntry entry;
+        int bestWin = 255;
+        int slowestLoss = -1;
+        bool allLose = true;
+        int safeMove = -1;
+        for (int move = 0; move < MOVE_COUNT; ++move) {
+            bool wins = true;
+            int winPlies = 0;
+            int lossPlies = 255; // Quickest touch the opponent can force against this move
+            for (int reply = 0; reply < MOVE_COUNT; ++reply) {
+                int plies;
+                int outcome = childOutcome(side, child(state, side, move, reply), level, plies);
+                if (outcome <= 0) wins = false;
+                if (outcome > 0) winPlies = std::max(winPlies, plies);
+                if (outcome < 0) lossPlies = std::min(lossPlies, plies);
+            }
+            if (wins && winPlies < bestWin) {
+                bestWin = winPlies;
+                entry.move = static_cast<uint8_t>(move);
+            }
+            if (lossPlies == 255) {
+                allLose = false;
+                if (safeMove < 0) safeMove = move;
+            } else if (lossPlies > slowestLoss && bestWin == 255) {
+                slowestLoss = lossPlies;
+                entry.move = static_cast<uint8_t>(move);
+            }
+        }
+
+        if (bestWin != 255) {
+            entry.result = TB_WIN;
+            entry.plies = static_cast<uint8_t>(bestWin);
+        } else if (allLose) {
+            entry.result = TB_LOSS;
+            entry.plies = static_cast<uint8_t>(slowestLoss);
+        } else {
+            entry.result = TB_DRAW;
+            entry.plies = 0;
+            entry.move = static_cast<uint8_t>(safeMove < 0 ? MOVE_HOLD : safeMove);
+        }
+        return entry;
+    }
+};
+
+// Appends the run-length blocks for entries and returns the block offsets
+static std::vector<uint32_t> compressEntries(const std::vector<uint16_t>& entries, std::vector<uint8_t>& runs) {
+    std::vector<uint32_t> offsets;
+    for (size_t first = 0; first < entries.size(); first += TB_BLOCK_ENTRIES) {
+        offsets.push_back(static_cast<uint32_t>(runs.size()));
+        size_t end = std::min(first + TB_BLOCK_ENTRIES, entries.size());
+        for (size_t i = first; i < end;) {
+            size_t length = 1;
+            while (i + length < end && length < 255 && entries[i + length] == entries[i]) length++;
+            runs.push_back(static_cast<uint8_t>(length));
+            runs.push_back(static_cast<uint8_t>(entries[i] & 0xFF));
+            runs.push_back(static_cast<uint8_t>(entries[i] >> 8));
+            i += length;
+        }
+    }
+    offsets.push_back(static_cast<uint32_t>(runs.size()));
+    return offsets;
+}
+
+// Solves every close-range state for both sides and writes the tablebase
+int runTablebase(int argc, char* argv[]) {
+    int stepTicks = intOption(argc, argv, "--step-ticks", 10);
+    int maxPlies = intOption(argc, argv, "--max-plies", 63);
+    std::string outPath = stringOption(argc, argv, "--out", "tablebase.bin");
+    int threads = threadOption(argc, argv);
+
+    if (stepTicks < 1 || stepTicks > 255 || maxPlies < 1 || maxPlies > 63) {
+        std::cerr << "tablebase: --step-ticks must be 1-255 and --max-plies 1-63" << std::endl;
+        return 1;
+    }
+
+    TablebaseSolver solver;
+    size_t states = solver.states;
+    std::cout << "Solving " << states << " states per side, " << stepTicks << " ticks per move, " << threads << " threads"
+              << std::endl;
+    auto start = std::chrono::steady_clock::now();
+
+    // Forward pass: every macro-move pair from every state
+    solver.children.resize(states * TB_PAIRS);
+    parallelFor(states, threads, [&](size_t begin, size_t end) {
+        for (size_t state = begin; state < end; ++state) {
+            for (int pair = 0; pair < TB_PAIRS; ++pair) {
+                solver.children[state * TB_PAIRS + pair] = playChild(state, pair / MOVE_COUNT, pair % MOVE_COUNT, stepTicks);
+            }
+        }
+    });
+
+    // Predecessor lists, so each level only revisits states next to the ones just decided
+    // Consecutive pairs often lead to the same child; each parent is listed once per run of them
+    auto newParent = [&](size_t state, int pair) {
+        uint32_t child = solver.children[state * TB_PAIRS + pair];
+        return child < states && (pair == 0 || solver.children[state * TB_PAIRS + pair - 1] != child);
+    };
+    solver.parentStart.assign(states + 1, 0);
+    for (size_t state = 0; state < states; ++state) {
+        for (int pair = 0; pair < TB_PAIRS; ++pair) {
+            if (newParent(state, pair)) solver.parentStart[solver.children[state * TB_PAIRS + pair] + 1]++;
+        }
+    }
+    for (size_t i = 0; i < states; ++i) solver.parentStart[i + 1] += solver.parentStart[i];
+    solver.parents.resize(solver.parentStart[states]);
+    std::vector<uint32_t> fill(solver.parentStart.begin(), solver.parentStart.end() - 1);
+    for (size_t state = 0; state < states; ++state) {
+        for (int pair = 0; pair < TB_PAIRS; ++pair) {
+            if (newParent(state, pair)) {
+                uint32_t child = solver.children[state * TB_PAIRS + pair];
+                solver.parents[fill[child]++] = static_cast<uint32_t>(state);
+            }
+        }
+    }
+    double forwardSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Retrograde levels: a state decided at ply n only depends on states decided before it, so each
+    // level reads the committed table and writes its results afterwards
+    int longest = 0;
+    for (int side = 0; side < 2; ++side) {
+        solver.entries[side].assign(states, packTablebaseEntry(TablebaseEntry()));
+        solver.decidedAt[side].assign(states, 0);
+
+        std::vector<uint32_t> candidates(states);
+        for (size_t i = 0; i < states; ++i) candidates[i] = static_cast<uint32_t>(i);
+        std::vector<uint8_t> queued(states, 0);
+
+        for (int level = 1; level <= maxPlies && !candidates.empty(); ++level) {
+            std::vector<uint16_t> results(candidates.size());
+            std::vector<uint8_t> decided(candidates.size(), 0);
+            parallelFor(candidates.size(), threads, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    TablebaseEntry entry = solver.evaluate(candidates[i], side, level);
+                    decided[i] = entry.result != TB_DRAW;
+                    results[i] = packTablebaseEntry(entry);
+                }
+            });
+
+            std::vector<uint32_t> next;
+            std::fill(queued.begin(), queued.end(), 0);
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                if (!decided[i]) continue;
+                uint32_t state = candidates[i];
+                solver.entries[side][state] = results[i];
+                solver.decidedAt[side][state] = static_cast<uint8_t>(level);
+                longest = std::max(longest, level);
+                for (uint32_t p = solver.parentStart[state]; p < solver.parentStart[state + 1]; ++p) {
+                    uint32_t parent = solver.parents[p];
+                    if (solver.decidedAt[side][parent] == 0 && !queued[parent]) {
+                        queued[parent] = 1;
+                        next.push_back(parent);
+                    }
+                }
+            }
+            candidates.swap(next);
+        }
+
+        // Draws still need a move that never loses
+        parallelFor(states, threads, [&](size_t begin, size_t end) {
+            for (size_t state = begin; state < end; ++state) {
+                if (solver.decidedAt[side][state] == 0) {
+                    solver.entries[side][state] = packTablebaseEntry(solver.evaluate(state, side, 255));
+                    TablebaseEntry entry = unpackTablebaseEntry(solver.entries[side][state]);
+                    entry.result = TB_DRAW;
+                    entry.plies = 0;
+                    solver.entries[side][state] = packTablebaseEntry(entry);
+                }
+            }
+        });
+    }
+
+    size_t counts[2][3] = {};
+    std::vector<uint16_t> all;
+    all.reserve(2 * states);
+    for (int side = 0; side < 2; ++side) {
+        for (uint16_t packed : solver.entries[side]) {
+            counts[side][packed & 3]++;
+            all.push_back(packed);
+        }
+    }
+    std::vector<uint8_t> runs;
+    std::vector<uint32_t> offsets = compressEntries(all, runs);
+
+    TablebaseHeader header;
+    header.stepTicks = static_cast<uint8_t>(stepTicks);
+    header.maxPlies = static_cast<uint8_t>(longest);
+    header.entryCount = static_cast<uint32_t>(all.size());
+    header.blockCount = static_cast<uint32_t>(offsets.size() - 1);
+
+    std::ofstream out(outPath, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(offsets.data()), static_cast<std::streamsize>(offsets.size() * sizeof(uint32_t)));
+    out.write(reinterpret_cast<const char*>(runs.data()), static_cast<std::streamsize>(runs.size()));
+    if (!out) {
+        std::cerr << "tablebase: cannot write " << outPath << std::endl;
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (int side = 0; side < 2; ++side) {
+        std::cout << "  Player " << side + 1 << " to commit: " << counts[side][TB_WIN] << " wins, " << counts[side][TB_LOSS]
+                  << " losses, " << counts[side][TB_DRAW] << " draws" << std::endl;
+    }
+    std::cout << "Longest forced line " << longest << " plies; forward pass " << forwardSeconds << " s, total " << seconds
+              << " s; wrote " << outPath << " (" << sizeof(header) + offsets.size() * sizeof(uint32_t) + runs.size()
+              << " bytes, " << 2 * all.size() << " uncompressed)" << std::endl;
+    return 0;
+}
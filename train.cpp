@@ -0,0 +1,230 @@
+#include "policy.h"
+#include "lab.h"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+// Biases live in dot-product units; one parameter step moves a bias by this much
+#define TRAIN_BIAS_UNIT 128
+
+// Standard normal sample (Box-Muller)
+static float gaussian(SimRandom& rng) {
+    double u1 = (static_cast<double>(rng.next() >> 11) + 1.0) / 9007199254740993.0;
+    double u2 = static_cast<double>(rng.next() >> 11) / 9007199254740992.0;
+    return static_cast<float>(std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2));
+}
+
+// Trained parameters, in layer order: biases, then the weights of the real (unpadded) inputs
+static std::vector<float> flatten(const PolicyNetwork& network) {
+    std::vector<float> params;
+    for (const PolicyLayer& layer : network.layers) {
+        for (int32_t bias : layer.biases) params.push_back(static_cast<float>(bias) / TRAIN_BIAS_UNIT);
+        for (int output = 0; output < layer.outputs; ++output) {
+            for (int input = 0; input < layer.inputs; ++input) {
+                params.push_back(layer.weights[static_cast<size_t>(output) * layer.paddedInputs + input]);
+            }
+        }
+    }
+    return params;
+}
+
+// Inverse of flatten, rounding into the network's int8 weights and int32 biases
+static void quantise(const float* params, PolicyNetwork& network) {
+    for (PolicyLayer& layer : network.layers) {
+        for (int32_t& bias : layer.biases) bias = static_cast<int32_t>(std::lround(*params++ * TRAIN_BIAS_UNIT));
+        for (int output = 0; output < layer.outputs; ++output) {
+            for (int input = 0; input < layer.inputs; ++input) {
+                float weight = std::clamp(std::round(*params++), -127.0f, 127.0f);
+                layer.weights[static_cast<size_t>(output) * layer.paddedInputs + input] = static_cast<int8_t>(weight);
+            }
+        }
+    }
+}
+
+struct TrainConfig {
+    int bouts = 8;        // Per candidate; the trained side alternates between player 1 and player 2
+    int maxTicks = (SIM_PERIODS + 1) * SIM_PERIOD_TICKS; // Three periods and a sudden-death period
+    int stepTicks = 10;
+    const PolicyNetwork* opponent = nullptr; // Random moves when null
+};
+
+// Everything one worker needs to score a candidate, allocated once and reused for every bout
+struct TrainWorker {
+    PolicyNetwork candidate;
+    std::vector<float> params;
+    std::vector<MatchState> states;
+    std::vector<SimRandom> rngs;
+    std::vector<int> live;       // Bouts still running, in batch order
+    std::vector<uint8_t> observations;
+    std::vector<int> moves;
+    std::vector<int> opponentMoves;
+    std::vector<int> score;      // Touches for minus touches against, per bout
+
+    TrainWorker(const PolicyNetwork& network, const TrainConfig& config)
+        : candidate(network), params(flatten(network)), states(config.bouts), rngs(config.bouts, SimRandom(1)),
+          observations(static_cast<size_t>(config.bouts) * POLICY_INPUTS), moves(config.bouts),
+          opponentMoves(config.bouts), score(config.bouts) {
+        live.reserve(config.bouts);
+    }
+
+    // All bouts of a candidate run in lockstep, so each decision tick is one batched forward pass
+    double play(const TrainConfig& config, uint64_t boutSeed) {
+        for (int b = 0; b < config.bouts; ++b) {
+            initMatch(states[b], static_cast<uint8_t>(b / 2 % WEAPON_COUNT));
+            rngs[b] = SimRandom(seedFor(boutSeed, b));
+            score[b] = 0;
+        }
+
+        for (int t = 0; t < config.maxTicks; ++t) {
+            int tick = t % config.stepTicks;
+            if (tick == 0) {
+                live.clear();
+                for (int b = 0; b < config.bouts; ++b) {
+                    if (!states[b].over) live.push_back(b);
+                }
+                if (live.empty()) break;
+
+                int batch = static_cast<int>(live.size());
+                for (int i = 0; i < batch; ++i) observe(states[live[i]], live[i] % 2, &observations[static_cast<size_t>(i) * POLICY_INPUTS]);
+                candidate.evaluate(observations.data(), batch, moves.data());
+                if (config.opponent) {
+                    for (int i = 0; i < batch; ++i) observe(states[live[i]], 1 - live[i] % 2, &observations[static_cast<size_t>(i) * POLICY_INPUTS]);
+                    config.opponent->evaluate(observations.data(), batch, opponentMoves.data());
+                } else {
+                    for (int i = 0; i < batch; ++i) opponentMoves[i] = rngs[live[i]].below(MOVE_COUNT);
+                }
+            }
+
+            for (size_t i = 0; i < live.size(); ++i) {
+                int b = live[i];
+                if (states[b].over) continue;
+                int side = b % 2;
+                InputWord inputs[2];
+                inputs[side] = moveInput(moves[i], side, tick);
+                inputs[1 - side] = moveInput(opponentMoves[i], 1 - side, tick);
+                uint8_t events = stepMatch(states[b], inputs[0], inputs[1]);
+                if (events & (side == 0 ? EVENT_TOUCH_P1 : EVENT_TOUCH_P2)) score[b]++;
+                if (events & (side == 0 ? EVENT_TOUCH_P2 : EVENT_TOUCH_P1)) score[b]--;
+            }
+        }
+
+        // A won bout is worth more than the touches it took
+        double fitness = 0;
+        for (int b = 0; b < config.bouts; ++b) {
+            int winner = matchWinner(states[b]);
+            fitness += score[b] + (winner == 0 ? 0 : winner == b % 2 + 1 ? SIM_START_POINTS : -SIM_START_POINTS);
+        }
+        return fitness / config.bouts;
+    }
+};
+
+// Antithetic evolution strategies: candidates are pairs theta +/- sigma * noise, the noise regenerated
+// from its seed rather than stored, and theta follows the rank-weighted noise
+int runTrain(int argc, char* argv[]) {
+    std::string weightsPath = stringOption(argc, argv, "--weights", "");
+    std::string outPath = stringOption(argc, argv, "--out", "policy.bin");
+    std::string opponentPath = stringOption(argc, argv, "--opponent", "");
+    std::vector<int> hidden = intListOption(argc, argv, "--hidden", {64, 64});
+    int generations = intOption(argc, argv, "--generations", 20);
+    int population = intOption(argc, argv, "--population", 32);
+    int seed = intOption(argc, argv, "--seed", 1);
+    float sigma = static_cast<float>(intOption(argc, argv, "--sigma", 4));
+    float learningRate = static_cast<float>(intOption(argc, argv, "--rate", 16));
+    int threads = threadOption(argc, argv);
+    TrainConfig config;
+    config.bouts = intOption(argc, argv, "--bouts", config.bouts);
+    config.maxTicks = intOption(argc, argv, "--max-ticks", config.maxTicks);
+
+    if (generations < 1 || population < 2 || population % 2 || config.bouts < 1 || sigma <= 0 || learningRate <= 0) {
+        std::cerr << "train: --population must be even and at least 2; --generations, --bouts, --sigma and --rate must be positive" << std::endl;
+        return 1;
+    }
+
+    PolicyNetwork network;
+    std::string error;
+    if (!weightsPath.empty()) {
+        if (!network.load(weightsPath, error)) {
+            std::cerr << "train: " << weightsPath << ": " << error << std::endl;
+            return 1;
+        }
+    } else {
+        SimRandom rng(static_cast<uint64_t>(seed));
+        network.randomise(hidden, rng);
+    }
+    PolicyNetwork opponent;
+    if (!opponentPath.empty()) {
+        if (!opponent.load(opponentPath, error)) {
+            std::cerr << "train: " << opponentPath << ": " << error << std::endl;
+            return 1;
+        }
+        config.opponent = &opponent;
+    }
+
+    std::vector<float> theta = flatten(network);
+    std::cout << "Training " << theta.size() << " parameters: population " << population << ", " << config.bouts
+              << " bouts each against " << (opponentPath.empty() ? std::string("random moves") : opponentPath) << ", "
+              << threads << " threads" << std::endl;
+
+    std::vector<TrainWorker> workers;
+    workers.reserve(threads);
+    for (int i = 0; i < threads; ++i) workers.emplace_back(network, config);
+    std::vector<double> fitness(population + 1); // The last job scores theta itself
+    std::vector<float> step(theta.size());
+
+    for (int generation = 0; generation < generations; ++generation) {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t generationSeed = seedFor(static_cast<uint64_t>(seed), static_cast<uint64_t>(generation));
+        uint64_t boutSeed = seedFor(generationSeed, 0); // Same opponents for every candidate in a generation
+        std::atomic<int> nextJob{0};
+        std::vector<std::thread> pool;
+        for (int i = 0; i < threads; ++i) {
+            pool.emplace_back([&, i]() {
+                TrainWorker& worker = workers[i];
+                for (int job = nextJob++; job <= population; job = nextJob++) {
+                    if (job < population) {
+                        SimRandom noise(seedFor(generationSeed, 1 + job / 2));
+                        float scale = job % 2 ? -sigma : sigma;
+                        for (size_t p = 0; p < theta.size(); ++p) worker.params[p] = theta[p] + scale * gaussian(noise);
+                    } else {
+                        std::copy(theta.begin(), theta.end(), worker.params.begin());
+                    }
+                    quantise(worker.params.data(), worker.candidate);
+                    fitness[job] = worker.play(config, boutSeed);
+                }
+            });
+        }
+        for (auto& thread : pool) thread.join();
+
+        // Centred ranks in [-0.5, 0.5]: robust to the odd lucky bout
+        std::vector<int> order(population);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return fitness[a] < fitness[b]; });
+        std::vector<float> utility(population);
+        for (int rank = 0; rank < population; ++rank) utility[order[rank]] = static_cast<float>(rank) / (population - 1) - 0.5f;
+
+        std::fill(step.begin(), step.end(), 0.0f);
+        for (int pair = 0; pair < population / 2; ++pair) {
+            float weight = utility[2 * pair] - utility[2 * pair + 1];
+            SimRandom noise(seedFor(generationSeed, 1 + pair));
+            for (float& value : step) value += weight * gaussian(noise);
+        }
+        for (size_t p = 0; p < theta.size(); ++p) theta[p] += learningRate / population * step[p];
+
+        quantise(theta.data(), network);
+        if (!network.save(outPath)) {
+            std::cerr << "train: cannot write " << outPath << std::endl;
+            return 1;
+        }
+
+        double mean = std::accumulate(fitness.begin(), fitness.begin() + population, 0.0) / population;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Generation " << generation + 1 << ": policy " << fitness[population] << ", candidates mean " << mean
+                  << " best " << fitness[order.back()] << " (" << seconds << " s); wrote " << outPath << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include "replay.h"
+#include "fuzz.h"
+#include "lab.h"
+#include <algorithm>
+#include <iostream>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+int runVerify(int argc, char* argv[]) {
+    std::vector<std::string> paths = collectReplays(argc, argv, {"--threads"});
+    int threads = threadOption(argc, argv);
+    if (paths.empty()) {
+        std::cerr << "Usage: FencingLab verify <replay files or directories> [--threads n]" << std::endl;
+        return 1;
+    }
+
+    // Workers take whole files from a shared counter; each writes only its own result slots
+    std::vector<ReplayCheck> checks(paths.size());
+    std::vector<std::string> errors(paths.size());
+    std::vector<uint64_t> workerTicks(threads, 0);
+    std::atomic<size_t> nextFile{0};
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            MappedReplay replay;
+            for (size_t index = nextFile++; index < paths.size(); index = nextFile++) {
+                if (!replay.open(paths[index])) {
+                    errors[index] = replay.error;
+                    continue;
+                }
+                checks[index] = verifyReplay(replay);
+                workerTicks[i] += replay.header->tickCount;
+                replay.close();
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t ticks = 0;
+    for (uint64_t count : workerTicks) ticks += count;
+
+    size_t changed = 0, unreadable = 0;
+    for (size_t index = 0; index < paths.size(); ++index) {
+        const ReplayCheck& check = checks[index];
+        if (!check.valid) {
+            std::cout << paths[index] << ": unreadable, " << errors[index] << std::endl;
+            unreadable++;
+            continue;
+        }
+        if (check.matches) continue;
+
+        changed++;
+        std::cout << paths[index] << ": ";
+        if (check.divergentTick >= 0) {
+            std::cout << "diverges by tick " << check.divergentTick << " (hash " << std::hex << check.expectedHash << " -> "
+                      << check.actualHash << std::dec << ")";
+        } else {
+            std::cout << "every checkpoint matches";
+        }
+
+        // Outcome as recorded and as re-simulated
+        MappedReplay replay;
+        if (replay.open(paths[index])) {
+            const ReplayHeader& header = *replay.header;
+            std::cout << ", points " << static_cast<int>(header.points[0]) << "-" << static_cast<int>(header.points[1])
+                      << (header.over ? " (over)" : "") << " -> " << static_cast<int>(check.points[0]) << "-"
+                      << static_cast<int>(check.points[1]) << (check.over ? " (over)" : "");
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << paths.size() << " replays, " << ticks << " ticks in " << seconds << " s ("
+              << static_cast<uint64_t>(ticks / seconds) << " ticks/s on " << threads << " threads): " << changed
+              << " changed, " << unreadable << " unreadable" << std::endl;
+    return changed + unreadable > 0 ? 2 : 0;
+}
+
+// Writes replays of random-input bouts, to build a test archive without playing the game
+int runRecord(int argc, char* argv[]) {
+    int bouts = intOption(argc, argv, "--bouts", 100);
+    int maxTicks = intOption(argc, argv, "--max-ticks", (SIM_PERIODS + 1) * SIM_PERIOD_TICKS);
+    uint64_t seed = static_cast<uint64_t>(intOption(argc, argv, "--seed", 1));
+    std::string directory = stringOption(argc, argv, "--dir", "replays");
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::cerr << "record: cannot create " << directory << ": " << error.message() << std::endl;
+        return 1;
+    }
+
+    uint64_t ticks = 0;
+    for (int bout = 0; bout < bouts; ++bout) {
+        FuzzCase fuzzCase = generateFuzzCase(seedFor(seed, static_cast<uint64_t>(bout)), static_cast<size_t>(maxTicks));
+        MatchState state;
+        initMatch(state, fuzzCase.weapon);
+        placeFencers(state, fuzzCase.distance);
+
+        std::string path = directory + "/bout_" + std::to_string(bout) + REPLAY_EXTENSION;
+        ReplayHeader header;
+        header.seed = seedFor(seed, static_cast<uint64_t>(bout));
+        ReplayWriter writer;
+        if (!writer.open(path, header, state)) {
+            std::cerr << "record: cannot write " << path << std::endl;
+            return 1;
+        }
+        for (size_t t = 0; t < fuzzCase.ticks() && !state.over; ++t) {
+            stepMatch(state, fuzzCase.inputs[0][t], fuzzCase.inputs[1][t]);
+            writer.record(fuzzCase.inputs[0][t], fuzzCase.inputs[1][t], state);
+        }
+        if (!writer.close()) {
+            std::cerr << "record: cannot write " << path << std::endl;
+            return 1;
+        }
+        ticks += writer.header.tickCount;
+    }
+    std::cout << "Wrote " << bouts << " replays (" << ticks << " ticks) to " << directory << std::endl;
+    return 0;
+}
+
+// Prints the match at a tick of a replay, reached through the keyframe index, and times seeks to
+// random ticks, checking some against a re-simulation from tick 0
+int runSeek(int argc, char* argv[]) {
+    std::vector<std::string> paths = collectReplays(argc, argv, {"--tick", "--seeks"});
+    int tick = intOption(argc, argv, "--tick", 0);
+    int seeks = intOption(argc, argv, "--seeks", 1000);
+    if (paths.size() != 1) {
+        std::cerr << "Usage: FencingLab seek <replay file> [--tick n] [--seeks n]" << std::endl;
+        return 1;
+    }
+    MappedReplay replay;
+    if (!replay.open(paths[0], MAP_ACCESS_RANDOM)) {
+        std::cerr << paths[0] << ": " << replay.error << std::endl;
+        return 1;
+    }
+    const ReplayHeader& header = *replay.header;
+    std::cout << paths[0] << ": " << WEAPON_NAMES[header.weapon] << ", " << header.tickCount << " ticks, "
+              << replay.keyframeCount << " keyframes, " << replay.file.size << " bytes" << std::endl;
+
+    MatchState state;
+    replay.seek(static_cast<uint32_t>(std::max(tick, 0)), state);
+    std::cout << "Tick " << state.tick << ", period " << static_cast<int>(state.period) << ", points "
+              << static_cast<int>(state.points[0]) << "-" << static_cast<int>(state.points[1]) << (state.over ? " (over)" : "")
+              << std::endl;
+    for (int player = 0; player < 2; ++player) {
+        const FencerState& fencer = state.fencers[player];
+        std::cout << "  player " << player + 1 << ": x " << fencer.x << ", velocity " << static_cast<int>(fencer.velocityX) << ", "
+                  << ACTION_NAMES[fencer.action] << " for " << static_cast<int>(fencer.actionTicks) << " ticks" << std::endl;
+    }
+
+    SimRandom rng(1);
+    std::chrono::duration<double, std::micro> total(0);
+    std::vector<double> times; // Microseconds, for the 99th percentile; the worst is often a preempted seek
+    times.reserve(static_cast<size_t>(std::max(seeks, 0)));
+    int wrong = 0;
+    for (int i = 0; i < seeks; ++i) {
+        uint32_t target = static_cast<uint32_t>(rng.next() % (header.tickCount + 1));
+        auto start = std::chrono::steady_clock::now();
+        replay.seek(target, state);
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        total += elapsed;
+        times.push_back(elapsed.count());
+        if (i % 100 != 0) continue;
+
+        MatchState full;
+        replay.startState(full);
+        ReplayReader reader(replay);
+        InputWord player1Input, player2Input;
+        for (uint32_t t = 0; t < target && reader.next(player1Input, player2Input); ++t) stepMatch(full, player1Input, player2Input);
+        if (hashMatchState(full) != hashMatchState(state)) wrong++;
+    }
+    if (seeks > 0) {
+        std::sort(times.begin(), times.end());
+        std::cout << seeks << " random seeks: " << total.count() / seeks << " us on average, 99th percentile "
+                  << times[times.size() * 99 / 100] << " us, worst " << times.back() << " us; "
+                  << wrong << " of " << (seeks + 99) / 100 << " checked differ from a re-simulation from tick 0" << std::endl;
+    }
+    return wrong == 0 ? 0 : 2;
+}